@@ -0,0 +1,67 @@
+#include <zenload/animationCompression.h>
+#include <vdfs/fileIndex.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+
+/**
+ * Reduces the keys of every animation in an archive and reports the memory saved
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cout   << "Usage: anim_compress <vdf-archive> [<rotation-tolerance>] [<position-tolerance>]" << std::endl
+                    << "       <vdf-archive>: Path to the vdf-archive to load, e.g. Anims.vdf" << std::endl
+                    << "       <rotation-tolerance>: Largest rotation error in radians (default: 0.002)" << std::endl
+                    << "       <position-tolerance>: Largest position error (default: 0.05)" << std::endl;
+        return 0;
+    }
+
+    VDFS::FileIndex::initVDFS(argv[0]);
+
+    VDFS::FileIndex vdf;
+    vdf.loadVDF(argv[1]);
+    vdf.finalizeLoad();
+
+    ZenLoad::AnimationCompressionParams params;
+    if(argc > 2)
+        params.rotationTolerance = float(std::atof(argv[2]));
+    if(argc > 3)
+        params.positionTolerance = float(std::atof(argv[3]));
+
+    ZenLoad::AnimationCompressionStats stats;
+    ZenLoad::CompressedAnimation compressed;
+    size_t numFiles = 0;
+    for(const std::string& f : vdf.getKnownFiles())
+    {
+        if(f.size() < 4)
+            continue;
+        std::string ext = f.substr(f.size() - 4);
+        for(char& c : ext)
+            c = char(toupper(c));
+        if(ext != ".MAN")
+            continue;
+
+        // Keep the samples quantized, the key reduction decodes them anyway
+        ZenLoad::zCModelAni ani(f, vdf, 1.0f, true);
+        if(!ani.isValid())
+            continue;
+
+        compressed.build(ani, params, &stats);
+        numFiles++;
+    }
+
+    const size_t expandedBytes = stats.numSamples * sizeof(ZenLoad::zCModelAni::AniSample);
+    std::cout << numFiles << " animations, " << stats.numSamples << " samples" << std::endl
+              << "Expanded:   " << expandedBytes / 1024 << " KiB" << std::endl
+              << "Quantized:  " << stats.sourceBytes / 1024 << " KiB" << std::endl
+              << "Compressed: " << stats.compressedBytes / 1024 << " KiB (" << stats.rotationKeys << " rotation keys, "
+              << stats.positionKeys << " position keys)" << std::endl
+              << "Saved " << (expandedBytes - std::min(expandedBytes, stats.compressedBytes)) / 1024
+              << " KiB against the expanded samples, largest error " << stats.maxRotationError << " rad / "
+              << stats.maxPositionError << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <zenload/triangleBvh.h>
+#include <zenload/zCMesh.h>
+#include <zenload/zenParser.h>
+#include <vdfs/fileIndex.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+template<class F>
+static double measure(F f)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static void report(const char* name, size_t count, double seconds, const std::vector<ZenLoad::BvhHit>& hits)
+{
+    size_t numHits = 0;
+    for(const ZenLoad::BvhHit& h : hits)
+        numHits += h.isHit() ? 1 : 0;
+
+    std::cout << name << ": " << count / seconds << " rays/s (" << numHits << "/" << count << " hit)" << std::endl;
+}
+
+/**
+ * Builds a BVH over the world mesh of the given zen and reports build time and query throughput
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 3)
+    {
+        std::cout   << "Usage: bvh_raycast <vdf-archive> <zen-name> [<threads>] [<rays>]" << std::endl
+                    << "       <vdf-archive>: Path to the vdf-archive to load" << std::endl
+                    << "       <zen-name>: Gothic 2 world to load, e.g. NEWWORLD.ZEN" << std::endl
+                    << "       <threads>: Threads to build the BVH on (default: 1)" << std::endl
+                    << "       <rays>: Rays per query type (default: 1000000)" << std::endl;
+        return 0;
+    }
+
+    const size_t numThreads = argc > 3 ? size_t(std::stoul(argv[3])) : 1;
+    const size_t numRays    = argc > 4 ? size_t(std::stoul(argv[4])) : 1000000;
+
+    VDFS::FileIndex::initVDFS(argv[0]);
+
+    VDFS::FileIndex vdf;
+    vdf.loadVDF(argv[1]);
+    vdf.finalizeLoad();
+
+    ZenLoad::ZenParser parser(argv[2], vdf);
+    if(parser.getFileSize() == 0)
+    {
+        std::cout << "Error: ZEN-File either not found or empty!" << std::endl;
+        return 0;
+    }
+
+    parser.readHeader();
+    ZenLoad::oCWorldData world;
+    parser.readWorld(world, ZenLoad::ZenParser::FileVersion::Gothic2);
+
+    ZenLoad::zCMesh* mesh = parser.getWorldMesh();
+    ZenLoad::TriangleBvh bvh;
+    const double buildTime = measure([&]() { bvh.build(*mesh, numThreads); });
+    std::cout << "Built BVH over " << bvh.triangleCount() << " triangles, " << bvh.nodeCount() << " nodes in "
+              << buildTime * 1000.0 << " ms (" << numThreads << " threads)" << std::endl;
+
+    ZMath::float3 bmin, bmax;
+    bvh.getBoundingBox(bmin, bmax);
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> x(bmin.x, bmax.x), y(bmin.y, bmax.y), z(bmin.z, bmax.z);
+    std::vector<ZenLoad::BvhHit> hits(numRays);
+
+    // Ground snapping: straight down from above the world
+    std::vector<ZenLoad::BvhRay> rays(numRays);
+    for(ZenLoad::BvhRay& r : rays)
+    {
+        r.origin    = ZMath::float3(x(rng), bmax.y + 1.f, z(rng));
+        r.direction = ZMath::float3(0, -1, 0);
+        r.tMax      = bmax.y - bmin.y + 2.f;
+    }
+    report("Ground snap", numRays, measure([&]() { bvh.intersect(rays.data(), hits.data(), numRays); }), hits);
+
+    // Line of sight: segments between random points
+    std::vector<ZMath::float3> from(numRays), to(numRays);
+    for(size_t i = 0; i < numRays; i++)
+    {
+        from[i] = ZMath::float3(x(rng), y(rng), z(rng));
+        to[i]   = ZMath::float3(from[i].x + (x(rng) - bmin.x) * 0.05f, from[i].y, from[i].z + (z(rng) - bmin.z) * 0.05f);
+    }
+    report("Segments", numRays, measure([&]() { bvh.intersectSegments(from.data(), to.data(), hits.data(), numRays); }), hits);
+
+    for(size_t i = 0; i < numRays; i++)
+    {
+        rays[i].origin    = from[i];
+        rays[i].direction = ZMath::float3(to[i].x - from[i].x, to[i].y - from[i].y, to[i].z - from[i].z);
+        rays[i].tMax      = 1.f;
+    }
+    std::vector<uint8_t> blocked(numRays);
+    const double occlusionTime = measure([&]() { bvh.occluded(rays.data(), blocked.data(), numRays); });
+    std::cout << "Line of sight: " << numRays / occlusionTime << " rays/s" << std::endl;
+
+    // Projectiles: 30cm spheres over 10m
+    for(ZenLoad::BvhRay& r : rays)
+    {
+        const float l = std::sqrt(r.direction.x * r.direction.x + r.direction.z * r.direction.z);
+        if(l > 0.f)
+            r.direction = ZMath::float3(r.direction.x / l * 1000.f, 0, r.direction.z / l * 1000.f);
+    }
+    report("Sphere sweep", numRays, measure([&]() { bvh.sweepSphere(rays.data(), 30.f, hits.data(), numRays); }), hits);
+
+    return 0;
+}
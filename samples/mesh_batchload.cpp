@@ -0,0 +1,73 @@
+#include <zenload/meshBatchLoader.h>
+#include <vdfs/fileIndex.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+
+/**
+ * Loads all .MRM/.MSH-files of an archive with the batch loader, once per thread count, and reports the scaling
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cout   << "Usage: mesh_batchload <vdf-archive> [<max-threads>]" << std::endl
+                    << "       <vdf-archive>: Path to the vdf-archive to load" << std::endl
+                    << "       <max-threads>: Highest number of worker threads to try. Defaults to 4" << std::endl;
+        return 0;
+    }
+
+    VDFS::FileIndex::initVDFS(argv[0]);
+
+    VDFS::FileIndex vdf;
+    vdf.loadVDF(argv[1]);
+    vdf.finalizeLoad();
+
+    const size_t maxThreads = argc > 2 ? size_t(std::max(1, std::atoi(argv[2]))) : 4;
+
+    std::vector<std::string> names;
+    for(const std::string& f : vdf.getKnownFiles())
+    {
+        if(f.size() < 4)
+            continue;
+        std::string ext = f.substr(f.size() - 4);
+        for(char& c : ext)
+            c = char(toupper(c));
+        if(ext == ".MRM" || ext == ".MSH")
+            names.push_back(f);
+    }
+
+    ZenLoad::MeshBatchLoader loader(vdf);
+    std::vector<ZenLoad::MeshBatchLoader::Handle> handles;
+    double singleThreadMs = 0;
+    for(size_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        // Releasing keeps the buffers, so every run after the first reuses them
+        loader.clear();
+        ZenLoad::MeshBatchStats stats = loader.load(names, handles, threads);
+        if(threads == 1)
+            singleThreadMs = stats.wallMs;
+
+        std::cout << threads << " thread(s): " << stats.loaded << " loaded, " << stats.failed << " failed, "
+                  << stats.wallMs << " ms wall, " << stats.busyMs << " ms busy, speedup "
+                  << singleThreadMs / stats.wallMs << std::endl;
+    }
+
+    // Slowest files of the last run
+    std::vector<std::pair<double, size_t>> slowest;
+    for(size_t i = 0; i < handles.size(); i++)
+    {
+        if(const ZenLoad::MeshLoadTiming* t = loader.timing(handles[i]))
+            slowest.emplace_back(t->readMs + t->parseMs + t->packMs, i);
+    }
+    std::sort(slowest.rbegin(), slowest.rend());
+    for(size_t i = 0; i < slowest.size() && i < 10; i++)
+    {
+        const ZenLoad::MeshLoadTiming* t = loader.timing(handles[slowest[i].second]);
+        std::cout << names[slowest[i].second] << ": read " << t->readMs << " ms, parse " << t->parseMs
+                  << " ms, pack " << t->packMs << " ms, " << t->fileSize << " bytes" << std::endl;
+    }
+
+    return 0;
+}
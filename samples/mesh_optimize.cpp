@@ -0,0 +1,65 @@
+#include <zenload/meshOptimizer.h>
+#include <zenload/zCProgMeshProto.h>
+#include <vdfs/fileIndex.h>
+#include <chrono>
+#include <iostream>
+
+/**
+ * Runs the vertex cache optimizer over the given meshes and reports ACMR before/after
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cout   << "Usage: mesh_optimize <vdf-archive> [<mesh-name>...]" << std::endl
+                    << "       <vdf-archive>: Path to the vdf-archive to load" << std::endl
+                    << "       <mesh-name>: .MRM-files to optimize. Uses all .MRM-files in the archive if omitted" << std::endl;
+        return 0;
+    }
+
+    VDFS::FileIndex::initVDFS(argv[0]);
+
+    VDFS::FileIndex vdf;
+    vdf.loadVDF(argv[1]);
+    vdf.finalizeLoad();
+
+    std::vector<std::string> names(argv + 2, argv + argc);
+    if(names.empty())
+    {
+        for(const std::string& f : vdf.getKnownFiles())
+            if(f.size() > 4 && (f.compare(f.size() - 4, 4, ".MRM") == 0 || f.compare(f.size() - 4, 4, ".mrm") == 0))
+                names.push_back(f);
+    }
+
+    size_t totalTris = 0;
+    double missesBefore = 0, missesAfter = 0, totalTime = 0;
+    for(const std::string& n : names)
+    {
+        ZenLoad::zCProgMeshProto mesh(n, vdf);
+        ZenLoad::PackedMesh packed;
+        mesh.packMesh(packed);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        ZenLoad::MeshOptimizeStats stats = ZenLoad::optimizePackedMesh(packed);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        const size_t tris = packed.indices.size() / 3;
+        const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        std::cout << n << ": " << tris << " triangles, ACMR " << stats.acmrBefore << " -> " << stats.acmrAfter
+                  << " (" << ms << " ms)" << std::endl;
+
+        totalTris += tris;
+        missesBefore += stats.acmrBefore * tris;
+        missesAfter  += stats.acmrAfter * tris;
+        totalTime    += ms;
+    }
+
+    if(totalTris > 0)
+    {
+        std::cout << "Total: " << names.size() << " meshes, " << totalTris << " triangles, ACMR "
+                  << missesBefore / totalTris << " -> " << missesAfter / totalTris
+                  << ", " << totalTime << " ms (" << (totalTris / totalTime) * 1000.0 << " triangles/s)" << std::endl;
+    }
+
+    return 0;
+}
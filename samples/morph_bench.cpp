@@ -0,0 +1,90 @@
+#include <zenload/morphBlending.h>
+#include <zenload/zCMorphMesh.h>
+#include <vdfs/fileIndex.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+/**
+ * Applies morph animations to many heads at once and reports the throughput
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 3)
+    {
+        std::cout   << "Usage: morph_bench <vdf-archive> <morph-mesh> [<heads>] [<layers>] [<threads>]" << std::endl
+                    << "       <vdf-archive>: Path to the vdf-archive to load" << std::endl
+                    << "       <morph-mesh>: Morph mesh to load, e.g. HUM_HEAD_PONY.MMB" << std::endl
+                    << "       <heads>: Number of heads to morph per run (default: 64)" << std::endl
+                    << "       <layers>: Animations playing on every head at once (default: 3)" << std::endl
+                    << "       <threads>: Threads to split the heads over (default: 1)" << std::endl;
+        return 0;
+    }
+
+    VDFS::FileIndex::initVDFS(argv[0]);
+
+    VDFS::FileIndex vdf;
+    vdf.loadVDF(argv[1]);
+    vdf.finalizeLoad();
+
+    const std::string file       = argv[2];
+    const size_t      numHeads   = argc > 3 ? size_t(std::max(1, std::atoi(argv[3]))) : 64;
+    const size_t      numLayers  = argc > 4 ? size_t(std::max(1, std::atoi(argv[4]))) : 3;
+    const size_t      numThreads = argc > 5 ? size_t(std::max(1, std::atoi(argv[5]))) : 1;
+
+    ZenLoad::zCMorphMesh mesh(file, vdf);
+    const std::vector<ZMath::float3>& rest = mesh.getMorphPositions();
+    if(rest.empty() || mesh.aniList.empty())
+    {
+        std::cout << "Error: Morph mesh has no vertices or no animations!" << std::endl;
+        return 0;
+    }
+
+    // Every head plays a few random animations at random frames and weights
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    std::vector<ZenLoad::MorphLayer> layers(numHeads * numLayers);
+    size_t samplesPerBatch = 0;
+    for(size_t i = 0; i < layers.size(); i++)
+    {
+        const ZenLoad::zCMorphMesh::Animation& a = mesh.aniList[rng() % mesh.aniList.size()];
+        layers[i].animation = &a;
+        layers[i].frame     = unit(rng) * float(a.numFrames);
+        layers[i].weight    = unit(rng);
+        samplesPerBatch += a.vertexIndex.size();
+    }
+
+    std::vector<ZMath::float3> positions(rest.size() * numHeads);
+    std::vector<ZenLoad::MorphInstance> heads(numHeads);
+    for(size_t i = 0; i < numHeads; i++)
+    {
+        heads[i].layers    = &layers[i * numLayers];
+        heads[i].numLayers = numLayers;
+        heads[i].positions = &positions[i * rest.size()];
+    }
+
+    std::cout << file << ": " << rest.size() << " vertices, " << mesh.aniList.size() << " animations, "
+              << numHeads << " heads, " << numLayers << " layer(s), " << numThreads << " thread(s)" << std::endl;
+
+    // Warm up once, then take the best of a few runs. Resetting to the rest pose is not timed.
+    double best = 0;
+    for(int run = 0; run < 6; run++)
+    {
+        for(size_t i = 0; i < numHeads; i++)
+            std::copy(rest.begin(), rest.end(), heads[i].positions);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        ZenLoad::applyMorphs(heads.data(), heads.size(), numThreads);
+        auto end = std::chrono::high_resolution_clock::now();
+        const double s = std::chrono::duration<double>(end - start).count();
+        if(run == 1 || (run > 1 && s < best))
+            best = s;
+    }
+
+    std::cout << double(samplesPerBatch) / best / 1e6 << " M morphed vertices/s ("
+              << best * 1000.0 << " ms per batch)" << std::endl;
+
+    return 0;
+}
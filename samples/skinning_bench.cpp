@@ -0,0 +1,109 @@
+#include <zenload/skinning.h>
+#include <zenload/zCModelMeshLib.h>
+#include <vdfs/fileIndex.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+/**
+ * Skins the mesh of a model for many instances at once and reports the throughput
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 3)
+    {
+        std::cout   << "Usage: skinning_bench <vdf-archive> <model> [<instances>] [<threads>]" << std::endl
+                    << "       <vdf-archive>: Path to the vdf-archive to load" << std::endl
+                    << "       <model>: Model without extension, e.g. HUMANS. Loads <model>.MDL or <model>.MDH/.MDM" << std::endl
+                    << "       <instances>: Number of posed instances to skin per run (default: 64)" << std::endl
+                    << "       <threads>: Threads to split the instances over (default: 1)" << std::endl;
+        return 0;
+    }
+
+    VDFS::FileIndex::initVDFS(argv[0]);
+
+    VDFS::FileIndex vdf;
+    vdf.loadVDF(argv[1]);
+    vdf.finalizeLoad();
+
+    const std::string model        = argv[2];
+    const size_t      numInstances = argc > 3 ? size_t(std::max(1, std::atoi(argv[3]))) : 64;
+    const size_t      numThreads   = argc > 4 ? size_t(std::max(1, std::atoi(argv[4]))) : 1;
+
+    ZenLoad::PackedSkeletalMesh mesh;
+    ZenLoad::zCModelMeshLib     hierarchy;
+    if(vdf.hasFile(model + ".MDL"))
+    {
+        hierarchy = ZenLoad::zCModelMeshLib(model + ".MDL", vdf);
+        hierarchy.packMesh(mesh);
+    }
+    else
+    {
+        hierarchy = ZenLoad::zCModelMeshLib(model + ".MDH", vdf);
+        ZenLoad::zCModelMeshLib(model + ".MDM", vdf).packMesh(mesh);
+    }
+
+    if(hierarchy.getNodes().empty() || mesh.vertices.empty())
+    {
+        std::cout << "Error: Model has no hierarchy or no soft-skin mesh!" << std::endl;
+        return 0;
+    }
+
+    ZenLoad::MeshSkinning skinning(hierarchy);
+    const size_t numNodes    = skinning.nodeCount();
+    const size_t numVertices = mesh.vertices.size();
+
+    // Every instance gets its own pose: the bind pose with the nodes slightly moved
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> jitter(-2.f, 2.f);
+    std::vector<ZMath::Matrix> local(numNodes), poses(numNodes * numInstances);
+    for(size_t i = 0; i < numInstances; i++)
+    {
+        for(size_t n = 0; n < numNodes; n++)
+        {
+            local[n] = hierarchy.getNodes()[n].transformLocal;
+            local[n]._41 += jitter(rng);
+            local[n]._42 += jitter(rng);
+            local[n]._43 += jitter(rng);
+        }
+        skinning.computeNodeTransforms(local.data(), &poses[i * numNodes]);
+    }
+
+    std::vector<ZMath::float3> positions(numVertices * numInstances), normals(numVertices * numInstances);
+    std::vector<ZenLoad::SkinningInstance> instances(numInstances);
+    for(size_t i = 0; i < numInstances; i++)
+    {
+        instances[i].nodeTransforms = &poses[i * numNodes];
+        instances[i].positions      = &positions[i * numVertices];
+        instances[i].normals        = &normals[i * numVertices];
+    }
+
+    std::cout << model << ": " << numVertices << " vertices, " << numNodes << " nodes, " << numInstances
+              << " instances, " << numThreads << " thread(s)" << std::endl;
+
+    for(int withNormals = 1; withNormals >= 0; withNormals--)
+    {
+        for(ZenLoad::SkinningInstance& si : instances)
+            si.normals = withNormals ? &normals[(&si - instances.data()) * numVertices] : nullptr;
+
+        // Warm up once, then take the best of a few runs
+        skinning.skin(mesh, instances.data(), instances.size(), numThreads);
+        double best = 0;
+        for(int run = 0; run < 5; run++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            skinning.skin(mesh, instances.data(), instances.size(), numThreads);
+            auto end = std::chrono::high_resolution_clock::now();
+            const double s = std::chrono::duration<double>(end - start).count();
+            if(run == 0 || s < best)
+                best = s;
+        }
+
+        std::cout << (withNormals ? "Positions and normals: " : "Positions only: ")
+                  << double(numVertices * numInstances) / best / 1e6 << " M vertices/s ("
+                  << best * 1000.0 << " ms per batch)" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <zenload/ztexDecoder.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+using namespace ZenLoad;
+
+static const char* formatName(uint32_t format)
+{
+    static const char* names[ZTEXFMT_COUNT] = {
+        "B8G8R8A8", "R8G8B8A8", "A8B8G8R8", "A8R8G8B8", "B8G8R8", "R8G8B8", "A4R4G4B4", "A1R5G5B5",
+        "R5G6B5", "P8", "DXT1", "DXT2", "DXT3", "DXT4", "DXT5"};
+    return names[format];
+}
+
+static size_t bytesPerTexture(uint32_t format, size_t width, size_t height)
+{
+    switch(format)
+    {
+        case ZTEXFMT_B8G8R8:
+        case ZTEXFMT_R8G8B8:
+            return width * height * 3;
+        case ZTEXFMT_A4R4G4B4:
+        case ZTEXFMT_A1R5G5B5:
+        case ZTEXFMT_R5G6B5:
+            return width * height * 2;
+        case ZTEXFMT_P8:
+            return width * height + ZTEX_PAL_ENTRIES * 4;
+        case ZTEXFMT_DXT1:
+            return (width / 4) * (height / 4) * 8;
+        case ZTEXFMT_DXT2:
+        case ZTEXFMT_DXT3:
+        case ZTEXFMT_DXT4:
+        case ZTEXFMT_DXT5:
+            return (width / 4) * (height / 4) * 16;
+        default:
+            return width * height * 4;
+    }
+}
+
+/**
+ * Decodes random textures of every ZTEX-format to RGBA8 and reports the throughput per format
+ */
+int main(int argc, char** argv)
+{
+    if(argc > 1 && (std::strcmp(argv[1], "-h") == 0 || std::strcmp(argv[1], "--help") == 0))
+    {
+        std::cout   << "Usage: ztex_bench [<width>] [<height>]" << std::endl
+                    << "       <width>, <height>: Size of the decoded textures, rounded up to 4 (default: 1024)" << std::endl;
+        return 0;
+    }
+
+    const size_t width  = argc > 1 ? (size_t(std::max(1, std::atoi(argv[1]))) + 3) & ~size_t(3) : 1024;
+    const size_t height = argc > 2 ? (size_t(std::max(1, std::atoi(argv[2]))) + 3) & ~size_t(3) : 1024;
+
+    std::mt19937 rng(1);
+    std::vector<uint8_t> rgba;
+    for(uint32_t format = 0; format < ZTEXFMT_COUNT; format++)
+    {
+        // A single mip level with random contents, random data is valid for all formats
+        ZTEX_FILE_HEADER header = {};
+        header.Signature         = ZTEX_FILE_SIGNATURE;
+        header.Version           = ZTEX_FILE_VERSION_0;
+        header.TexInfo.Format    = format;
+        header.TexInfo.Width     = uint32_t(width);
+        header.TexInfo.Height    = uint32_t(height);
+        header.TexInfo.MipMaps   = 1;
+        header.TexInfo.RefWidth  = uint32_t(width);
+        header.TexInfo.RefHeight = uint32_t(height);
+
+        std::vector<uint8_t> file(sizeof(header) + bytesPerTexture(format, width, height));
+        std::memcpy(file.data(), &header, sizeof(header));
+        for(size_t i = sizeof(header); i < file.size(); i++)
+            file[i] = uint8_t(rng());
+
+        ZTexView view;
+        if(!parseZTEX(file.data(), file.size(), view))
+        {
+            std::cout << "Error: Failed to parse generated " << formatName(format) << "-texture!" << std::endl;
+            return 0;
+        }
+
+        // Warm up once, then take the best of a few runs
+        double best = 0;
+        for(int run = 0; run < 6; run++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            decodeZTEX(view, 0, rgba);
+            auto end = std::chrono::high_resolution_clock::now();
+            const double s = std::chrono::duration<double>(end - start).count();
+            if(run == 1 || (run > 1 && s < best))
+                best = s;
+        }
+
+        std::cout << formatName(format) << ": " << double(width * height) / best / 1e6 << " MPix/s ("
+                  << best * 1000.0 << " ms for " << width << "x" << height << ")" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <cmath>
+#include <random>
+#include <gtest/gtest.h>
+
+#include <zenload/triangleBvh.h>
+
+struct Soup {
+  std::vector<ZMath::float3> positions;
+  std::vector<uint32_t>      indices;
+  std::vector<int16_t>       materials;
+  };
+
+// Random small triangles scattered in a 100^3 box
+static Soup makeSoup(size_t numTris, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> pos(0.f,100.f), off(-3.f,3.f);
+  Soup s;
+  for(size_t t=0; t<numTris; ++t) {
+    const ZMath::float3 c(pos(rng),pos(rng),pos(rng));
+    for(int k=0; k<3; ++k) {
+      s.indices.push_back(uint32_t(s.positions.size()));
+      s.positions.emplace_back(c.x+off(rng),c.y+off(rng),c.z+off(rng));
+      }
+    s.materials.push_back(int16_t(t%7));
+    }
+  return s;
+  }
+
+static float bruteForce(const Soup& s, const ZenLoad::BvhRay& r, uint32_t& tri) {
+  float best = r.tMax;
+  tri = ZenLoad::BvhHit::NO_HIT;
+  for(size_t t=0; t<s.indices.size()/3; ++t) {
+    const ZMath::float3& a = s.positions[s.indices[t*3+0]];
+    const ZMath::float3& b = s.positions[s.indices[t*3+1]];
+    const ZMath::float3& c = s.positions[s.indices[t*3+2]];
+    const double e1[3] = {b.x-a.x,b.y-a.y,b.z-a.z}, e2[3] = {c.x-a.x,c.y-a.y,c.z-a.z};
+    const double d[3]  = {r.direction.x,r.direction.y,r.direction.z};
+    const double p[3]  = {d[1]*e2[2]-d[2]*e2[1],d[2]*e2[0]-d[0]*e2[2],d[0]*e2[1]-d[1]*e2[0]};
+    const double det   = e1[0]*p[0]+e1[1]*p[1]+e1[2]*p[2];
+    if(det==0)
+      continue;
+    const double o[3]  = {r.origin.x-a.x,r.origin.y-a.y,r.origin.z-a.z};
+    const double u     = (o[0]*p[0]+o[1]*p[1]+o[2]*p[2])/det;
+    const double q[3]  = {o[1]*e1[2]-o[2]*e1[1],o[2]*e1[0]-o[0]*e1[2],o[0]*e1[1]-o[1]*e1[0]};
+    const double v     = (d[0]*q[0]+d[1]*q[1]+d[2]*q[2])/det;
+    const double tt    = (e2[0]*q[0]+e2[1]*q[1]+e2[2]*q[2])/det;
+    if(u>=0 && v>=0 && u+v<=1 && tt>=0 && tt<best) {
+      best = float(tt);
+      tri  = uint32_t(t);
+      }
+    }
+  return best;
+  }
+
+TEST(TriangleBvh, MatchesBruteForce) {
+  const Soup s = makeSoup(3000,1);
+  for(size_t threads : {size_t(1),size_t(4)}) {
+    ZenLoad::TriangleBvh bvh;
+    bvh.build(s.positions.data(),s.indices.data(),s.indices.size()/3,s.materials.data(),threads);
+    EXPECT_EQ(bvh.triangleCount(),3000u);
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> pos(-10.f,110.f), dir(-1.f,1.f);
+    std::vector<ZenLoad::BvhRay> rays(500);
+    for(auto& r:rays) {
+      r.origin    = ZMath::float3(pos(rng),pos(rng),pos(rng));
+      r.direction = ZMath::float3(dir(rng),dir(rng),dir(rng));
+      r.tMax      = 200.f;
+      }
+    std::vector<ZenLoad::BvhHit> hits(rays.size());
+    std::vector<uint8_t>         blocked(rays.size());
+    bvh.intersect(rays.data(),hits.data(),rays.size());
+    bvh.occluded(rays.data(),blocked.data(),rays.size());
+
+    size_t numHits = 0;
+    for(size_t i=0; i<rays.size(); ++i) {
+      uint32_t  tri;
+      const float t = bruteForce(s,rays[i],tri);
+      ASSERT_EQ(hits[i].isHit(),tri!=ZenLoad::BvhHit::NO_HIT);
+      EXPECT_EQ(blocked[i]!=0,hits[i].isHit());
+      if(!hits[i].isHit())
+        continue;
+      numHits++;
+      EXPECT_NEAR(hits[i].t,t,1e-3f);
+      EXPECT_EQ(hits[i].material,s.materials[hits[i].triangle]);
+      }
+    EXPECT_GT(numHits,50u);
+    }
+  }
+
+TEST(TriangleBvh, Segments) {
+  // Two triangles forming the ground quad [0,10]^2 at y=0
+  const std::vector<ZMath::float3> pos = {{0,0,0},{10,0,0},{0,0,10},{10,0,10}};
+  const std::vector<uint32_t>      idx = {0,2,1,1,2,3};
+  ZenLoad::TriangleBvh bvh;
+  bvh.build(pos.data(),idx.data(),2,nullptr);
+
+  const ZMath::float3 from[] = {{2,5,2},{8,5,8},{2,5,2},{20,5,2}};
+  const ZMath::float3 to[]   = {{2,-5,2},{8,-5,8},{2,1,2},{20,-5,2}};
+  ZenLoad::BvhHit hits[4];
+  bvh.intersectSegments(from,to,hits,4);
+  ASSERT_TRUE(hits[0].isHit());
+  EXPECT_FLOAT_EQ(hits[0].t,0.5f);
+  EXPECT_EQ(hits[0].triangle,0u);
+  EXPECT_EQ(hits[0].material,-1);
+  ASSERT_TRUE(hits[1].isHit());
+  EXPECT_EQ(hits[1].triangle,1u);
+  EXPECT_FALSE(hits[2].isHit());
+  EXPECT_FALSE(hits[3].isHit());
+  }
+
+TEST(TriangleBvh, SphereSweep) {
+  const std::vector<ZMath::float3> pos = {{0,0,0},{10,0,0},{0,0,10}};
+  const std::vector<uint32_t>      idx = {0,2,1};
+  ZenLoad::TriangleBvh bvh;
+  bvh.build(pos.data(),idx.data(),1,nullptr);
+
+  ZenLoad::BvhRay rays[4];
+  // Falling onto the face
+  rays[0].origin = ZMath::float3(2,10,2);   rays[0].direction = ZMath::float3(0,-1,0);
+  // Moving sideways into the edge x=0
+  rays[1].origin = ZMath::float3(-10,0,5);  rays[1].direction = ZMath::float3(1,0,0);
+  // Moving into the corner at (10,0,0) along the x-axis
+  rays[2].origin = ZMath::float3(20,0,0);   rays[2].direction = ZMath::float3(-1,0,0);
+  // Passing above
+  rays[3].origin = ZMath::float3(-10,2,5);  rays[3].direction = ZMath::float3(1,0,0);
+
+  ZenLoad::BvhHit hits[4];
+  bvh.sweepSphere(rays,1.f,hits,4);
+  ASSERT_TRUE(hits[0].isHit());
+  EXPECT_NEAR(hits[0].t,9.f,1e-4f);
+  ASSERT_TRUE(hits[1].isHit());
+  EXPECT_NEAR(hits[1].t,9.f,1e-4f);
+  ASSERT_TRUE(hits[2].isHit());
+  EXPECT_NEAR(hits[2].t,9.f,1e-4f);
+  EXPECT_FALSE(hits[3].isHit());
+  }
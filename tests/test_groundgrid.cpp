@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include <zenload/groundHeightGrid.h>
+
+// A large world clamps the grid spacing, the baked grid must still load again
+TEST(GroundHeightGrid, SaveLoadAtSizeLimit) {
+  for(float length:{204800.f, 1000000.f, 1234567.f, 4095.f*4096.f}) {
+    // Long thin strip along x, two triangles
+    const ZMath::float3 positions[4] = {
+      ZMath::float3(-length*0.5f,10,0), ZMath::float3(length*0.5f,10,0),
+      ZMath::float3(-length*0.5f,10,100), ZMath::float3(length*0.5f,10,100),
+      };
+    const uint32_t indices[6] = {0,2,1, 1,2,3};
+
+    ZenLoad::GroundHeightGrid grid;
+    grid.build(positions,indices,2,nullptr);
+    EXPECT_GT(grid.spacing(),50.f);
+    EXPECT_LE(grid.pointsX(),4096u);
+
+    std::vector<uint8_t> data;
+    grid.save(data);
+
+    ZenLoad::GroundHeightGrid loaded;
+    ASSERT_TRUE(loaded.load(data.data(),data.size())) << "length " << length;
+    EXPECT_EQ(loaded.pointsX(),grid.pointsX());
+    EXPECT_EQ(loaded.pointsZ(),grid.pointsZ());
+    EXPECT_EQ(loaded.layerCount(),grid.layerCount());
+
+    ZenLoad::GroundHeightGrid::Sample s;
+    ASSERT_TRUE(loaded.sample(ZMath::float3(length*0.25f,50,50),s));
+    EXPECT_FLOAT_EQ(s.height,10.f);
+    }
+  }
@@ -1,7 +1,9 @@
+#include <cstring>
 #include <iostream>
 #include <vdfs/fileIndex.h>
 #include <gtest/gtest.h>
 
+#include <zenload/modelScriptCompiler.h>
 #include <zenload/modelScriptParser.h>
 #include <zenload/zenParser.h>
 
@@ -26,3 +28,149 @@ TEST(MDS, ModelScriptTxt) {
       break;
     }
   }
+
+static const char* roundTripScript = R"(
+Model ("HuS")
+{
+  meshAndTree ("Hum_Body_Naked0.asc" DONT_USE_MESH)
+  registerMesh ("Hum_Body_Naked0.asc")
+
+  aniEnum
+  {
+    ani ("s_Run" 1 "s_Run" 0.1 0.2 M. "Hum_RunLoop_M01.asc" F 1 24 FPS:25 0.5 1.25)
+    {
+      *eventSFX (5 "Run_Step" R:2500 1)
+      *eventSFXGrnd (12 "Run" R:1000)
+      *eventPFX (3 1 "FIRE_SMOKE" "BIP01 R HAND" 1)
+      *eventPFXStop (20 1)
+      *eventTag (4 "DEF_CREATE_ITEM" "ZS_LEFTHAND" "ItMw_1H_Sword")
+      *eventTag (6 "DEF_OPT_FRAME" "5 8 12")
+      *eventTag (7 "DEF_FIGHTMODE" "2H")
+      *eventTag (8 "DEF_SWAPMESH" "Hum_Head" "Hum_Head_Bald")
+      *eventTag (9 "DEF_NOT_A_TAG" "dropped")
+      *eventMMStartAni (0 "T_HURT" "HEAD")
+    }
+    aniAlias ("t_Run_2_Walk" 2 "s_Walk" 0.3 0.4 MR "t_Walk_2_Run" R)
+    aniComb ("t_Look" 9 "t_Look" 0.3 0.3 M. "s_Look" 9)
+    aniDisable ("s_Sneak")
+  }
+}
+)";
+
+TEST(MDS, ModelScriptCompileRoundTrip) {
+  std::vector<uint8_t> msb;
+  ASSERT_TRUE(ZenLoad::compileModelScript(reinterpret_cast<const uint8_t*>(roundTripScript),std::strlen(roundTripScript),msb));
+
+  ZenLoad::ZenParser    txtFile(reinterpret_cast<const uint8_t*>(roundTripScript),std::strlen(roundTripScript));
+  ZenLoad::ZenParser    binFile(msb.data(),msb.size());
+  ZenLoad::MdsParserTxt txt(txtFile);
+  ZenLoad::MdsParserBin bin(binFile);
+
+  size_t numChunks = 0;
+  while(true) {
+    // Tags the parser doesn't know are dropped by the compiler
+    ZenLoad::MdsParser::Chunk c = ZenLoad::MdsParser::CHUNK_EOF;
+    do {
+      const size_t numTags = txt.eventTag.size();
+      c = txt.parse();
+      if(c!=ZenLoad::MdsParser::CHUNK_EVENT_TAG || txt.eventTag.size()!=numTags)
+        break;
+      } while(true);
+
+    ASSERT_EQ(bin.parse(),c) << "chunk " << numChunks;
+    if(c==ZenLoad::MdsParser::CHUNK_EOF)
+      break;
+    numChunks++;
+
+    switch(c) {
+      case ZenLoad::MdsParser::CHUNK_MESH_AND_TREE:
+        EXPECT_EQ(bin.meshAndThree.m_Name,     txt.meshAndThree.m_Name);
+        EXPECT_EQ(bin.meshAndThree.m_Disabled, txt.meshAndThree.m_Disabled);
+        break;
+      case ZenLoad::MdsParser::CHUNK_REGISTER_MESH:
+        EXPECT_EQ(bin.meshesASC, txt.meshesASC);
+        break;
+      case ZenLoad::MdsParser::CHUNK_ANI:
+        EXPECT_EQ(bin.ani.m_Name,        txt.ani.m_Name);
+        EXPECT_EQ(bin.ani.m_Layer,       txt.ani.m_Layer);
+        EXPECT_EQ(bin.ani.m_Next,        txt.ani.m_Next);
+        EXPECT_EQ(bin.ani.m_BlendIn,     txt.ani.m_BlendIn);
+        EXPECT_EQ(bin.ani.m_BlendOut,    txt.ani.m_BlendOut);
+        EXPECT_EQ(bin.ani.m_Flags,       txt.ani.m_Flags);
+        EXPECT_EQ(bin.ani.m_Asc,         txt.ani.m_Asc);
+        EXPECT_EQ(bin.ani.m_Dir,         txt.ani.m_Dir);
+        EXPECT_EQ(bin.ani.m_FirstFrame,  txt.ani.m_FirstFrame);
+        EXPECT_EQ(bin.ani.m_LastFrame,   txt.ani.m_LastFrame);
+        EXPECT_EQ(bin.ani.m_MaxFps,      txt.ani.m_MaxFps);
+        EXPECT_EQ(bin.ani.m_Speed,       txt.ani.m_Speed);
+        EXPECT_EQ(bin.ani.m_ColVolScale, txt.ani.m_ColVolScale);
+        break;
+      case ZenLoad::MdsParser::CHUNK_ANI_ALIAS:
+        EXPECT_EQ(bin.alias.m_Name,     txt.alias.m_Name);
+        EXPECT_EQ(bin.alias.m_Layer,    txt.alias.m_Layer);
+        EXPECT_EQ(bin.alias.m_Next,     txt.alias.m_Next);
+        EXPECT_EQ(bin.alias.m_BlendIn,  txt.alias.m_BlendIn);
+        EXPECT_EQ(bin.alias.m_BlendOut, txt.alias.m_BlendOut);
+        EXPECT_EQ(bin.alias.m_Flags,    txt.alias.m_Flags);
+        EXPECT_EQ(bin.alias.m_Alias,    txt.alias.m_Alias);
+        EXPECT_EQ(bin.alias.m_Dir,      txt.alias.m_Dir);
+        break;
+      case ZenLoad::MdsParser::CHUNK_ANI_COMB:
+        EXPECT_EQ(bin.comb.m_Name,      txt.comb.m_Name);
+        EXPECT_EQ(bin.comb.m_Layer,     txt.comb.m_Layer);
+        EXPECT_EQ(bin.comb.m_Next,      txt.comb.m_Next);
+        EXPECT_EQ(bin.comb.m_BlendIn,   txt.comb.m_BlendIn);
+        EXPECT_EQ(bin.comb.m_BlendOut,  txt.comb.m_BlendOut);
+        EXPECT_EQ(bin.comb.m_Flags,     txt.comb.m_Flags);
+        EXPECT_EQ(bin.comb.m_Asc,       txt.comb.m_Asc);
+        EXPECT_EQ(bin.comb.m_LastFrame, txt.comb.m_LastFrame);
+        break;
+      case ZenLoad::MdsParser::CHUNK_ANI_DISABLE:
+        EXPECT_EQ(bin.disable.m_Name, txt.disable.m_Name);
+        break;
+      case ZenLoad::MdsParser::CHUNK_EVENT_SFX:
+      case ZenLoad::MdsParser::CHUNK_EVENT_SFX_GRND: {
+        auto& b = (c==ZenLoad::MdsParser::CHUNK_EVENT_SFX ? bin.sfx : bin.gfx).back();
+        auto& t = (c==ZenLoad::MdsParser::CHUNK_EVENT_SFX ? txt.sfx : txt.gfx).back();
+        EXPECT_EQ(b.m_Frame,     t.m_Frame);
+        EXPECT_EQ(b.m_Name,      t.m_Name);
+        EXPECT_EQ(b.m_Range,     t.m_Range);
+        EXPECT_EQ(b.m_EmptySlot, t.m_EmptySlot);
+        break;
+        }
+      case ZenLoad::MdsParser::CHUNK_EVENT_PFX:
+        EXPECT_EQ(bin.pfx.back().m_Frame,      txt.pfx.back().m_Frame);
+        EXPECT_EQ(bin.pfx.back().m_Num,        txt.pfx.back().m_Num);
+        EXPECT_EQ(bin.pfx.back().m_Name,       txt.pfx.back().m_Name);
+        EXPECT_EQ(bin.pfx.back().m_Pos,        txt.pfx.back().m_Pos);
+        EXPECT_EQ(bin.pfx.back().m_isAttached, txt.pfx.back().m_isAttached);
+        break;
+      case ZenLoad::MdsParser::CHUNK_EVENT_PFX_STOP:
+        EXPECT_EQ(bin.pfxStop.back().m_Frame, txt.pfxStop.back().m_Frame);
+        EXPECT_EQ(bin.pfxStop.back().m_Num,   txt.pfxStop.back().m_Num);
+        break;
+      case ZenLoad::MdsParser::CHUNK_EVENT_TAG:
+        EXPECT_EQ(bin.eventTag.back().m_Frame, txt.eventTag.back().m_Frame);
+        EXPECT_EQ(bin.eventTag.back().m_Def,   txt.eventTag.back().m_Def);
+        EXPECT_EQ(bin.eventTag.back().m_Fmode, txt.eventTag.back().m_Fmode);
+        EXPECT_EQ(bin.eventTag.back().m_Int,   txt.eventTag.back().m_Int);
+        EXPECT_EQ(bin.eventTag.back().m_Slot,  txt.eventTag.back().m_Slot);
+        EXPECT_EQ(bin.eventTag.back().m_Item,  txt.eventTag.back().m_Item);
+        EXPECT_EQ(bin.eventTag.back().m_Slot2, txt.eventTag.back().m_Slot2);
+        break;
+      case ZenLoad::MdsParser::CHUNK_EVENT_MMSTARTANI:
+        EXPECT_EQ(bin.mmStartAni.back().m_Frame,     txt.mmStartAni.back().m_Frame);
+        EXPECT_EQ(bin.mmStartAni.back().m_Animation, txt.mmStartAni.back().m_Animation);
+        EXPECT_EQ(bin.mmStartAni.back().m_Node,      txt.mmStartAni.back().m_Node);
+        break;
+      default:
+        break;
+      }
+    }
+
+  // meshAndTree, registerMesh, ani, 10 events without the unknown tag, aniAlias, aniComb, aniDisable
+  EXPECT_EQ(numChunks, 15u);
+  EXPECT_EQ(bin.eventTag.size(), 4u);
+  EXPECT_EQ(bin.eventTag[1].m_Int, (std::vector<int32_t>{5, 8, 12}));
+  EXPECT_EQ(bin.eventTag[2].m_Fmode, ZenLoad::FM_2H);
+  }
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <array>
+#include <random>
+#include <set>
+#include <tuple>
+#include <gtest/gtest.h>
+
+#include <zenload/meshOptimizer.h>
+
+// Regular grid of quads, with shuffled triangle order to destroy any locality
+static ZenLoad::PackedMesh makeShuffledGrid(uint32_t w, uint32_t h) {
+  ZenLoad::PackedMesh mesh;
+  mesh.vertices.resize((w+1)*(h+1));
+  for(uint32_t y=0; y<=h; ++y)
+    for(uint32_t x=0; x<=w; ++x) {
+      auto& v = mesh.vertices[y*(w+1)+x];
+      v.Position = ZMath::float3(float(x),0,float(y));
+      v.Color    = y*(w+1)+x;
+      }
+
+  std::vector<std::array<uint32_t,3>> tris;
+  for(uint32_t y=0; y<h; ++y)
+    for(uint32_t x=0; x<w; ++x) {
+      const uint32_t a = y*(w+1)+x, b = a+1, c = a+w+1, d = c+1;
+      tris.push_back({a,c,b});
+      tris.push_back({b,c,d});
+      }
+  std::mt19937 rng(1);
+  std::shuffle(tris.begin(),tris.end(),rng);
+
+  for(auto& t:tris)
+    mesh.indices.insert(mesh.indices.end(),t.begin(),t.end());
+
+  mesh.subMeshes.resize(1);
+  mesh.subMeshes[0].indexOffset = 0;
+  mesh.subMeshes[0].indexSize   = mesh.indices.size();
+  return mesh;
+  }
+
+// Triangles as sets of the original vertex ids (stored in Color), rotation-independent
+static std::multiset<std::tuple<uint32_t,uint32_t,uint32_t>> triangleSet(const ZenLoad::PackedMesh& mesh) {
+  std::multiset<std::tuple<uint32_t,uint32_t,uint32_t>> ret;
+  for(size_t i=0; i<mesh.indices.size(); i+=3) {
+    uint32_t v[3] = {mesh.vertices[mesh.indices[i]].Color,
+                     mesh.vertices[mesh.indices[i+1]].Color,
+                     mesh.vertices[mesh.indices[i+2]].Color};
+    // Keep winding: rotate smallest id to the front
+    size_t m = std::min_element(v,v+3)-v;
+    ret.emplace(v[m],v[(m+1)%3],v[(m+2)%3]);
+    }
+  return ret;
+  }
+
+TEST(MeshOptimizer, ACMR) {
+  // A fan misses three times on the first triangle, then once per triangle
+  const uint32_t fan[] = {0,1,2, 0,2,3, 0,3,4, 0,4,5};
+  EXPECT_FLOAT_EQ(ZenLoad::computeACMR(fan,12,16), 6.f/4.f);
+  EXPECT_FLOAT_EQ(ZenLoad::computeACMR(fan,12,0),  3.f);
+  }
+
+TEST(MeshOptimizer, GridImproves) {
+  ZenLoad::PackedMesh mesh = makeShuffledGrid(32,32);
+  auto before = triangleSet(mesh);
+
+  ZenLoad::MeshOptimizeStats stats = ZenLoad::optimizePackedMesh(mesh);
+  EXPECT_LT(stats.acmrAfter, stats.acmrBefore);
+  EXPECT_LT(stats.acmrAfter, 1.f);
+  EXPECT_FLOAT_EQ(stats.acmrAfter, ZenLoad::computeACMR(mesh.indices.data(),mesh.indices.size(),16));
+
+  // Same triangles, same winding
+  EXPECT_EQ(before, triangleSet(mesh));
+
+  // Vertices must appear in order of first use
+  uint32_t next = 0;
+  for(uint32_t id:mesh.indices) {
+    EXPECT_LE(id, next);
+    if(id==next)
+      ++next;
+    }
+  }
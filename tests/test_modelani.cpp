@@ -0,0 +1,150 @@
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <gtest/gtest.h>
+
+#include <zenload/zCModelAni.h>
+#include <zenload/zenParser.h>
+
+// Scalar reference decoding, defined in zCModelAni.cpp
+void SampleUnpackTrans(const uint16_t* in, ZMath::float3& out, float samplePosScaler, float samplePosRangeMin);
+void SampleUnpackQuat(const uint16_t* in, ZMath::float4& out);
+
+static const float POS_SCALER    = 0.0625f;
+static const float POS_RANGE_MIN = -2000.f;
+
+// Random words cover the len_q>1 branch, words close to the middle the one with a proper w
+static std::vector<ZenLoad::zTMdl_AniSample> randomSamples(size_t count, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<ZenLoad::zTMdl_AniSample> samples(count);
+  for(size_t i=0; i<count; ++i) {
+    for(int k=0; k<3; ++k) {
+      const uint16_t r = uint16_t(rng());
+      samples[i].rotation[k] = i%2==0 ? r : uint16_t(32767-8192+r%16384);
+      samples[i].position[k] = uint16_t(rng());
+      }
+    }
+  return samples;
+  }
+
+static void expectSame(const ZenLoad::zCModelAni::AniSample& a, const ZenLoad::zCModelAni::AniSample& b, size_t i) {
+  EXPECT_NEAR(a.rotation.x,b.rotation.x,1e-6f) << "sample " << i;
+  EXPECT_NEAR(a.rotation.y,b.rotation.y,1e-6f) << "sample " << i;
+  EXPECT_NEAR(a.rotation.z,b.rotation.z,1e-6f) << "sample " << i;
+  EXPECT_NEAR(a.rotation.w,b.rotation.w,1e-6f) << "sample " << i;
+  EXPECT_NEAR(a.position.x,b.position.x,1e-3f) << "sample " << i;
+  EXPECT_NEAR(a.position.y,b.position.y,1e-3f) << "sample " << i;
+  EXPECT_NEAR(a.position.z,b.position.z,1e-3f) << "sample " << i;
+  }
+
+TEST(ModelAni, UnpackSamplesMatchesScalar) {
+  // Counts which aren't a multiple of the four samples decoded at once run into the tail loop
+  for(size_t count:{0, 1, 3, 4, 5, 7, 8, 63, 1001}) {
+    const std::vector<ZenLoad::zTMdl_AniSample> in = randomSamples(count,uint32_t(count));
+    std::vector<ZenLoad::zCModelAni::AniSample> out(count);
+    ZenLoad::zCModelAni::unpackSamples(in.data(),out.data(),count,POS_SCALER,POS_RANGE_MIN);
+
+    size_t numOver = 0;
+    for(size_t i=0; i<count; ++i) {
+      ZenLoad::zCModelAni::AniSample ref;
+      SampleUnpackQuat (in[i].rotation,ref.rotation);
+      SampleUnpackTrans(in[i].position,ref.position,POS_SCALER,POS_RANGE_MIN);
+      expectSame(out[i],ref,i);
+      numOver += ref.rotation.w==0.f ? 1 : 0;
+      }
+    if(count>=8) {
+      EXPECT_GT(numOver,0u);
+      EXPECT_LT(numOver,count);
+      }
+    }
+  }
+
+// Header and raw data chunks of a .MAN file
+static std::vector<uint8_t> makeMan(uint32_t numFrames, uint32_t numNodes, const std::vector<ZenLoad::zTMdl_AniSample>& samples) {
+  std::vector<uint8_t> out;
+  auto pod = [&out](const void* p, size_t size) {
+    out.insert(out.end(),reinterpret_cast<const uint8_t*>(p),reinterpret_cast<const uint8_t*>(p)+size);
+    };
+  auto chunk = [&out,&pod](uint16_t id, const std::vector<uint8_t>& body) {
+    const uint32_t length = uint32_t(body.size());
+    pod(&id,sizeof(id));
+    pod(&length,sizeof(length));
+    out.insert(out.end(),body.begin(),body.end());
+    };
+
+  std::vector<uint8_t> header;
+  {
+    std::swap(out,header);
+    const uint16_t version = 12;
+    const uint32_t layer   = 1;
+    const float    fps     = 25.f;
+    const float    bbox[6] = {};
+    pod(&version,sizeof(version));
+    pod("S_TEST\n",7);
+    pod(&layer,sizeof(layer));
+    pod(&numFrames,sizeof(numFrames));
+    pod(&numNodes,sizeof(numNodes));
+    pod(&fps,sizeof(fps));
+    pod(&fps,sizeof(fps));
+    pod(&POS_RANGE_MIN,sizeof(POS_RANGE_MIN));
+    pod(&POS_SCALER,sizeof(POS_SCALER));
+    pod(bbox,sizeof(bbox));
+    pod("\n",1);
+    std::swap(out,header);
+  }
+
+  std::vector<uint8_t> raw;
+  {
+    std::swap(out,raw);
+    const uint32_t checksum = 0;
+    pod(&checksum,sizeof(checksum));
+    for(uint32_t i=0; i<numNodes; ++i)
+      pod(&i,sizeof(i));
+    pod(samples.data(),samples.size()*sizeof(samples[0]));
+    std::swap(out,raw);
+  }
+
+  chunk(0xA020,header);
+  chunk(0xA090,raw);
+  return out;
+  }
+
+TEST(ModelAni, QuantizedMatchesExpandedWithScale) {
+  const uint32_t numFrames = 7, numNodes = 5;
+  const std::vector<ZenLoad::zTMdl_AniSample> samples = randomSamples(numFrames*numNodes,42);
+  const std::vector<uint8_t>                  file    = makeMan(numFrames,numNodes,samples);
+
+  for(float scale:{1.f, 0.01f, 2.5f}) {
+    ZenLoad::zCModelAni expanded, quantized;
+    {
+      ZenLoad::ZenParser parser(file.data(),file.size());
+      expanded.readObjectData(parser,false,scale);
+    }
+    {
+      ZenLoad::ZenParser parser(file.data(),file.size());
+      quantized.readObjectData(parser,true,scale);
+    }
+    ASSERT_FALSE(expanded.isQuantized());
+    ASSERT_TRUE (quantized.isQuantized());
+    ASSERT_EQ(expanded.getNumSamples(),samples.size());
+    ASSERT_EQ(quantized.getNumSamples(),samples.size());
+
+    std::vector<ZenLoad::zCModelAni::AniSample> frame(numNodes);
+    for(uint32_t f=0; f<numFrames; ++f) {
+      quantized.unpackFrame(f,frame.data());
+      for(uint32_t n=0; n<numNodes; ++n) {
+        const ZenLoad::zCModelAni::AniSample& e = expanded.getAniSamples()[f*numNodes+n];
+        ZenLoad::zCModelAni::AniSample        single;
+        quantized.unpackSample(f,n,single);
+
+        // Expected position with the scale applied to the decoded value, as the expanded animation does
+        ZMath::float3 ref;
+        SampleUnpackTrans(samples[f*numNodes+n].position,ref,POS_SCALER,POS_RANGE_MIN);
+        EXPECT_NEAR(e.position.x,ref.x*scale,std::fabs(ref.x*scale)*1e-5f+1e-4f);
+
+        expectSame(frame[n],e,f*numNodes+n);
+        expectSame(single,e,f*numNodes+n);
+        }
+      }
+    }
+  }
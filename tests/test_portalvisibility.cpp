@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <zenload/portalVisibility.h>
+
+// Straight corridor of sectors along x, every sector 100 units long with a portal to the next one
+static void makeCorridor(uint32_t numSectors, uint32_t firstMaterial,
+                         ZenLoad::zCBspTreeData& tree, std::vector<ZenLoad::zCPortalPolygon>& polys) {
+  for(uint32_t s=0; s<numSectors; ++s) {
+    ZenLoad::zCBspNode leaf;
+    leaf.bbox3dMin = ZMath::float3(float(s)*100.f,    -50.f,-50.f);
+    leaf.bbox3dMax = ZMath::float3(float(s)*100.f+100,  50.f, 50.f);
+    tree.nodes.push_back(leaf);
+    tree.leafIndices.push_back(s);
+
+    ZenLoad::zCSector sector;
+    sector.name = "S" + std::to_string(s);
+    sector.bspNodeIndices.push_back(s);
+    tree.sectors.push_back(sector);
+    }
+
+  for(uint32_t s=0; s+1<numSectors; ++s) {
+    ZenLoad::zCPortal p;
+    p.frontSectorIndex = s;
+    p.backSectorIndex  = s+1;
+    p.materialIndex    = firstMaterial+s;
+    tree.portals.push_back(p);
+
+    const float x = float(s+1)*100.f;
+    ZenLoad::zCPortalPolygon poly;
+    poly.materialIndex = firstMaterial+s;
+    poly.vertices = {ZMath::float3(x,-40,-40), ZMath::float3(x,40,-40), ZMath::float3(x,40,40), ZMath::float3(x,-40,40)};
+    polys.push_back(poly);
+    }
+  }
+
+// Chains deeper than the search depth must still report everything at their end as visible
+TEST(PortalVisibility, LongChainStaysConservative) {
+  const uint32_t numSectors = 100;
+
+  ZenLoad::zCBspTreeData                tree;
+  std::vector<ZenLoad::zCPortalPolygon> polys;
+  makeCorridor(numSectors,0,tree,polys);
+
+  ZenLoad::PortalVisibility vis;
+  vis.build(tree,polys);
+  ASSERT_EQ(vis.sectorCount(),numSectors+1);
+
+  for(uint32_t s=0; s<numSectors; ++s) {
+    EXPECT_TRUE(vis.isVisible(0,s))            << "sector " << s;
+    EXPECT_TRUE(vis.isVisible(numSectors-1,s)) << "sector " << s;
+    EXPECT_TRUE(vis.isVisibleFromLeaf(0,s))    << "sector " << s;
+    }
+  EXPECT_FALSE(vis.isVisible(0,ZenLoad::SECTOR_INDEX_INVALID));
+  }
+
+// Material indices beyond the range of int16_t must not alias other portals
+TEST(PortalVisibility, LargeMaterialIndices) {
+  ZenLoad::zCBspTreeData                tree;
+  std::vector<ZenLoad::zCPortalPolygon> polys;
+  makeCorridor(3,70000,tree,polys);
+
+  // Same index as the second portal in the lower 16 bits, without a portal of its own
+  ZenLoad::zCPortalPolygon stray = polys[1];
+  stray.materialIndex = (70000+1)-65536;
+  polys[1] = stray;
+
+  ZenLoad::PortalVisibility vis;
+  vis.build(tree,polys);
+  EXPECT_TRUE (vis.isVisible(0,1));
+  EXPECT_FALSE(vis.isVisible(0,2));
+  EXPECT_FALSE(vis.isVisible(1,2));
+  }
@@ -0,0 +1,200 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <gtest/gtest.h>
+
+#include <zenload/meshQuantizer.h>
+
+static float bitsToFloat(uint32_t x) {
+  float f;
+  std::memcpy(&f,&x,sizeof(f));
+  return f;
+  }
+
+static float angle(const ZMath::float3& a, const ZMath::float3& b) {
+  const double d = double(a.x)*b.x + double(a.y)*b.y + double(a.z)*b.z;
+  return float(std::acos(std::min(1.0,std::max(-1.0,d))));
+  }
+
+static ZMath::float3 randomNormal(std::mt19937& rng) {
+  std::normal_distribution<float> nd;
+  for(;;) {
+    const ZMath::float3 n(nd(rng),nd(rng),nd(rng));
+    const float         l = std::sqrt(n.x*n.x+n.y*n.y+n.z*n.z);
+    if(l>1e-3f)
+      return n*(1.f/l);
+    }
+  }
+
+TEST(Quantizer, HalfRoundTrip) {
+  // Every half, denormals and infinities included, survives the way through float
+  for(uint32_t h=0; h<=0xFFFF; ++h) {
+    const float f = ZMath::halfToFloat(uint16_t(h));
+    if(std::isnan(f)) {
+      EXPECT_TRUE(std::isnan(ZMath::halfToFloat(ZMath::floatToHalf(f)))) << std::hex << h;
+      EXPECT_EQ(ZMath::floatToHalf(f)&0x8000,h&0x8000)                    << std::hex << h;
+      continue;
+      }
+    EXPECT_EQ(ZMath::floatToHalf(f),h) << std::hex << h;
+    }
+
+  EXPECT_EQ(ZMath::halfToFloat(0x0001),std::ldexp(1.f,-24));  // Smallest denormal
+  EXPECT_EQ(ZMath::halfToFloat(0x03FF),std::ldexp(1023.f,-24));
+  EXPECT_EQ(ZMath::halfToFloat(0x7BFF),65504.f);
+  EXPECT_EQ(ZMath::halfToFloat(0x7C00), std::numeric_limits<float>::infinity());
+  EXPECT_EQ(ZMath::halfToFloat(0xFC00),-std::numeric_limits<float>::infinity());
+  EXPECT_TRUE(std::isnan(ZMath::halfToFloat(ZMath::floatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+  EXPECT_TRUE(std::isnan(ZMath::halfToFloat(ZMath::floatToHalf(bitsToFloat(0x7F800001)))));  // Signaling, low payload
+
+  // Rounding to nearest even, into the denormal range and out of the range
+  EXPECT_EQ(ZMath::floatToHalf(std::ldexp(1.f,-25)),0x0000);
+  EXPECT_EQ(ZMath::floatToHalf(std::nextafter(std::ldexp(1.f,-25),1.f)),0x0001);
+  EXPECT_EQ(ZMath::floatToHalf(std::ldexp(3.f,-25)),0x0002);
+  EXPECT_EQ(ZMath::floatToHalf(-std::ldexp(1.f,-30)),0x8000);
+  EXPECT_EQ(ZMath::floatToHalf(1.f+std::ldexp(1.f,-11)),0x3C00);
+  EXPECT_EQ(ZMath::floatToHalf(1.f+std::ldexp(3.f,-11)),0x3C02);
+  EXPECT_EQ(ZMath::floatToHalf(65519.f),0x7BFF);
+  EXPECT_EQ(ZMath::floatToHalf(65520.f),0x7C00);
+  EXPECT_EQ(ZMath::floatToHalf(-1e10f),0xFC00);
+  }
+
+TEST(Quantizer, OctahedralNormals) {
+  std::mt19937 rng(7);
+  for(int i=0; i<200000; ++i) {
+    const ZMath::float3 n = randomNormal(rng);
+    int8_t e[2];
+    ZenLoad::encodeOctahedral(n,e);
+    const ZMath::float3 d = ZenLoad::decodeOctahedral(e);
+    ASSERT_LE(angle(n,d),0.012f) << n.x << " " << n.y << " " << n.z;
+    ASSERT_NEAR(d.x*d.x+d.y*d.y+d.z*d.z,1.f,1e-5f);
+    ASSERT_GE(e[0],-127);
+    ASSERT_GE(e[1],-127);
+    }
+
+  // The axes are exact, on both hemispheres
+  const ZMath::float3 axes[] = {ZMath::float3(1,0,0), ZMath::float3(-1,0,0), ZMath::float3(0,1,0),
+                                ZMath::float3(0,-1,0), ZMath::float3(0,0,1), ZMath::float3(0,0,-1)};
+  for(const ZMath::float3& a:axes) {
+    int8_t e[2];
+    ZenLoad::encodeOctahedral(a,e);
+    const ZMath::float3 d = ZenLoad::decodeOctahedral(e);
+    EXPECT_NEAR(d.x,a.x,1e-6f);
+    EXPECT_NEAR(d.y,a.y,1e-6f);
+    EXPECT_NEAR(d.z,a.z,1e-6f);
+    }
+
+  int8_t e[2] = {1,1};
+  ZenLoad::encodeOctahedral(ZMath::float3(0,0,0),e);
+  EXPECT_EQ(e[0],0);
+  EXPECT_EQ(e[1],0);
+  }
+
+// Few vertices scattered in an off-center box, with UVs beyond the unit square
+static ZenLoad::PackedMesh makeMesh() {
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> x(-700.f,1300.f), y(20.f,60.f), z(-5000.f,-4000.f), uv(-4.f,4.f);
+
+  ZenLoad::PackedMesh mesh;
+  for(uint32_t i=0; i<24; ++i) {
+    ZenLoad::WorldVertex v = {};
+    v.Position = ZMath::float3(x(rng),y(rng),z(rng));
+    v.Normal   = randomNormal(rng);
+    v.TexCoord = ZMath::float2(uv(rng),uv(rng));
+    v.Color    = i*0x01020304u;
+    mesh.vertices.push_back(v);
+    }
+  mesh.vertices[0].TexCoord = ZMath::float2(1e-5f,0.f);  // Denormal half
+  for(uint32_t i=0; i+2<mesh.vertices.size(); i+=3)
+    mesh.indices.insert(mesh.indices.end(),{i,i+2,i+1});
+  mesh.subMeshes.resize(1);
+  mesh.subMeshes[0].indexSize = mesh.indices.size();
+  mesh.bbox[0] = ZMath::float3(-1,-1,-1);  // Not matching the vertices, the quantization box must not use it
+  mesh.bbox[1] = ZMath::float3( 1, 1, 1);
+  return mesh;
+  }
+
+TEST(Quantizer, MeshErrorWithinBounds) {
+  const ZenLoad::PackedMesh mesh = makeMesh();
+
+  for(auto fmt:{ZenLoad::CompactPositionFormat::Fixed16, ZenLoad::CompactPositionFormat::Half}) {
+    ZenLoad::PackedMeshCompact    compact;
+    ZenLoad::MeshQuantizationError error;
+    error.position = -1.f;
+    ZenLoad::quantizeMesh(mesh,compact,fmt,&error);
+    ASSERT_EQ(compact.vertices.size(),mesh.vertices.size());
+    EXPECT_EQ(compact.indices,mesh.indices);
+
+    ZenLoad::PackedMesh decoded;
+    ZenLoad::dequantizeMesh(compact,decoded);
+    ASSERT_EQ(decoded.vertices.size(),mesh.vertices.size());
+
+    const ZMath::float3* box = compact.quantBox;
+    ZenLoad::MeshQuantizationError measured;
+    for(size_t i=0; i<mesh.vertices.size(); ++i) {
+      const ZenLoad::WorldVertex& a = mesh.vertices[i];
+      const ZenLoad::WorldVertex& b = decoded.vertices[i];
+      float d2 = 0.f;
+      for(int k=0; k<3; ++k) {
+        const float d = std::fabs(a.Position.v[k]-b.Position.v[k]);
+        // Bounds per axis, with a little room for the float math of the decoding
+        const float bound = fmt==ZenLoad::CompactPositionFormat::Fixed16
+                          ? (box[1].v[k]-box[0].v[k])/65535.f*0.5f
+                          : std::fabs(a.Position.v[k]-(box[0].v[k]+box[1].v[k])*0.5f)*std::ldexp(1.f,-11);
+        EXPECT_LE(d,bound*1.01f+std::fabs(a.Position.v[k])*1e-6f) << "vertex " << i << " axis " << k;
+        d2 += d*d;
+        }
+      measured.position = std::max(measured.position,std::sqrt(d2));
+      measured.normal   = std::max(measured.normal,angle(a.Normal,b.Normal));
+      for(int k=0; k<2; ++k) {
+        const float uv = k==0 ? a.TexCoord.x : a.TexCoord.y;
+        const float d  = std::fabs(uv-(k==0 ? b.TexCoord.x : b.TexCoord.y));
+        EXPECT_LE(d,std::max(std::fabs(uv)*std::ldexp(1.f,-11),std::ldexp(1.f,-25))) << "vertex " << i;
+        measured.texCoord = std::max(measured.texCoord,d);
+        }
+      EXPECT_EQ(b.Color,a.Color);
+      }
+
+    // The report is the largest error of the decoded mesh
+    EXPECT_NEAR(error.position,measured.position,1e-4f);
+    EXPECT_NEAR(error.normal,  measured.normal,  1e-4f);
+    EXPECT_NEAR(error.texCoord,measured.texCoord,1e-7f);
+    EXPECT_GT(error.position,0.f);
+    EXPECT_LE(error.normal,0.012f);
+    EXPECT_EQ(error.weight,0.f);
+
+    // Box (2000, 40, 1000) units
+    if(fmt==ZenLoad::CompactPositionFormat::Fixed16)
+      EXPECT_LE(error.position,0.5f*std::sqrt(2000.f*2000.f+40.f*40.f+1000.f*1000.f)/65535.f*1.01f);
+    }
+  }
+
+TEST(Quantizer, SkeletalWeights) {
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> w(0.f,1.f), p(-50.f,50.f);
+
+  ZenLoad::PackedSkeletalMesh mesh;
+  for(int i=0; i<400; ++i) {
+    ZenLoad::SkeletalVertex v = {};
+    v.Normal = randomNormal(rng);
+    for(int j=0; j<4; ++j) {
+      v.Weights[j]        = j<=i%4 ? w(rng) : 0.f;
+      v.BoneIndices[j]    = uint8_t(j<=i%4 ? i%60+j : 0);
+      v.LocalPositions[j] = ZMath::float3(p(rng),p(rng),p(rng));
+      }
+    mesh.vertices.push_back(v);
+    }
+
+  ZenLoad::PackedSkeletalMeshCompact compact;
+  ZenLoad::MeshQuantizationError     error;
+  ZenLoad::quantizeMesh(mesh,compact,ZenLoad::CompactPositionFormat::Fixed16,&error);
+  EXPECT_GT(error.weight,0.f);
+  EXPECT_LE(error.weight,2.f/255.f);
+  EXPECT_LE(error.normal,0.012f);
+  for(size_t i=0; i<compact.vertices.size(); ++i) {
+    const uint8_t* q = compact.vertices[i].Weights;
+    EXPECT_EQ(q[0]+q[1]+q[2]+q[3],255) << "vertex " << i;
+    for(int j=0; j<4; ++j)
+      EXPECT_EQ(compact.vertices[i].BoneIndices[j],mesh.vertices[i].BoneIndices[j]);
+    }
+  }
@@ -0,0 +1,137 @@
+#include <cstring>
+#include <set>
+#include <tuple>
+#include <gtest/gtest.h>
+
+#include <zenload/materialRegistry.h>
+#include <zenload/worldTiles.h>
+
+// Flat grid of w*h quads with unit size, two materials in a checkerboard
+static ZenLoad::PackedMesh makeGrid(uint32_t w, uint32_t h) {
+  ZenLoad::PackedMesh mesh;
+  for(uint32_t y=0; y<=h; ++y)
+    for(uint32_t x=0; x<=w; ++x) {
+      ZenLoad::WorldVertex v = {};
+      v.Position = ZMath::float3(float(x),0,float(y));
+      v.Color    = y*(w+1)+x;
+      mesh.vertices.push_back(v);
+      }
+
+  ZenLoad::zCMaterialData a, b;
+  a.matName = "A";
+  b.matName = "B";
+  mesh.subMeshes.resize(2);
+  mesh.subMeshes[0].materialId = ZenLoad::MaterialRegistry::global().add(a);
+  mesh.subMeshes[1].materialId = ZenLoad::MaterialRegistry::global().add(b);
+  for(int m=0; m<2; ++m) {
+    mesh.subMeshes[m].indexOffset = mesh.indices.size();
+    for(uint32_t y=0; y<h; ++y)
+      for(uint32_t x=0; x<w; ++x) {
+        if(int((x+y)%2)!=m)
+          continue;
+        const uint32_t a = y*(w+1)+x, b = a+1, c = a+w+1, d = c+1;
+        mesh.indices.insert(mesh.indices.end(),{a,c,b,b,c,d});
+        mesh.subMeshes[m].triangleLightmapIndices.push_back(int16_t(a));
+        mesh.subMeshes[m].triangleLightmapIndices.push_back(int16_t(b));
+        }
+    mesh.subMeshes[m].indexSize = mesh.indices.size()-mesh.subMeshes[m].indexOffset;
+    }
+  return mesh;
+  }
+
+// Triangles as (vertex ids stored in Color, material, lightmap)
+using TriKey = std::tuple<uint32_t,uint32_t,uint32_t,std::string,int16_t>;
+
+static void collect(const ZenLoad::PackedMesh& mesh, std::multiset<TriKey>& out) {
+  for(auto& sm:mesh.subMeshes)
+    for(size_t i=0; i<sm.indexSize; i+=3) {
+      const uint32_t* t = &mesh.indices[sm.indexOffset+i];
+      out.emplace(mesh.vertices[t[0]].Color,mesh.vertices[t[1]].Color,mesh.vertices[t[2]].Color,
+                  ZenLoad::MaterialRegistry::global().get(sm.materialId).matName,sm.triangleLightmapIndices[i/3]);
+      }
+  }
+
+TEST(WorldTiles, Split) {
+  const ZenLoad::PackedMesh mesh = makeGrid(10,6);
+  ZenLoad::WorldTileGrid grid;
+  ZenLoad::buildWorldTiles(mesh,4.f,grid);
+
+  EXPECT_EQ(grid.tilesX,3u);
+  EXPECT_EQ(grid.tilesZ,2u);
+  EXPECT_EQ(grid.tiles.size(),6u);
+
+  std::multiset<TriKey> before, after;
+  collect(mesh,before);
+  for(auto& t:grid.tiles) {
+    for(auto& v:t.mesh.vertices) {
+      EXPECT_GE(v.Position.x,float(t.x)*4.f);
+      EXPECT_LE(v.Position.x,float(t.x+1)*4.f);
+      }
+    EXPECT_LE(t.mesh.subMeshes.size(),2u);
+    collect(t.mesh,after);
+    }
+  EXPECT_EQ(before,after);
+
+  const ZenLoad::WorldTile* t = grid.tileAt(ZMath::float3(9.5f,0,1.f));
+  ASSERT_NE(t,nullptr);
+  EXPECT_EQ(t->x,2u);
+  EXPECT_EQ(t->z,0u);
+  EXPECT_EQ(grid.tileAt(ZMath::float3(-1.f,0,1.f)),nullptr);
+
+  std::vector<uint32_t> near;
+  grid.tilesInRadius(ZMath::float3(0.5f,0,0.5f),1.f,near);
+  ASSERT_EQ(near.size(),1u);
+  EXPECT_EQ(grid.tiles[near[0]].x,0u);
+  }
+
+TEST(WorldTiles, Serialize) {
+  const ZenLoad::PackedMesh mesh = makeGrid(8,8);
+  ZenLoad::WorldTileGrid grid;
+  ZenLoad::buildWorldTiles(mesh,4.f,grid);
+
+  std::vector<uint8_t> index;
+  ZenLoad::writeWorldTileIndex(grid,index);
+  ZenLoad::WorldTileGrid loaded;
+  ASSERT_TRUE(ZenLoad::readWorldTileIndex(index.data(),index.size(),loaded));
+  ASSERT_EQ(loaded.tiles.size(),grid.tiles.size());
+  EXPECT_EQ(loaded.tilesX,grid.tilesX);
+  EXPECT_TRUE(loaded.tiles[0].mesh.vertices.empty());
+
+  for(size_t i=0; i<grid.tiles.size(); ++i) {
+    std::vector<uint8_t> data;
+    ZenLoad::writeWorldTile(grid.tiles[i],data);
+    ASSERT_TRUE(ZenLoad::readWorldTile(data.data(),data.size(),loaded.tiles[i]));
+    EXPECT_FALSE(ZenLoad::readWorldTile(data.data(),data.size()-1,loaded.tiles[i]));
+    ASSERT_TRUE(ZenLoad::readWorldTile(data.data(),data.size(),loaded.tiles[i]));
+
+    std::multiset<TriKey> a, b;
+    collect(grid.tiles[i].mesh,a);
+    collect(loaded.tiles[i].mesh,b);
+    EXPECT_EQ(a,b);
+    EXPECT_EQ(loaded.tiles[i].mesh.bbox[1],grid.tiles[i].mesh.bbox[1]);
+    }
+  }
+
+TEST(WorldTiles, SizeLimit) {
+  const ZenLoad::PackedMesh mesh = makeGrid(8,8);
+  ZenLoad::WorldTileGrid grid;
+  ZenLoad::buildWorldTiles(mesh,1e-12f,grid);
+  EXPECT_LE(grid.tilesX,4096u);
+  EXPECT_LE(grid.tilesZ,4096u);
+  EXPECT_EQ(grid.cells.size(),size_t(grid.tilesX)*grid.tilesZ);
+
+  std::vector<uint8_t> index;
+  ZenLoad::writeWorldTileIndex(grid,index);
+  ZenLoad::WorldTileGrid loaded;
+  ASSERT_TRUE(ZenLoad::readWorldTileIndex(index.data(),index.size(),loaded));
+
+  // tilesX and tilesZ follow magic, version, origin and tile size
+  const size_t at = 2*sizeof(uint32_t)+sizeof(ZMath::float3)+sizeof(float);
+  for(uint32_t bad:{0u, 4097u, 0xFFFFFFFFu}) {
+    std::vector<uint8_t> corrupt = index;
+    std::memcpy(&corrupt[at],&bad,sizeof(bad));
+    EXPECT_FALSE(ZenLoad::readWorldTileIndex(corrupt.data(),corrupt.size(),loaded)) << bad;
+    std::memcpy(&corrupt[at+sizeof(uint32_t)],&bad,sizeof(bad));
+    EXPECT_FALSE(ZenLoad::readWorldTileIndex(corrupt.data(),corrupt.size(),loaded)) << bad;
+    }
+  }
@@ -1,6 +1,8 @@
 #pragma once
 #include <inttypes.h>
+#include <stddef.h>
 #include <string.h>
+#include <new>
 
 #if EMSCRIPTEN
 #include <emscripten.h>
@@ -33,4 +35,46 @@ namespace Utils
         uint8_t*& ptr = ((uint8_t*&)src);
         ptr += sizeof(T);
     }
+
+    /**
+     * @brief Allocator for std::vector, aligning the storage to the given power of two (e.g. a cache line)
+     */
+    template <typename T, size_t Align>
+    struct AlignedAllocator
+    {
+        typedef T value_type;
+
+        template <typename U>
+        struct rebind
+        {
+            typedef AlignedAllocator<U, Align> other;
+        };
+
+        AlignedAllocator() = default;
+
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U, Align>&)
+        {
+        }
+
+        T* allocate(size_t n)
+        {
+            // Over-allocate and keep the original pointer right in front of the aligned block
+            uint8_t* raw = static_cast<uint8_t*>(::operator new(n * sizeof(T) + Align + sizeof(void*)));
+            uintptr_t p = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + Align - 1) & ~uintptr_t(Align - 1);
+            reinterpret_cast<void**>(p)[-1] = raw;
+            return reinterpret_cast<T*>(p);
+        }
+
+        void deallocate(T* p, size_t)
+        {
+            ::operator delete(reinterpret_cast<void**>(p)[-1]);
+        }
+
+        template <typename U>
+        bool operator==(const AlignedAllocator<U, Align>&) const { return true; }
+
+        template <typename U>
+        bool operator!=(const AlignedAllocator<U, Align>&) const { return false; }
+    };
 }  // namespace Utils
@@ -1,8 +1,19 @@
 #pragma once
+#include <zenload/materialRegistry.h>
 #include <zenload/zTypes.h>
 
 namespace Utils
 {
+    /**
+     * @return Material of a submesh, a default one if it has none
+     */
+    inline ZenLoad::zCMaterialData materialOf(const ZenLoad::PackedMesh::SubMesh& s)
+    {
+        if (s.materialId == ZenLoad::MATERIAL_ID_INVALID)
+            return ZenLoad::zCMaterialData();
+        return ZenLoad::MaterialRegistry::global().get(s.materialId);
+    }
+
     /**
      * Exports the given packed-mesh structure into a wavefront-OBJ-file
      * @param mesh Mesh to export
@@ -43,8 +54,9 @@ namespace Utils
         // Write faces
         for (auto& s : mesh.subMeshes)
         {
-            fputs(("g " + s.material.matName + "\n").c_str(), f);
-            fputs(("usemtl " + s.material.matName + "\n").c_str(), f);
+            const ZenLoad::zCMaterialData material = materialOf(s);
+            fputs(("g " + material.matName + "\n").c_str(), f);
+            fputs(("usemtl " + material.matName + "\n").c_str(), f);
 
             for (size_t i = 0; i < s.indices.size(); i += 3)
             {
@@ -65,12 +77,13 @@ namespace Utils
 
         for (auto& s : mesh.subMeshes)
         {
-            fputs(("newmtl " + s.material.matName + "\n").c_str(), mf);
+            const ZenLoad::zCMaterialData material = materialOf(s);
+            fputs(("newmtl " + material.matName + "\n").c_str(), mf);
 
-            fputs(("map_Kd " + s.material.texture + "\n").c_str(), mf);
+            fputs(("map_Kd " + material.texture + "\n").c_str(), mf);
 
             ZMath::float4 color;
-            color.fromABGR8(s.material.color);
+            color.fromABGR8(material.color);
 
             fputs(("Kd " + std::to_string(color.x) + " " + std::to_string(color.y) + " " + std::to_string(color.z) + "\n").c_str(), mf);
             fputs(("Ka " + std::to_string(color.x) + " " + std::to_string(color.y) + " " + std::to_string(color.z) + "\n").c_str(), mf);
@@ -344,4 +344,99 @@ namespace ZMath
     };
 
     std::ostream& operator<<(std::ostream& out, Matrix& m);
+
+    /**
+     * @brief Converts a float to IEEE 754 half precision, rounding to nearest even
+     */
+    inline uint16_t floatToHalf(float f)
+    {
+        uint32_t x;
+        memcpy(&x, &f, sizeof(x));
+
+        const uint32_t sign = (x >> 16) & 0x8000;
+        const uint32_t absx = x & 0x7FFFFFFF;
+
+        if (absx >= 0x7F800000)  // Inf or NaN
+            return uint16_t(sign | 0x7C00 | (absx > 0x7F800000 ? 0x200 : 0));
+
+        if (absx >= 0x477FF000)  // Rounds to infinity
+            return uint16_t(sign | 0x7C00);
+
+        if (absx < 0x38800000)  // Result is a denormal or zero
+        {
+            if (absx < 0x33000000)
+                return uint16_t(sign);
+
+            const uint32_t exp = absx >> 23;
+            const uint32_t mant = (absx & 0x007FFFFF) | 0x00800000;
+            const uint32_t shift = 126 - exp;
+            const uint32_t half = (mant + (1u << (shift - 1)) - 1 + ((mant >> shift) & 1)) >> shift;
+            return uint16_t(sign | half);
+        }
+
+        uint32_t half = (absx - 0x38000000) >> 13;
+        const uint32_t rem = absx & 0x1FFF;
+        if (rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+            half++;
+
+        return uint16_t(sign | half);
+    }
+
+    /**
+     * @brief Converts an IEEE 754 half to float
+     */
+    inline float halfToFloat(uint16_t h)
+    {
+        const uint32_t sign = uint32_t(h & 0x8000) << 16;
+        const uint32_t exp = (h >> 10) & 0x1F;
+        const uint32_t mant = h & 0x3FF;
+
+        uint32_t x;
+        if (exp == 0)
+        {
+            const float f = float(mant) * (1.0f / 16777216.0f);
+            return (h & 0x8000) ? -f : f;
+        }
+        else if (exp == 31)
+        {
+            x = sign | 0x7F800000 | (mant << 13);
+        }
+        else
+        {
+            x = sign | ((exp + 112) << 23) | (mant << 13);
+        }
+
+        float f;
+        memcpy(&f, &x, sizeof(f));
+        return f;
+    }
+    /**
+     * @brief Barycentric coordinates of p with respect to the triangle a, b, c, so that p = u*a + v*b + w*c.
+     *        Points off the triangle's plane are projected onto it. Degenerate triangles give (1, 0, 0).
+     */
+    inline void barycentric(const float3& p, const float3& a, const float3& b, const float3& c, float& u, float& v, float& w)
+    {
+        const float e0[3] = {b.x - a.x, b.y - a.y, b.z - a.z};
+        const float e1[3] = {c.x - a.x, c.y - a.y, c.z - a.z};
+        const float e2[3] = {p.x - a.x, p.y - a.y, p.z - a.z};
+
+        const float d00 = e0[0] * e0[0] + e0[1] * e0[1] + e0[2] * e0[2];
+        const float d01 = e0[0] * e1[0] + e0[1] * e1[1] + e0[2] * e1[2];
+        const float d11 = e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2];
+        const float d20 = e2[0] * e0[0] + e2[1] * e0[1] + e2[2] * e0[2];
+        const float d21 = e2[0] * e1[0] + e2[1] * e1[1] + e2[2] * e1[2];
+        const float denom = d00 * d11 - d01 * d01;
+
+        if (denom == 0.0f)
+        {
+            u = 1.0f;
+            v = 0.0f;
+            w = 0.0f;
+            return;
+        }
+
+        v = (d11 * d20 - d01 * d21) / denom;
+        w = (d00 * d21 - d01 * d20) / denom;
+        u = 1.0f - v - w;
+    }
 }  // namespace ZMath
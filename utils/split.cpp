@@ -1,5 +1,7 @@
 #include "split.h"
 
+#include <cctype>
+
 std::vector<std::string>& Utils::split(const std::string& s, const char delim, std::vector<std::string>& elems)
 {
     std::stringstream ss(s);
@@ -69,3 +71,14 @@ std::vector<const char*> Utils::splitDestructive(std::string &s, const char deli
     ret.push_back(v);
   return ret;
 }
+
+std::string Utils::baseName(const std::string& file)
+{
+    std::string base = file;
+    const size_t dot = base.rfind('.');
+    if (dot != std::string::npos && base.size() - dot == 4)
+        base.resize(dot);
+    for (auto& c : base)
+        c = char(std::toupper(static_cast<unsigned char>(c)));
+    return base;
+}
@@ -31,4 +31,10 @@ namespace Utils
     std::vector<std::string> split(const std::string& s, const std::string& delim);
 
     std::string replaceString(std::string subject, const std::string& search, const std::string& replace);
+
+    /**
+     * @brief Name of a file as used for lookups, without a three-letter extension and in upper case.
+     *        "Humans.mds" and "HUMANS" both become "HUMANS".
+     */
+    std::string baseName(const std::string& file);
 }  // namespace Utils
@@ -0,0 +1,195 @@
+#include "animationCompression.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "poseEvaluator.h"
+
+using namespace ZenLoad;
+
+static float rotationError(const ZMath::float4& a, const ZMath::float4& b) {
+  const float d = std::fabs(a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w);
+  return 2.f*std::acos(std::min(d,1.f));
+  }
+
+static float positionError(const ZMath::float3& a, const ZMath::float3& b) {
+  const float dx = a.x-b.x, dy = a.y-b.y, dz = a.z-b.z;
+  return std::sqrt(dx*dx + dy*dy + dz*dz);
+  }
+
+static ZMath::float3 lerp(const ZMath::float3& a, const ZMath::float3& b, float t) {
+  return ZMath::float3(a.x+(b.x-a.x)*t, a.y+(b.y-a.y)*t, a.z+(b.z-a.z)*t);
+  }
+
+// Greedy reduction: every key is followed by the farthest frame the frames in between can be interpolated to.
+// err(a,b,j) is the error at frame j when interpolating between the keys at a and b.
+template<class Err>
+static float reduceTrack(uint32_t numFrames, float tolerance, const Err& err, std::vector<uint16_t>& keys) {
+  keys.assign(1,0);
+
+  bool constant = true;
+  for(uint32_t j=1; j<numFrames && constant; ++j)
+    constant = err(0,0,j)<=tolerance;
+
+  float maxErr = 0.f;
+  if(constant) {
+    for(uint32_t j=1; j<numFrames; ++j)
+      maxErr = std::max(maxErr,err(0,0,j));
+    return maxErr;
+    }
+
+  auto fits = [&](uint32_t a, uint32_t b) {
+    for(uint32_t j=a+1; j<b; ++j)
+      if(err(a,b,j)>tolerance)
+        return false;
+    return true;
+    };
+
+  for(uint32_t a=0; a+1<numFrames;) {
+    uint32_t b = a+1;
+    while(b+1<numFrames && fits(a,b+1))
+      ++b;
+    for(uint32_t j=a+1; j<b; ++j)
+      maxErr = std::max(maxErr,err(a,b,j));
+    keys.push_back(uint16_t(b));
+    a = b;
+    }
+  return maxErr;
+  }
+
+// Same frame normalization as PoseEvaluator
+static float wrapFrame(float frame, bool loop, uint32_t numFrames) {
+  if(loop) {
+    frame = std::fmod(frame,float(numFrames));
+    return frame<0.f ? frame+float(numFrames) : frame;
+    }
+  return std::max(0.f,std::min(frame,float(numFrames-1)));
+  }
+
+void CompressedAnimation::build(const zCModelAni& ani, const AnimationCompressionParams& params,
+                                AnimationCompressionStats* stats) {
+  const zCModelAni::ModelAniHeader& h = ani.getModelAniHeader();
+
+  frames = 0;
+  tracks.clear();
+  rotationFrames.clear();
+  rotations.clear();
+  positionFrames.clear();
+  positions.clear();
+  if(h.numNodes==0 || h.numFrames==0 || h.numFrames>0xFFFF || ani.getNumSamples()<size_t(h.numNodes)*h.numFrames)
+    return;
+
+  const uint32_t numNodes = h.numNodes;
+  frames = h.numFrames;
+
+  std::vector<zCModelAni::AniSample> all(size_t(numNodes)*frames);
+  for(uint32_t f=0; f<frames; ++f)
+    ani.unpackFrame(f,&all[size_t(f)*numNodes]);
+
+  std::vector<ZMath::float4> rot(frames);
+  std::vector<ZMath::float3> pos(frames);
+  std::vector<uint16_t>      keys;
+  float maxRotErr = 0.f, maxPosErr = 0.f;
+
+  tracks.resize(numNodes);
+  for(uint32_t n=0; n<numNodes; ++n) {
+    for(uint32_t f=0; f<frames; ++f) {
+      ZMath::float4 q = all[size_t(f)*numNodes+n].rotation;
+      if(f>0) {
+        // Keep the track on one hemisphere, so neighbouring keys interpolate along the short arc
+        const ZMath::float4& p = rot[f-1];
+        if(p.x*q.x + p.y*q.y + p.z*q.z + p.w*q.w<0.f)
+          q = ZMath::float4(-q.x,-q.y,-q.z,-q.w);
+        }
+      rot[f] = q;
+      pos[f] = all[size_t(f)*numNodes+n].position;
+      }
+
+    Track& t = tracks[n];
+
+    auto rotErr = [&](uint32_t a, uint32_t b, uint32_t j) {
+      const ZMath::float4 q = a==b ? rot[a] : quatNlerp(rot[a],rot[b],float(j-a)/float(b-a));
+      return rotationError(q,rot[j]);
+      };
+    maxRotErr = std::max(maxRotErr,reduceTrack(frames,params.rotationTolerance,rotErr,keys));
+    t.rotationFirst = uint32_t(rotationFrames.size());
+    t.rotationCount = uint16_t(keys.size());
+    for(uint16_t k:keys) {
+      rotationFrames.push_back(k);
+      rotations.push_back(rot[k]);
+      }
+
+    auto posErr = [&](uint32_t a, uint32_t b, uint32_t j) {
+      const ZMath::float3 p = a==b ? pos[a] : lerp(pos[a],pos[b],float(j-a)/float(b-a));
+      return positionError(p,pos[j]);
+      };
+    maxPosErr = std::max(maxPosErr,reduceTrack(frames,params.positionTolerance,posErr,keys));
+    t.positionFirst = uint32_t(positionFrames.size());
+    t.positionCount = uint16_t(keys.size());
+    for(uint16_t k:keys) {
+      positionFrames.push_back(k);
+      positions.push_back(pos[k]);
+      }
+    }
+
+  rotationFrames.shrink_to_fit();
+  rotations     .shrink_to_fit();
+  positionFrames.shrink_to_fit();
+  positions     .shrink_to_fit();
+
+  if(stats!=nullptr) {
+    stats->numSamples      += all.size();
+    stats->rotationKeys    += rotations.size();
+    stats->positionKeys    += positions.size();
+    stats->sourceBytes     += ani.getSampleDataSize();
+    stats->compressedBytes += dataSize();
+    stats->maxRotationError = std::max(stats->maxRotationError,maxRotErr);
+    stats->maxPositionError = std::max(stats->maxPositionError,maxPosErr);
+    }
+  }
+
+size_t CompressedAnimation::findKey(const uint16_t* keyFrames, size_t count, float frame, float& t, size_t& next,
+                                    bool loop, uint32_t numFrames) {
+  if(count==1) {
+    t    = 0.f;
+    next = 0;
+    return 0;
+    }
+
+  // The first key is always frame 0 and the last one the last frame
+  const size_t k = size_t(std::upper_bound(keyFrames,keyFrames+count,frame)-keyFrames)-1;
+  if(k+1<count) {
+    next = k+1;
+    t    = (frame-float(keyFrames[k]))/float(keyFrames[next]-keyFrames[k]);
+    return k;
+    }
+  next = loop ? 0 : k;
+  t    = loop ? std::min(frame-float(numFrames-1),1.f) : 0.f;
+  return k;
+  }
+
+void CompressedAnimation::sampleNode(float frame, bool loop, size_t node, zCModelAni::AniSample& out) const {
+  const Track& tr = tracks[node];
+  const float  f  = wrapFrame(frame,loop,frames);
+
+  float  t    = 0.f;
+  size_t next = 0;
+  size_t k    = findKey(&rotationFrames[tr.rotationFirst],tr.rotationCount,f,t,next,loop,frames);
+  const ZMath::float4* rot = &rotations[tr.rotationFirst];
+  out.rotation = (k==next) ? rot[k] : quatNlerp(rot[k],rot[next],t);
+
+  k = findKey(&positionFrames[tr.positionFirst],tr.positionCount,f,t,next,loop,frames);
+  const ZMath::float3* pos = &positions[tr.positionFirst];
+  out.position = (k==next) ? pos[k] : lerp(pos[k],pos[next],t);
+  }
+
+void CompressedAnimation::sample(float frame, bool loop, zCModelAni::AniSample* out) const {
+  for(size_t i=0; i<tracks.size(); ++i)
+    sampleNode(frame,loop,i,out[i]);
+  }
+
+size_t CompressedAnimation::dataSize() const {
+  return tracks.size()*sizeof(Track) +
+         rotationFrames.size()*sizeof(uint16_t) + rotations.size()*sizeof(ZMath::float4) +
+         positionFrames.size()*sizeof(uint16_t) + positions.size()*sizeof(ZMath::float3);
+  }
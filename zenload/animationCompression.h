@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "zCModelAni.h"
+
+namespace ZenLoad
+{
+/**
+ * @brief Error bounds of the key reduction
+ */
+struct AnimationCompressionParams {
+  float rotationTolerance = 0.002f;  // Largest angle between the original and the interpolated rotation, in radians
+  float positionTolerance = 0.05f;   // Largest distance between the original and the interpolated position
+  };
+
+/**
+ * @brief Outcome of a key reduction, sums up when passed to several builds
+ */
+struct AnimationCompressionStats {
+  size_t numSamples        = 0;  // Samples of the source, one per node and frame
+  size_t rotationKeys      = 0;
+  size_t positionKeys      = 0;
+  size_t sourceBytes       = 0;  // Memory of the source samples, see zCModelAni::getSampleDataSize
+  size_t compressedBytes   = 0;
+  float  maxRotationError  = 0.f;
+  float  maxPositionError  = 0.f;
+  };
+
+/**
+ * @brief Animation with the keys of every node reduced to the ones that can't be interpolated
+ *        from their neighbours. Rotation and position tracks are reduced separately, constant
+ *        tracks end up with a single key.
+ *
+ * Key frames and values are stored in flat arrays, the tracks index into them.
+ */
+class CompressedAnimation {
+  public:
+    void build(const zCModelAni& ani, const AnimationCompressionParams& params = AnimationCompressionParams(),
+               AnimationCompressionStats* stats = nullptr);
+
+    /**
+     * @brief Samples all nodes at a fractional frame, the same way PoseEvaluator blends the full samples
+     * @param loop Blend past the last frame into the first one, otherwise clamp
+     * @param out numNodes samples
+     */
+    void sample(float frame, bool loop, zCModelAni::AniSample* out) const;
+
+    /**
+     * @brief Samples a single node
+     */
+    void sampleNode(float frame, bool loop, size_t node, zCModelAni::AniSample& out) const;
+
+    uint32_t numNodes()  const { return uint32_t(tracks.size()); }
+    uint32_t numFrames() const { return frames; }
+
+    /**
+     * @return Memory used by tracks and keys in bytes
+     */
+    size_t dataSize() const;
+
+  private:
+    struct Track {
+      uint32_t rotationFirst;  // Index into rotationFrames/rotations
+      uint32_t positionFirst;  // Index into positionFrames/positions
+      uint16_t rotationCount;
+      uint16_t positionCount;
+      };
+
+    static size_t findKey(const uint16_t* keyFrames, size_t count, float frame, float& t, size_t& next,
+                          bool loop, uint32_t numFrames);
+
+    uint32_t                   frames = 0;
+    std::vector<Track>         tracks;
+    std::vector<uint16_t>      rotationFrames;
+    std::vector<ZMath::float4> rotations;
+    std::vector<uint16_t>      positionFrames;
+    std::vector<ZMath::float3> positions;
+  };
+}  // namespace ZenLoad
@@ -0,0 +1,160 @@
+#include "animationEvents.h"
+
+#include <algorithm>
+
+#include "modelScriptParser.h"
+
+using namespace ZenLoad;
+
+StringPool::StringPool() {
+  strings.emplace_back();
+  ids[std::string()] = 0;
+  }
+
+uint32_t StringPool::intern(const std::string& s) {
+  auto it = ids.find(s);
+  if(it!=ids.end())
+    return it->second;
+  const uint32_t id = uint32_t(strings.size());
+  strings.push_back(s);
+  ids[s] = id;
+  return id;
+  }
+
+uint32_t StringPool::find(const std::string& s) const {
+  auto it = ids.find(s);
+  return it==ids.end() ? 0 : it->second;
+  }
+
+void AnimationEventTimeline::add(const zCModelAni& ani) {
+  for(const zCModelAni::zCModelAniEvent& e:ani.getAniEvents()) {
+    AnimationEvent ev;
+    ev.frame = int32_t(e.frameNr);
+    ev.kind  = AnimationEvent::K_ANI_EVENT;
+    ev.def   = uint8_t(e.aniEventType);
+    ev.name  = strings->intern(e.tagString);
+    ev.arg   = strings->intern(e.string[0]);
+    ev.arg2  = strings->intern(e.string[1]);
+    ev.value = e.values[0];
+    ev.prob  = e.prob;
+    list.push_back(ev);
+    }
+  }
+
+void AnimationEventTimeline::add(MdsParser& parser) {
+  for(auto& e:parser.sfx)
+    add(e,false);
+  for(auto& e:parser.gfx)
+    add(e,true);
+  for(auto& e:parser.pfx)
+    add(e);
+  for(auto& e:parser.pfxStop)
+    add(e);
+  for(auto& e:parser.eventTag)
+    add(e);
+  for(auto& e:parser.mmStartAni)
+    add(e);
+
+  parser.sfx.clear();
+  parser.gfx.clear();
+  parser.pfx.clear();
+  parser.pfxStop.clear();
+  parser.eventTag.clear();
+  parser.mmStartAni.clear();
+  }
+
+void AnimationEventTimeline::add(const zCModelScriptEventSfx& e, bool ground) {
+  AnimationEvent ev;
+  ev.frame = e.m_Frame;
+  ev.kind  = ground ? AnimationEvent::K_SFX_GROUND : AnimationEvent::K_SFX;
+  ev.flags = e.m_EmptySlot ? AnimationEvent::F_EMPTY_SLOT : 0;
+  ev.name  = strings->intern(e.m_Name);
+  ev.value = e.m_Range;
+  list.push_back(ev);
+  }
+
+void AnimationEventTimeline::add(const zCModelScriptEventPfx& e) {
+  AnimationEvent ev;
+  ev.frame = e.m_Frame;
+  ev.kind  = AnimationEvent::K_PFX;
+  ev.flags = e.m_isAttached ? AnimationEvent::F_ATTACHED : 0;
+  ev.name  = strings->intern(e.m_Name);
+  ev.arg   = strings->intern(e.m_Pos);
+  ev.num   = e.m_Num;
+  list.push_back(ev);
+  }
+
+void AnimationEventTimeline::add(const zCModelScriptEventPfxStop& e) {
+  AnimationEvent ev;
+  ev.frame = e.m_Frame;
+  ev.kind  = AnimationEvent::K_PFX_STOP;
+  ev.num   = e.m_Num;
+  list.push_back(ev);
+  }
+
+void AnimationEventTimeline::add(const zCModelEvent& e) {
+  AnimationEvent ev;
+  ev.frame     = e.m_Frame;
+  ev.kind      = AnimationEvent::K_TAG;
+  ev.def       = uint8_t(e.m_Def);
+  ev.fightMode = uint8_t(e.m_Fmode);
+  ev.name      = strings->intern(e.m_Slot);
+  ev.arg       = strings->intern(e.m_Item);
+  ev.arg2      = strings->intern(e.m_Slot2);
+  ev.intFirst  = uint32_t(intList.size());
+  ev.intCount  = uint32_t(e.m_Int.size());
+  intList.insert(intList.end(),e.m_Int.begin(),e.m_Int.end());
+  list.push_back(ev);
+  }
+
+void AnimationEventTimeline::add(const zCModelScriptEventMMStartAni& e) {
+  AnimationEvent ev;
+  ev.frame = e.m_Frame;
+  ev.kind  = AnimationEvent::K_MM_START_ANI;
+  ev.name  = strings->intern(e.m_Animation);
+  ev.arg   = strings->intern(e.m_Node);
+  list.push_back(ev);
+  }
+
+void AnimationEventTimeline::finalize() {
+  std::stable_sort(list.begin(),list.end(),[](const AnimationEvent& a, const AnimationEvent& b){
+    return a.frame<b.frame;
+    });
+  list   .shrink_to_fit();
+  intList.shrink_to_fit();
+  }
+
+void AnimationEventTimeline::clear() {
+  list.clear();
+  intList.clear();
+  }
+
+AnimationEventTimeline::Range AnimationEventTimeline::range(int32_t first, int32_t end) const {
+  Range r;
+  if(end<=first || list.empty())
+    return r;
+  auto less = [](const AnimationEvent& e, int32_t f){ return e.frame<f; };
+  const AnimationEvent* b = list.data();
+  const AnimationEvent* e = list.data()+list.size();
+  r.first = std::lower_bound(b,e,first,less);
+  r.last  = std::lower_bound(r.first,e,end,less);
+  return r;
+  }
+
+size_t AnimationEventTimeline::rangeLooped(int32_t first, int32_t end, Range out[2]) const {
+  if(list.empty())
+    return 0;
+  if(first<=end) {
+    out[0] = range(first,end);
+    return out[0].empty() ? 0 : 1;
+    }
+
+  size_t n = 0;
+  Range  tail = range(first,list.back().frame+1);
+  Range  head = range(list.front().frame,end);
+  if(!tail.empty())
+    out[n++] = tail;
+  if(!head.empty())
+    out[n++] = head;
+  return n;
+  }
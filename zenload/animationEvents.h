@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "zCModelAni.h"
+#include "zCModelScript.h"
+
+namespace ZenLoad
+{
+class MdsParser;
+
+/**
+ * @brief Deduplicated strings, referred to by index. Index 0 is the empty string.
+ *        Not thread-safe, meant to be filled while loading.
+ */
+class StringPool {
+  public:
+    StringPool();
+
+    uint32_t           intern(const std::string& s);
+    const std::string& get(uint32_t id) const { return strings[id]; }
+
+    /**
+     * @return Id of the string, 0 if it was never interned
+     */
+    uint32_t find(const std::string& s) const;
+
+    size_t size() const { return strings.size(); }
+
+  private:
+    std::vector<std::string>                 strings;
+    std::unordered_map<std::string,uint32_t> ids;
+  };
+
+/**
+ * @brief One event of an animation, from the .MAN file or the model script
+ */
+struct AnimationEvent {
+  enum Kind : uint8_t {
+    K_SFX,           // zCModelScriptEventSfx:        name=sound, value=range, flags=F_EMPTY_SLOT
+    K_SFX_GROUND,    // Same as K_SFX, for the ground sound
+    K_PFX,           // zCModelScriptEventPfx:        name=effect, arg=node, num=id, flags=F_ATTACHED
+    K_PFX_STOP,      // zCModelScriptEventPfxStop:    num=id
+    K_TAG,           // zCModelEvent:                 def, fightMode, name=slot, arg=item, arg2=slot2, ints
+    K_MM_START_ANI,  // zCModelScriptEventMMStartAni: name=animation, arg=node
+    K_ANI_EVENT,     // zCModelAni::zCModelAniEvent:  def=zTMdl_AniEventType, name=tag, arg/arg2=first strings,
+                     //                               value=first value, prob
+    };
+
+  enum Flags : uint8_t {
+    F_EMPTY_SLOT = 1 << 0,
+    F_ATTACHED   = 1 << 1,
+    };
+
+  int32_t  frame     = 0;
+  Kind     kind      = K_TAG;
+  uint8_t  def       = 0;  // EModelScriptAniDef or zTMdl_AniEventType, depending on kind
+  uint8_t  fightMode = 0;  // EFightMode
+  uint8_t  flags     = 0;
+  uint32_t name      = 0;  // Strings are ids into the StringPool of the timeline
+  uint32_t arg       = 0;
+  uint32_t arg2      = 0;
+  int32_t  num       = 0;
+  float    value     = 0.f;
+  float    prob      = 1.f;
+  uint32_t intFirst  = 0;  // Integer arguments (zCModelEvent::m_Int), see AnimationEventTimeline::ints
+  uint32_t intCount  = 0;
+  };
+
+/**
+ * @brief All events of one animation, merged and sorted by frame. Events on the same frame keep their source order.
+ */
+class AnimationEventTimeline {
+  public:
+    struct Range {
+      const AnimationEvent* first = nullptr;
+      const AnimationEvent* last  = nullptr;
+
+      const AnimationEvent* begin() const { return first; }
+      const AnimationEvent* end()   const { return last;  }
+      size_t                size()  const { return size_t(last-first); }
+      bool                  empty() const { return first==last; }
+      };
+
+    explicit AnimationEventTimeline(StringPool& strings):strings(&strings){}
+
+    /**
+     * @brief Adds the events stored in the .MAN file
+     */
+    void add(const zCModelAni& ani);
+
+    /**
+     * @brief Adds the sfx, pfx, tag and morph-mesh events collected by the parser, after the animation
+     *        they belong to. Model tags are not animation events and are left out.
+     *
+     * The parser appends to its event lists for the whole script, so they are cleared here: the next call
+     * only gets the events parsed after this one, i.e. those of the next animation.
+     */
+    void add(MdsParser& parser);
+
+    void add(const zCModelScriptEventSfx& e, bool ground);
+    void add(const zCModelScriptEventPfx& e);
+    void add(const zCModelScriptEventPfxStop& e);
+    void add(const zCModelEvent& e);
+    void add(const zCModelScriptEventMMStartAni& e);
+
+    /**
+     * @brief Sorts the events added so far. Queries are only valid after this.
+     */
+    void finalize();
+
+    void clear();
+
+    /**
+     * @return Events with first <= frame < end
+     */
+    Range range(int32_t first, int32_t end) const;
+
+    /**
+     * @brief Events between two positions of a looping animation. If end<first the animation wrapped:
+     *        the events from first to the end of the timeline come first, then the ones from the start to end.
+     * @return Number of ranges written to out
+     */
+    size_t rangeLooped(int32_t first, int32_t end, Range out[2]) const;
+
+    const std::vector<AnimationEvent>& events() const { return list; }
+    const int32_t*                     ints(const AnimationEvent& e) const { return intList.data()+e.intFirst; }
+    const std::string&                 str(uint32_t id) const { return strings->get(id); }
+
+  private:
+    StringPool*                 strings = nullptr;
+    std::vector<AnimationEvent> list;
+    std::vector<int32_t>        intList;
+  };
+}  // namespace ZenLoad
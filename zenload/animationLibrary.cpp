@@ -0,0 +1,90 @@
+#include "animationLibrary.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "parallel.h"
+#include "utils/split.h"
+#include "vdfs/fileIndex.h"
+
+using namespace ZenLoad;
+
+const AnimationLibrary::Handle AnimationLibrary::INVALID_HANDLE;
+
+size_t AnimationLibrary::load(const std::vector<std::string>& files, const VDFS::FileIndex& index,
+                              std::vector<Handle>& handles, float scale, size_t numThreads) {
+  // Parse quantized first, so the size of the pool is known before anything is expanded.
+  // The constructor folds the scale into the position decoding of quantized animations.
+  std::vector<std::unique_ptr<zCModelAni>> parsed(files.size());
+  parallelFor(files.size(),numThreads,[&](size_t i, size_t) {
+    parsed[i].reset(new zCModelAni(files[i],index,scale,true));
+    });
+
+  handles.resize(files.size());
+  size_t sampleEnd = samples.size();
+  size_t nodeEnd   = nodeIndices.size();
+  size_t loaded    = 0;
+  for(size_t i=0; i<files.size(); ++i) {
+    const zCModelAni&                 ani = *parsed[i];
+    const zCModelAni::ModelAniHeader& h   = ani.getModelAniHeader();
+    if(!parsed[i]->isValid() || ani.getNumSamples()!=size_t(h.numFrames)*h.numNodes ||
+       ani.getNodeIndexList().size()!=h.numNodes || h.numFrames==0) {
+      handles[i] = INVALID_HANDLE;
+      parsed[i].reset();
+      continue;
+      }
+
+    Animation a;
+    a.header      = h;
+    a.events      = ani.getAniEvents();
+    a.sampleFirst = sampleEnd;
+    a.nodeFirst   = nodeEnd;
+    sampleEnd += ani.getNumSamples();
+    nodeEnd   += h.numNodes;
+
+    handles[i] = Handle(animations.size());
+    names[Utils::baseName(files[i])] = handles[i];
+    animations.push_back(std::move(a));
+    ++loaded;
+    }
+
+  samples    .resize(sampleEnd);
+  nodeIndices.resize(nodeEnd);
+  parallelFor(files.size(),numThreads,[&](size_t i, size_t) {
+    if(handles[i]==INVALID_HANDLE)
+      return;
+    const Animation&  a   = animations[handles[i]];
+    const zCModelAni& ani = *parsed[i];
+    zCModelAni::unpackSamples(ani.getPackedSamples().data(),&samples[a.sampleFirst],ani.getNumSamples(),
+                              ani.getSamplePosScaler(),ani.getSamplePosRangeMin());
+    std::copy(ani.getNodeIndexList().begin(),ani.getNodeIndexList().end(),nodeIndices.begin()+a.nodeFirst);
+    parsed[i].reset();
+    });
+  return loaded;
+  }
+
+void AnimationLibrary::clear() {
+  animations .clear();
+  samples    .clear();
+  nodeIndices.clear();
+  names      .clear();
+  }
+
+AnimationView AnimationLibrary::get(Handle h) const {
+  AnimationView v;
+  if(h>=animations.size())
+    return v;
+  const Animation& a = animations[h];
+  v.header      = &a.header;
+  v.samples     = samples.data()+a.sampleFirst;
+  v.nodeIndices = nodeIndices.data()+a.nodeFirst;
+  v.events      = &a.events;
+  v.numFrames   = a.header.numFrames;
+  v.numNodes    = a.header.numNodes;
+  return v;
+  }
+
+AnimationLibrary::Handle AnimationLibrary::find(const std::string& file) const {
+  auto it = names.find(Utils::baseName(file));
+  return it==names.end() ? INVALID_HANDLE : it->second;
+  }
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "zCModelAni.h"
+
+namespace VDFS
+{
+class FileIndex;
+}
+
+namespace ZenLoad
+{
+/**
+ * @brief One animation of an AnimationLibrary. Points into the pools of the library,
+ *        valid until the next load() or clear().
+ */
+struct AnimationView {
+  const zCModelAni::ModelAniHeader*                 header      = nullptr;
+  const zCModelAni::AniSample*                      samples     = nullptr;  // Access: frame * numNodes + node
+  const uint32_t*                                   nodeIndices = nullptr;  // numNodes, like zCModelAni::getNodeIndexList
+  const std::vector<zCModelAni::zCModelAniEvent>*   events      = nullptr;
+  uint32_t                                          numFrames   = 0;
+  uint32_t                                          numNodes    = 0;
+
+  bool                         isValid() const { return samples!=nullptr; }
+  const zCModelAni::AniSample* frame(size_t f) const { return samples+f*numNodes; }
+  };
+
+/**
+ * @brief Loads many .MAN files on a set of worker threads into one sample pool.
+ *
+ * Files are parsed quantized, then all samples are expanded straight into the pool with the load-scale
+ * folded into the position decoding, so no animation owns buffers of its own.
+ */
+class AnimationLibrary {
+  public:
+    using Handle = uint32_t;
+    static const Handle INVALID_HANDLE = uint32_t(-1);
+
+    /**
+     * @param files Animations to load, e.g. HUMANS-S_RUN.MAN
+     * @param handles One per file, INVALID_HANDLE for files which couldn't be loaded
+     * @param scale Scale applied to the sample positions, as in zCModelAni
+     * @param numThreads Number of threads to load on, 1 loads on the calling thread
+     * @return Number of animations loaded
+     */
+    size_t load(const std::vector<std::string>& files, const VDFS::FileIndex& index, std::vector<Handle>& handles,
+                float scale = 1.0f, size_t numThreads = 1);
+
+    void clear();
+
+    AnimationView get(Handle h) const;
+
+    /**
+     * @return Handle of a loaded file, the name is compared without extension and case
+     */
+    Handle find(const std::string& file) const;
+
+    size_t size() const { return animations.size(); }
+
+    /**
+     * @return Memory used by the sample and node pools in bytes
+     */
+    size_t dataSize() const {
+      return samples.size()*sizeof(zCModelAni::AniSample) + nodeIndices.size()*sizeof(uint32_t);
+      }
+
+  private:
+    struct Animation {
+      zCModelAni::ModelAniHeader               header = {};
+      std::vector<zCModelAni::zCModelAniEvent> events;
+      size_t                                   sampleFirst = 0;
+      size_t                                   nodeFirst   = 0;
+      };
+
+    std::vector<Animation>                 animations;
+    std::vector<zCModelAni::AniSample>     samples;
+    std::vector<uint32_t>                  nodeIndices;
+    std::unordered_map<std::string,Handle> names;
+  };
+}  // namespace ZenLoad
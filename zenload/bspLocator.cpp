@@ -0,0 +1,104 @@
+#include "bspLocator.h"
+
+using namespace ZenLoad;
+
+const uint32_t BspLocator::NO_LEAF;
+const uint32_t BspLocator::LEAF_BIT;
+
+void BspLocator::build(const zCBspTreeData& tree) {
+  nodes.clear();
+  leafSectors.assign(tree.leafIndices.size(),SECTOR_INDEX_INVALID);
+  root = NO_LEAF;
+
+  for(size_t s=0; s<tree.sectors.size(); ++s) {
+    for(uint32_t leaf:tree.sectors[s].bspNodeIndices)
+      if(leaf<leafSectors.size() && leafSectors[leaf]==SECTOR_INDEX_INVALID)
+        leafSectors[leaf] = SectorIndex(s);
+    }
+
+  if(tree.nodes.empty())
+    return;
+
+  std::vector<uint32_t> leafOf(tree.nodes.size(),NO_LEAF);
+  for(size_t i=0; i<tree.leafIndices.size(); ++i)
+    if(tree.leafIndices[i]<leafOf.size())
+      leafOf[tree.leafIndices[i]] = uint32_t(i);
+
+  // Reference to a source node: leaves resolve directly, inner nodes get a slot reserved
+  auto ref = [&](uint32_t src) -> uint32_t {
+    if(src>=tree.nodes.size())
+      return NO_LEAF;
+    const zCBspNode& n = tree.nodes[src];
+    if(n.front==zCBspNode::INVALID_NODE && n.back==zCBspNode::INVALID_NODE)
+      return leafOf[src]==NO_LEAF ? NO_LEAF : (leafOf[src] | LEAF_BIT);
+    nodes.emplace_back();
+    return uint32_t(nodes.size()-1);
+    };
+
+  struct Item {
+    uint32_t src;
+    uint32_t dst;
+    };
+  std::vector<Item> stack;
+
+  nodes.reserve(tree.nodes.size()-tree.leafIndices.size());
+  root = ref(0);
+  if(root & LEAF_BIT)
+    return;
+  stack.push_back({0,root});
+  while(!stack.empty()) {
+    const Item       it = stack.back();
+    const zCBspNode& n  = tree.nodes[it.src];
+    stack.pop_back();
+
+    Node& dst = nodes[it.dst];
+    dst.plane[0] = n.plane.x;
+    dst.plane[1] = n.plane.y;
+    dst.plane[2] = n.plane.z;
+    dst.plane[3] = n.plane.w;
+    dst.pad[0]   = 0;
+    dst.pad[1]   = 0;
+
+    // Front is allocated first and popped first, so it directly follows its parent
+    const uint32_t front = ref(n.front);
+    const uint32_t back  = ref(n.back);
+    nodes[it.dst].child[0] = front;
+    nodes[it.dst].child[1] = back;
+    if(!(back & LEAF_BIT))
+      stack.push_back({n.back,back});
+    if(!(front & LEAF_BIT))
+      stack.push_back({n.front,front});
+    }
+  }
+
+uint32_t BspLocator::locateLeaf(const ZMath::float3& p) const {
+  uint32_t cur = root;
+  while(!(cur & LEAF_BIT))
+    cur = step(cur,p);
+  return toLeaf(cur);
+  }
+
+void BspLocator::locateLeaf(const ZMath::float3* points, uint32_t* leaves, size_t count) const {
+  size_t i = 0;
+  for(; i+4<=count; i+=4) {
+    uint32_t c0 = root, c1 = root, c2 = root, c3 = root;
+    while(!(c0 & c1 & c2 & c3 & LEAF_BIT)) {
+      if(!(c0 & LEAF_BIT)) c0 = step(c0,points[i+0]);
+      if(!(c1 & LEAF_BIT)) c1 = step(c1,points[i+1]);
+      if(!(c2 & LEAF_BIT)) c2 = step(c2,points[i+2]);
+      if(!(c3 & LEAF_BIT)) c3 = step(c3,points[i+3]);
+      }
+    leaves[i+0] = toLeaf(c0);
+    leaves[i+1] = toLeaf(c1);
+    leaves[i+2] = toLeaf(c2);
+    leaves[i+3] = toLeaf(c3);
+    }
+  for(; i<count; ++i)
+    leaves[i] = locateLeaf(points[i]);
+  }
+
+void BspLocator::sectorOf(const ZMath::float3* points, SectorIndex* sectors, size_t count) const {
+  locateLeaf(points,sectors,count);
+  for(size_t i=0; i<count; ++i)
+    sectors[i] = leafSector(sectors[i]);
+  }
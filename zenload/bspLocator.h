@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "utils/alignment.h"
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+/**
+ * @brief Point location in the BSP-tree loaded by zCBspTree::readObjectData.
+ *        The planes are repacked into 32 byte nodes (two per cache line) in depth-first order,
+ *        with the front child following its parent.
+ */
+class BspLocator {
+  public:
+    static const uint32_t NO_LEAF = uint32_t(-1);
+
+    BspLocator() = default;
+    explicit BspLocator(const zCBspTreeData& tree) { build(tree); }
+
+    void build(const zCBspTreeData& tree);
+
+    /**
+     * @return Index into zCBspTreeData::leafIndices of the leaf containing the point,
+     *         NO_LEAF if the point is in solid/empty space without a leaf
+     */
+    uint32_t locateLeaf(const ZMath::float3& p) const;
+
+    /**
+     * @brief Batched locateLeaf(). Walks several points through the tree at once to overlap the memory loads.
+     */
+    void locateLeaf(const ZMath::float3* points, uint32_t* leaves, size_t count) const;
+
+    /**
+     * @return Sector of the leaf containing the point, SECTOR_INDEX_INVALID if it isn't inside any sector (outdoors)
+     */
+    SectorIndex sectorOf(const ZMath::float3& p) const { return leafSector(locateLeaf(p)); }
+
+    /**
+     * @brief Batched sectorOf()
+     */
+    void sectorOf(const ZMath::float3* points, SectorIndex* sectors, size_t count) const;
+
+    /**
+     * @return Sector the given leaf belongs to, SECTOR_INDEX_INVALID for NO_LEAF or outdoor leaves.
+     *         Leaves listed by several sectors report the first one.
+     */
+    SectorIndex leafSector(uint32_t leaf) const {
+      return leaf<leafSectors.size() ? leafSectors[leaf] : SECTOR_INDEX_INVALID;
+      }
+
+    size_t leafCount() const { return leafSectors.size(); }
+    bool   isEmpty()   const { return root==NO_LEAF; }
+
+  private:
+    // Child references with LEAF_BIT set are leaves (or NO_LEAF)
+    static const uint32_t LEAF_BIT = 0x80000000;
+
+    struct Node {
+      float    plane[4];  // Normal and distance, the front side is dot(normal,p)>=distance
+      uint32_t child[2];  // Front and back
+      uint32_t pad[2];
+      };
+
+    uint32_t step(uint32_t node, const ZMath::float3& p) const {
+      const Node& n = nodes[node];
+      const float d = n.plane[0]*p.x + n.plane[1]*p.y + n.plane[2]*p.z - n.plane[3];
+      return n.child[d>=0.f ? 0 : 1];
+      }
+
+    static uint32_t toLeaf(uint32_t ref) { return ref==NO_LEAF ? NO_LEAF : (ref & ~LEAF_BIT); }
+
+    std::vector<Node,Utils::AlignedAllocator<Node,64>> nodes;
+    std::vector<SectorIndex>                           leafSectors;
+    uint32_t                                           root = NO_LEAF;
+  };
+}  // namespace ZenLoad
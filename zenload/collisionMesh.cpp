@@ -0,0 +1,148 @@
+#include "collisionMesh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "materialRegistry.h"
+
+using namespace ZenLoad;
+
+namespace {
+struct WeldKey {
+  int64_t v[3];
+  bool operator==(const WeldKey& k) const { return v[0]==k.v[0] && v[1]==k.v[1] && v[2]==k.v[2]; }
+  };
+
+struct WeldKeyHash {
+  size_t operator()(const WeldKey& k) const {
+    uint64_t h = uint64_t(k.v[0])*0x9E3779B97F4A7C15ull;
+    h ^= uint64_t(k.v[1])*0xC2B2AE3D27D4EB4Full + (h<<6) + (h>>2);
+    h ^= uint64_t(k.v[2])*0x165667B19E3779F9ull + (h<<6) + (h>>2);
+    return size_t(h ^ (h>>29));
+    }
+  };
+}
+
+static WeldKey weldKey(const ZMath::float3& p, float invTolerance) {
+  WeldKey k;
+  for(int i=0; i<3; ++i) {
+    if(invTolerance>0.f) {
+      k.v[i] = int64_t(std::floor(double(p.v[i])*invTolerance+0.5));
+      } else {
+      const float f = p.v[i]==0.f ? 0.f : p.v[i];  // -0 and +0 weld together
+      uint32_t    bits;
+      std::memcpy(&bits,&f,sizeof(bits));
+      k.v[i] = bits;
+      }
+    }
+  return k;
+  }
+
+CollisionMesh::Triangle ZenLoad::makeCollisionTriangle(const PolyFlags& flags, int16_t material,
+                                                       const std::vector<MaterialId>& materials) {
+  CollisionMesh::Triangle t;
+  t.material    = uint16_t(material);
+  t.sectorIndex = flags.sectorIndex;
+  if(flags.sectorPoly)
+    t.flags |= CollisionMesh::TF_SECTOR_POLY;
+  if(flags.occluder)
+    t.flags |= CollisionMesh::TF_OCCLUDER;
+  if(flags.noDynLightNear)
+    t.flags |= CollisionMesh::TF_NO_DYN_LIGHT;
+  if(flags.lodFlag)
+    t.flags |= CollisionMesh::TF_LOD;
+  if(material>=0 && size_t(material)<materials.size() && materials[material]!=MATERIAL_ID_INVALID) {
+    const zCMaterialData& m = MaterialRegistry::global().get(materials[material]);
+    t.matGroup = m.matGroup;
+    if(m.noCollDet)
+      t.flags |= CollisionMesh::TF_NO_COLLISION;
+    }
+  return t;
+  }
+
+void ZenLoad::buildCollisionMesh(const ZMath::float3* positions, const uint32_t* indices,
+                                 const CollisionMesh::Triangle* triangles, size_t numTriangles,
+                                 const std::vector<MaterialId>& materials, CollisionMesh& out,
+                                 const CollisionMeshOptions& options) {
+  out.vertices.clear();
+  out.indices.clear();
+  out.triangles.clear();
+  out.materials = materials;
+  out.bbox[0]   = ZMath::float3( FLT_MAX, FLT_MAX, FLT_MAX);
+  out.bbox[1]   = ZMath::float3(-FLT_MAX,-FLT_MAX,-FLT_MAX);
+
+  const float invTolerance = options.weldTolerance>0.f ? 1.f/options.weldTolerance : 0.f;
+
+  uint32_t maxIndex = 0;
+  for(size_t i=0; i<numTriangles*3; ++i)
+    maxIndex = std::max(maxIndex,indices[i]);
+
+  std::unordered_map<WeldKey,uint32_t,WeldKeyHash> welded;
+  std::vector<uint32_t>                            remap(numTriangles>0 ? size_t(maxIndex)+1 : 0,uint32_t(-1));
+  welded.reserve(numTriangles);
+  out.indices  .reserve(numTriangles*3);
+  out.triangles.reserve(numTriangles);
+
+  auto vertex = [&](uint32_t src) -> uint32_t {
+    if(remap[src]!=uint32_t(-1))
+      return remap[src];
+    const ZMath::float3& p = positions[src];
+    auto                 w = welded.emplace(weldKey(p,invTolerance),uint32_t(out.vertices.size()));
+    if(w.second) {
+      out.vertices.push_back(p);
+      for(int i=0; i<3; ++i) {
+        out.bbox[0].v[i] = std::min(out.bbox[0].v[i],p.v[i]);
+        out.bbox[1].v[i] = std::max(out.bbox[1].v[i],p.v[i]);
+        }
+      }
+    remap[src] = w.first->second;
+    return w.first->second;
+    };
+
+  for(size_t i=0; i<numTriangles; ++i) {
+    const CollisionMesh::Triangle& t = triangles[i];
+    if(options.skipNoCollision && (t.flags & CollisionMesh::TF_NO_COLLISION))
+      continue;
+    const uint32_t a = vertex(indices[i*3+0]);
+    const uint32_t b = vertex(indices[i*3+1]);
+    const uint32_t c = vertex(indices[i*3+2]);
+    if(options.dropDegenerate && (a==b || b==c || a==c))
+      continue;
+    out.indices.push_back(a);
+    out.indices.push_back(b);
+    out.indices.push_back(c);
+    out.triangles.push_back(t);
+    }
+
+  if(out.vertices.empty()) {
+    out.bbox[0] = ZMath::float3(0,0,0);
+    out.bbox[1] = ZMath::float3(0,0,0);
+    }
+  }
+
+void ZenLoad::buildCollisionMesh(const PackedMesh& mesh, CollisionMesh& out, const CollisionMeshOptions& options) {
+  const size_t numTris      = mesh.indices.size()/3;
+  const bool   hasTriangles = mesh.triangles.size()==numTris;
+
+  std::vector<MaterialId> materials(mesh.subMeshes.size());
+  for(size_t i=0; i<mesh.subMeshes.size(); ++i)
+    materials[i] = mesh.subMeshes[i].materialId;
+
+  std::vector<ZMath::float3> positions(mesh.vertices.size());
+  for(size_t i=0; i<mesh.vertices.size(); ++i)
+    positions[i] = mesh.vertices[i].Position;
+
+  std::vector<CollisionMesh::Triangle> tris(numTris);
+  PolyFlags noFlags;
+  std::memset(&noFlags,0,sizeof(noFlags));
+  for(size_t s=0; s<mesh.subMeshes.size(); ++s) {
+    const auto& sm = mesh.subMeshes[s];
+    for(size_t i=sm.indexOffset/3; i<(sm.indexOffset+sm.indexSize)/3 && i<numTris; ++i)
+      tris[i] = makeCollisionTriangle(hasTriangles ? mesh.triangles[i].flags : noFlags,int16_t(s),materials);
+    }
+
+  buildCollisionMesh(positions.data(),mesh.indices.data(),tris.data(),numTris,materials,out,options);
+  }
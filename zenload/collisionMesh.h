@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+/**
+ * @brief Per-triangle record of a polygon with the given flags and material
+ * @param material Index of the material, -1 if none
+ * @param materials Material list the index refers to, ids into MaterialRegistry::global()
+ */
+CollisionMesh::Triangle makeCollisionTriangle(const PolyFlags& flags, int16_t material,
+                                              const std::vector<MaterialId>& materials);
+
+/**
+ * @brief Welds the positions of indexed triangles and fills a CollisionMesh with them.
+ *        Only positions referenced by the indices end up in the output.
+ * @param triangles One record per triangle, its material indexes into materials
+ */
+void buildCollisionMesh(const ZMath::float3* positions, const uint32_t* indices,
+                        const CollisionMesh::Triangle* triangles, size_t numTriangles,
+                        const std::vector<MaterialId>& materials, CollisionMesh& out,
+                        const CollisionMeshOptions& options = CollisionMeshOptions());
+
+/**
+ * @brief CollisionMesh of an already packed mesh. Materials are the submeshes, flags are
+ *        taken from PackedMesh::triangles if present.
+ */
+void buildCollisionMesh(const PackedMesh& mesh, CollisionMesh& out,
+                        const CollisionMeshOptions& options = CollisionMeshOptions());
+}  // namespace ZenLoad
@@ -0,0 +1,281 @@
+#include "groundHeightGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "materialRegistry.h"
+#include "zCMesh.h"
+
+using namespace ZenLoad;
+
+const uint16_t GroundHeightGrid::NO_MATERIAL;
+
+static const uint32_t MAX_POINTS_PER_AXIS = 4096;
+static const uint32_t GRID_MAGIC          = 0x47484721;  // "!GHG"
+static const uint32_t GRID_VERSION        = 1;
+
+void GroundHeightGrid::build(const zCMesh& mesh, const GroundHeightGridParams& params) {
+  auto& indices  = mesh.getIndices();
+  auto& triMat   = mesh.getTriangleMaterialIndices();
+  auto& matList  = mesh.getMaterials();
+  const size_t numTris = indices.size()/3;
+
+  // Non-collidable surfaces (water, foliage) are dropped by moving them out of the index list
+  std::vector<uint32_t> solid;
+  std::vector<uint16_t> mats;
+  solid.reserve(numTris*3);
+  mats.reserve(numTris);
+  for(size_t i=0; i<numTris; ++i) {
+    const int16_t m = i<triMat.size() ? triMat[i] : -1;
+    if(m>=0 && size_t(m)<matList.size() && MaterialRegistry::global().get(matList[m]).noCollDet)
+      continue;
+    solid.insert(solid.end(),&indices[i*3],&indices[i*3]+3);
+    mats.push_back(m>=0 ? uint16_t(m) : NO_MATERIAL);
+    }
+  build(mesh.getVertices().data(),solid.data(),mats.size(),mats.data(),params);
+  }
+
+void GroundHeightGrid::build(const ZMath::float3* positions, const uint32_t* indices, size_t numTriangles,
+                             const uint16_t* triMaterials, const GroundHeightGridParams& params) {
+  pointStart.clear();
+  heights.clear();
+  materials.clear();
+  sizeX = sizeZ = 0;
+
+  const float minNormalY = std::cos(params.maxSlope*3.14159265f/180.f);
+
+  // Walkable triangles. Winding differs between sources, so both faces count.
+  std::vector<uint32_t> walkable;
+  float bmin[2] = { 1e30f, 1e30f};
+  float bmax[2] = {-1e30f,-1e30f};
+  for(size_t i=0; i<numTriangles; ++i) {
+    const ZMath::float3& a = positions[indices[i*3+0]];
+    const ZMath::float3& b = positions[indices[i*3+1]];
+    const ZMath::float3& c = positions[indices[i*3+2]];
+    const float e1[3] = {b.x-a.x,b.y-a.y,b.z-a.z};
+    const float e2[3] = {c.x-a.x,c.y-a.y,c.z-a.z};
+    const float n[3]  = {e1[1]*e2[2]-e1[2]*e2[1], e1[2]*e2[0]-e1[0]*e2[2], e1[0]*e2[1]-e1[1]*e2[0]};
+    const float len   = std::sqrt(n[0]*n[0]+n[1]*n[1]+n[2]*n[2]);
+    if(len<=0.f || std::fabs(n[1])<minNormalY*len)
+      continue;
+    walkable.push_back(uint32_t(i));
+    bmin[0] = std::min(bmin[0],std::min(a.x,std::min(b.x,c.x)));
+    bmin[1] = std::min(bmin[1],std::min(a.z,std::min(b.z,c.z)));
+    bmax[0] = std::max(bmax[0],std::max(a.x,std::max(b.x,c.x)));
+    bmax[1] = std::max(bmax[1],std::max(a.z,std::max(b.z,c.z)));
+    }
+  if(walkable.empty())
+    return;
+
+  // The extent covers at most MAX_POINTS_PER_AXIS-2 steps, so with the point past the last one the grid
+  // still fits the limit load() checks. The clamp only catches float rounding.
+  step    = std::max(params.spacing,std::max(bmax[0]-bmin[0],bmax[1]-bmin[1])/float(MAX_POINTS_PER_AXIS-2));
+  invStep = 1.f/step;
+  origin  = ZMath::float3(bmin[0],0,bmin[1]);
+  sizeX   = std::min(MAX_POINTS_PER_AXIS,uint32_t((bmax[0]-bmin[0])*invStep)+2);
+  sizeZ   = std::min(MAX_POINTS_PER_AXIS,uint32_t((bmax[1]-bmin[1])*invStep)+2);
+
+  struct Entry {
+    uint32_t point;
+    float    height;
+    uint16_t material;
+    bool operator<(const Entry& e) const { return point!=e.point ? point<e.point : height>e.height; }
+    };
+  std::vector<Entry> entries;
+
+  const float eps = 1e-4f;
+  for(uint32_t i:walkable) {
+    const ZMath::float3& a = positions[indices[i*3+0]];
+    const ZMath::float3& b = positions[indices[i*3+1]];
+    const ZMath::float3& c = positions[indices[i*3+2]];
+    const float e1x = b.x-a.x, e1z = b.z-a.z;
+    const float e2x = c.x-a.x, e2z = c.z-a.z;
+    const float det = e1x*e2z - e2x*e1z;
+    if(det==0.f)
+      continue;
+    const float inv = 1.f/det;
+
+    const float    minX = std::min(a.x,std::min(b.x,c.x)), maxX = std::max(a.x,std::max(b.x,c.x));
+    const float    minZ = std::min(a.z,std::min(b.z,c.z)), maxZ = std::max(a.z,std::max(b.z,c.z));
+    const uint32_t x0   = uint32_t(std::max(0.f,std::ceil ((minX-origin.x)*invStep)));
+    const uint32_t x1   = std::min(sizeX-1,uint32_t(std::floor((maxX-origin.x)*invStep)));
+    const uint32_t z0   = uint32_t(std::max(0.f,std::ceil ((minZ-origin.z)*invStep)));
+    const uint32_t z1   = std::min(sizeZ-1,uint32_t(std::floor((maxZ-origin.z)*invStep)));
+    const uint16_t mat  = triMaterials!=nullptr ? triMaterials[i] : NO_MATERIAL;
+
+    for(uint32_t z=z0; z<=z1 && z0<=z1; ++z) {
+      for(uint32_t x=x0; x<=x1 && x0<=x1; ++x) {
+        const float dx = origin.x+float(x)*step-a.x;
+        const float dz = origin.z+float(z)*step-a.z;
+        const float u  = ( e2z*dx - e2x*dz)*inv;
+        const float v  = (-e1z*dx + e1x*dz)*inv;
+        if(u<-eps || v<-eps || u+v>1.f+eps)
+          continue;
+        entries.push_back({z*sizeX+x, a.y+u*(b.y-a.y)+v*(c.y-a.y), mat});
+        }
+      }
+    }
+  std::sort(entries.begin(),entries.end());
+
+  // Keep the top surface of every cluster closer than layerGap
+  pointStart.assign(size_t(sizeX)*sizeZ+1,0);
+  for(size_t i=0; i<entries.size(); ++i) {
+    const Entry& e = entries[i];
+    if(i>0 && entries[i-1].point==e.point && heights.back()-e.height<params.layerGap)
+      continue;
+    heights.push_back(e.height);
+    materials.push_back(e.material);
+    pointStart[e.point+1]++;
+    }
+  for(size_t i=1; i<pointStart.size(); ++i)
+    pointStart[i] += pointStart[i-1];
+  }
+
+bool GroundHeightGrid::pointAt(float x, float z, uint32_t& point) const {
+  const float fx = (x-origin.x)*invStep+0.5f;
+  const float fz = (z-origin.z)*invStep+0.5f;
+  if(!(fx>=0.f && fz>=0.f && fx<float(sizeX) && fz<float(sizeZ)))
+    return false;
+  point = uint32_t(fz)*sizeX+uint32_t(fx);
+  return true;
+  }
+
+int32_t GroundHeightGrid::findLayer(uint32_t point, float y, float stepHeight) const {
+  for(uint32_t i=pointStart[point], end=pointStart[point+1]; i<end; ++i)
+    if(heights[i]<=y+stepHeight)
+      return int32_t(i);
+  return -1;
+  }
+
+bool GroundHeightGrid::sampleNearest(const ZMath::float3& pos, Sample& out, float stepHeight) const {
+  uint32_t point;
+  const int32_t l = pointAt(pos.x,pos.z,point) ? findLayer(point,pos.y,stepHeight) : -1;
+  if(l<0) {
+    out = Sample();
+    return false;
+    }
+  out.height   = heights[l];
+  out.material = materials[l];
+  return true;
+  }
+
+bool GroundHeightGrid::sample(const ZMath::float3& pos, Sample& out, float stepHeight) const {
+  if(!sampleNearest(pos,out,stepHeight))
+    return false;
+
+  const float fx = (pos.x-origin.x)*invStep;
+  const float fz = (pos.z-origin.z)*invStep;
+  if(!(fx>=0.f && fz>=0.f && fx<float(sizeX-1) && fz<float(sizeZ-1)))
+    return true;
+
+  const uint32_t ix = uint32_t(fx), iz = uint32_t(fz);
+  const uint32_t p  = iz*sizeX+ix;
+  const uint32_t corner[4] = {p, p+1, p+sizeX, p+sizeX+1};
+  float h[4];
+  for(int i=0; i<4; ++i) {
+    const int32_t l = findLayer(corner[i],pos.y,stepHeight);
+    if(l<0 || std::fabs(heights[l]-out.height)>stepHeight)
+      return true;  // Ledge or hole next to us, blending would pull the ground off the floor
+    h[i] = heights[l];
+    }
+
+  const float tx = fx-float(ix), tz = fz-float(iz);
+  out.height = (h[0]*(1.f-tx)+h[1]*tx)*(1.f-tz) + (h[2]*(1.f-tx)+h[3]*tx)*tz;
+  return true;
+  }
+
+size_t GroundHeightGrid::sample(const ZMath::float3* positions, Sample* out, size_t count, uint8_t* found, float stepHeight) const {
+  size_t ret = 0;
+  for(size_t i=0; i<count; ++i) {
+    const bool ok = sample(positions[i],out[i],stepHeight);
+    if(found!=nullptr)
+      found[i] = ok ? 1 : 0;
+    if(ok)
+      ++ret;
+    }
+  return ret;
+  }
+
+uint32_t GroundHeightGrid::layerCount(uint32_t x, uint32_t z) const {
+  if(x>=sizeX || z>=sizeZ)
+    return 0;
+  const uint32_t p = z*sizeX+x;
+  return pointStart[p+1]-pointStart[p];
+  }
+
+const float* GroundHeightGrid::layerHeights(uint32_t x, uint32_t z) const {
+  return layerCount(x,z)>0 ? &heights[pointStart[z*sizeX+x]] : nullptr;
+  }
+
+const uint16_t* GroundHeightGrid::layerMaterials(uint32_t x, uint32_t z) const {
+  return layerCount(x,z)>0 ? &materials[pointStart[z*sizeX+x]] : nullptr;
+  }
+
+void GroundHeightGrid::save(std::vector<uint8_t>& out) const {
+  auto put = [&out](const void* data, size_t size) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    out.insert(out.end(),p,p+size);
+    };
+  const uint32_t numLayers = uint32_t(heights.size());
+  put(&GRID_MAGIC,  sizeof(GRID_MAGIC));
+  put(&GRID_VERSION,sizeof(GRID_VERSION));
+  put(&origin,      sizeof(origin));
+  put(&step,        sizeof(step));
+  put(&sizeX,       sizeof(sizeX));
+  put(&sizeZ,       sizeof(sizeZ));
+  put(&numLayers,   sizeof(numLayers));
+  if(!pointStart.empty())
+    put(pointStart.data(),pointStart.size()*sizeof(uint32_t));
+  put(heights.data(),  heights.size()*sizeof(float));
+  put(materials.data(),materials.size()*sizeof(uint16_t));
+  }
+
+bool GroundHeightGrid::load(const uint8_t* data, size_t size) {
+  const uint8_t* at  = data;
+  const uint8_t* end = data+size;
+  auto get = [&](void* dst, size_t n) {
+    if(size_t(end-at)<n)
+      return false;
+    std::memcpy(dst,at,n);
+    at += n;
+    return true;
+    };
+
+  uint32_t      magic=0, version=0, sx=0, sz=0, numLayers=0;
+  ZMath::float3 org;
+  float         stp=0.f;
+  if(!get(&magic,4) || magic!=GRID_MAGIC || !get(&version,4) || version!=GRID_VERSION)
+    return false;
+  if(!get(&org,sizeof(org)) || !get(&stp,4) || !get(&sx,4) || !get(&sz,4) || !get(&numLayers,4))
+    return false;
+  if(sx>MAX_POINTS_PER_AXIS || sz>MAX_POINTS_PER_AXIS || (sx*sz>0 && !(stp>0.f)))
+    return false;
+
+  const size_t numPoints = size_t(sx)*sz;
+  const size_t expected  = (numPoints>0 ? (numPoints+1)*sizeof(uint32_t) : 0) + size_t(numLayers)*(sizeof(float)+sizeof(uint16_t));
+  if(size_t(end-at)<expected)
+    return false;
+
+  std::vector<uint32_t> start(numPoints>0 ? numPoints+1 : 0);
+  std::vector<float>    h(numLayers);
+  std::vector<uint16_t> m(numLayers);
+  get(start.data(),start.size()*sizeof(uint32_t));
+  get(h.data(),h.size()*sizeof(float));
+  get(m.data(),m.size()*sizeof(uint16_t));
+  for(size_t i=1; i<start.size(); ++i)
+    if(start[i]<start[i-1])
+      return false;
+  if(!start.empty() && (start.front()!=0 || start.back()!=numLayers))
+    return false;
+
+  origin     = org;
+  step       = stp;
+  invStep    = stp>0.f ? 1.f/stp : 0.f;
+  sizeX      = sx;
+  sizeZ      = sz;
+  pointStart = std::move(start);
+  heights    = std::move(h);
+  materials  = std::move(m);
+  return true;
+  }
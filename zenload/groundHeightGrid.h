@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+class zCMesh;
+
+struct GroundHeightGridParams {
+  float spacing  = 50.f;  // Distance between grid points in world units
+  float maxSlope = 60.f;  // Steepest walkable surface, in degrees
+  float layerGap = 20.f;  // Surfaces closer than this above one grid point are merged into one layer
+  };
+
+/**
+ * @brief Ground heights of the world baked into a regular grid over the xz-plane.
+ *
+ * Every grid point keeps one layer per walkable surface above it (bridges, upper floors, caves),
+ * sorted from top to bottom, with the material index of the surface. A query only reads the grid points
+ * around the position, so movement code can ask for the ground height without a raycast.
+ */
+class GroundHeightGrid {
+  public:
+    static const uint16_t NO_MATERIAL = uint16_t(-1);
+
+    struct Sample {
+      float    height   = 0.f;
+      uint16_t material = NO_MATERIAL;  // Index into zCMesh::getMaterials()
+      };
+
+    /**
+     * @brief Rasterizes the walkable triangles of the mesh. Materials flagged noCollDet are left out.
+     */
+    void build(const zCMesh& mesh, const GroundHeightGridParams& params = GroundHeightGridParams());
+
+    /**
+     * @brief Same as above, for raw triangles. materials may be null or hold one entry per triangle.
+     */
+    void build(const ZMath::float3* positions, const uint32_t* indices, size_t numTriangles,
+               const uint16_t* materials, const GroundHeightGridParams& params = GroundHeightGridParams());
+
+    /**
+     * @brief Finds the ground below pos: the highest layer at or below pos.y+stepHeight at the nearest grid point
+     * @return False if there is no ground below
+     */
+    bool sampleNearest(const ZMath::float3& pos, Sample& out, float stepHeight = 50.f) const;
+
+    /**
+     * @brief Like sampleNearest(), but blends the heights of the four surrounding grid points, as long as
+     *        they all belong to the same floor. Falls back to the nearest grid point at ledges.
+     */
+    bool sample(const ZMath::float3& pos, Sample& out, float stepHeight = 50.f) const;
+
+    /**
+     * @brief Batched sample(). found may be null.
+     * @return Number of positions with ground below
+     */
+    size_t sample(const ZMath::float3* positions, Sample* out, size_t count, uint8_t* found = nullptr,
+                  float stepHeight = 50.f) const;
+
+    /**
+     * @return Number of layers at the given grid point and their heights/materials, highest first
+     */
+    uint32_t layerCount(uint32_t x, uint32_t z) const;
+    const float*    layerHeights(uint32_t x, uint32_t z) const;
+    const uint16_t* layerMaterials(uint32_t x, uint32_t z) const;
+
+    uint32_t pointsX()  const { return sizeX; }
+    uint32_t pointsZ()  const { return sizeZ; }
+    float    spacing()  const { return step; }
+    const ZMath::float3& getOrigin() const { return origin; }
+
+    /**
+     * @return Total number of layers over all grid points
+     */
+    size_t layerCount() const { return heights.size(); }
+
+    /**
+     * @brief Compact binary form, for baking the grid offline
+     */
+    void save(std::vector<uint8_t>& out) const;
+    bool load(const uint8_t* data, size_t size);
+
+  private:
+    bool     pointAt(float x, float z, uint32_t& point) const;
+    int32_t  findLayer(uint32_t point, float y, float stepHeight) const;
+
+    ZMath::float3         origin;         // Position of grid point (0,0), y unused
+    float                 step    = 0.f;
+    float                 invStep = 0.f;
+    uint32_t              sizeX   = 0;
+    uint32_t              sizeZ   = 0;
+    std::vector<uint32_t> pointStart;     // sizeX*sizeZ+1 offsets into heights/materials
+    std::vector<float>    heights;
+    std::vector<uint16_t> materials;
+  };
+}  // namespace ZenLoad
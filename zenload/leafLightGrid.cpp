@@ -0,0 +1,86 @@
+#include "leafLightGrid.h"
+
+#include <cmath>
+
+#include "triangleBvh.h"
+#include "zCMesh.h"
+
+using namespace ZenLoad;
+
+static const float SAMPLE_RANGE = 10000.f;  // How far to look for a polygon, in world units
+
+static uint32_t lerpColor(uint32_t c0, uint32_t c1, uint32_t c2, float u, float v) {
+  const float w[3] = {1.f-u-v,u,v};
+  uint32_t ret = 0;
+  for(int ch=0; ch<4; ++ch) {
+    const int   sh = ch*8;
+    const float c  = w[0]*float((c0>>sh)&0xFF) + w[1]*float((c1>>sh)&0xFF) + w[2]*float((c2>>sh)&0xFF);
+    ret |= uint32_t(std::min(255.f,std::max(0.f,c+0.5f)))<<sh;
+    }
+  return ret;
+  }
+
+void LeafLightGrid::build(const zCBspTreeData& tree, const zCMesh& mesh, const TriangleBvh* bvh, uint32_t fallback) {
+  fallbackColor = fallback;
+  locator.build(tree);
+
+  TriangleBvh ownBvh;
+  if(bvh==nullptr) {
+    ownBvh.build(mesh);
+    bvh = &ownBvh;
+    }
+
+  samples.assign(tree.leafIndices.size(),Sample());
+  std::vector<BvhRay> rays(samples.size()*2);
+  for(size_t i=0; i<samples.size(); ++i) {
+    Sample& s = samples[i];
+    if(i<tree.leafLightPositions.size()) {
+      s.position = tree.leafLightPositions[i];
+      } else if(tree.leafIndices[i]<tree.nodes.size()) {
+      const zCBspNode& n = tree.nodes[tree.leafIndices[i]];
+      s.position = ZMath::float3((n.bbox3dMin.x+n.bbox3dMax.x)*0.5f,
+                                 (n.bbox3dMin.y+n.bbox3dMax.y)*0.5f,
+                                 (n.bbox3dMin.z+n.bbox3dMax.z)*0.5f);
+      } else {
+      s.position = ZMath::float3(0,0,0);
+      }
+
+    // Look at the floor first, the ceiling if there is none
+    rays[i*2+0].origin    = s.position;
+    rays[i*2+0].direction = ZMath::float3(0,-1,0);
+    rays[i*2+0].tMax      = SAMPLE_RANGE;
+    rays[i*2+1].origin    = s.position;
+    rays[i*2+1].direction = ZMath::float3(0,1,0);
+    rays[i*2+1].tMax      = SAMPLE_RANGE;
+    }
+
+  std::vector<BvhHit> hits(rays.size());
+  bvh->intersect(rays.data(),hits.data(),rays.size());
+
+  auto& features = mesh.getFeatures();
+  auto& featIds  = mesh.getFeatureIndices();
+  colors.resize(samples.size());
+  for(size_t i=0; i<samples.size(); ++i) {
+    Sample&       s = samples[i];
+    const BvhHit& h = hits[i*2].isHit() ? hits[i*2] : hits[i*2+1];
+    if(h.isHit() && size_t(h.triangle)*3+2<featIds.size()) {
+      const uint32_t* f = &featIds[size_t(h.triangle)*3];
+      s.color = lerpColor(features[f[0]].lightStat,features[f[1]].lightStat,features[f[2]].lightStat,h.u,h.v);
+      s.valid = true;
+      } else {
+      s.color = fallback;
+      }
+    colors[i] = s.color;
+    }
+  }
+
+uint32_t LeafLightGrid::ambientAt(const ZMath::float3& pos) const {
+  const uint32_t leaf = locator.locateLeaf(pos);
+  return leaf<colors.size() ? colors[leaf] : fallbackColor;
+  }
+
+void LeafLightGrid::ambientAt(const ZMath::float3* positions, uint32_t* out, size_t count) const {
+  locator.locateLeaf(positions,out,count);
+  for(size_t i=0; i<count; ++i)
+    out[i] = out[i]<colors.size() ? colors[out[i]] : fallbackColor;
+  }
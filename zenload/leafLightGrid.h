@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "bspLocator.h"
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+class zCMesh;
+class TriangleBvh;
+
+/**
+ * @brief Static ambient light per BSP-leaf. Every leaf is sampled once at the position stored in
+ *        CHUNK_BSP_LEAF_LIGHT, by interpolating the static vertex light of the world polygon below it.
+ *        Afterwards a lookup is a BSP point location and a table read.
+ */
+class LeafLightGrid {
+  public:
+    struct Sample {
+      ZMath::float3 position;   // From zCBspTreeData::leafLightPositions, or the leaf center if missing
+      uint32_t      color = 0;  // Same encoding as WorldVertex::Color
+      bool          valid = false;  // False if no polygon was found, color is the fallback then
+      };
+
+    /**
+     * @param tree Loaded BSP-tree
+     * @param mesh Worldmesh loaded along with the tree
+     * @param bvh Optional BVH over the mesh, one is built temporarily if not given
+     * @param fallback Color for leaves without any polygon around their sample position
+     */
+    void build(const zCBspTreeData& tree, const zCMesh& mesh, const TriangleBvh* bvh = nullptr,
+               uint32_t fallback = 0xFF7F7F7F);
+
+    /**
+     * @return Ambient color at the given position, the fallback outside of any leaf
+     */
+    uint32_t ambientAt(const ZMath::float3& pos) const;
+
+    /**
+     * @brief Batched ambientAt()
+     */
+    void ambientAt(const ZMath::float3* positions, uint32_t* colors, size_t count) const;
+
+    /**
+     * @return Samples of all leaves, in the order of zCBspTreeData::leafIndices
+     */
+    const std::vector<Sample>& getSamples() const { return samples; }
+
+    const BspLocator& getLocator() const { return locator; }
+
+  private:
+    BspLocator            locator;
+    std::vector<Sample>   samples;
+    std::vector<uint32_t> colors;  // Tightly packed copy for lookups
+    uint32_t              fallbackColor = 0xFF7F7F7F;
+  };
+}  // namespace ZenLoad
@@ -0,0 +1,148 @@
+#include "materialRegistry.h"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace ZenLoad;
+
+namespace {
+// FNV-1a, fed field by field so padding never ends up in the hash
+class Hasher {
+  public:
+    template<class T>
+    void pod(const T& v) { raw(&v,sizeof(T)); }
+
+    void str(const std::string& s) {
+      pod(uint32_t(s.size()));
+      raw(s.data(),s.size());
+      }
+
+    void raw(const void* data, size_t size) {
+      const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+      for(size_t i=0; i<size; ++i) {
+        h ^= p[i];
+        h *= 0x100000001B3ull;
+        }
+      }
+
+    uint64_t h = 0xCBF29CE484222325ull;
+  };
+}
+
+const size_t MaterialRegistry::CHUNK_SIZE;
+const size_t MaterialRegistry::MAX_CHUNKS;
+
+MaterialRegistry::MaterialRegistry()
+  :chunks(new std::atomic<zCMaterialData*>[MAX_CHUNKS]) {
+  for(size_t i=0; i<MAX_CHUNKS; ++i)
+    chunks[i].store(nullptr,std::memory_order_relaxed);
+  }
+
+MaterialRegistry::~MaterialRegistry() {
+  clear();
+  }
+
+MaterialRegistry& MaterialRegistry::global() {
+  static MaterialRegistry registry;
+  return registry;
+  }
+
+uint64_t MaterialRegistry::hash(const zCMaterialData& m) {
+  Hasher h;
+  h.str(m.matName);
+  h.pod(m.matGroup);
+  h.pod(m.color);
+  h.pod(m.smoothAngle);
+  h.str(m.texture);
+  h.str(m.texScale);
+  h.pod(m.texAniFPS);
+  h.pod(m.texAniMapMode);
+  h.str(m.texAniMapDir);
+  h.pod(uint8_t(m.noCollDet));
+  h.pod(uint8_t(m.noLighmap));
+  h.pod(m.loadDontCollapse);
+  h.str(m.detailObject);
+  h.pod(m.detailTextureScale);
+  h.pod(m.forceOccluder);
+  h.pod(m.environmentMapping);
+  h.pod(m.environmentalMappingStrength);
+  h.pod(m.waveMode);
+  h.pod(m.waveSpeed);
+  h.pod(m.waveMaxAmplitude);
+  h.pod(m.waveGridSize);
+  h.pod(m.ignoreSun);
+  h.pod(m.alphaFunc);
+  h.pod(m.defaultMapping.x);
+  h.pod(m.defaultMapping.y);
+  return h.h;
+  }
+
+bool MaterialRegistry::equal(const zCMaterialData& a, const zCMaterialData& b) {
+  return a.matName==b.matName && a.matGroup==b.matGroup && a.color==b.color && a.smoothAngle==b.smoothAngle &&
+         a.texture==b.texture && a.texScale==b.texScale && a.texAniFPS==b.texAniFPS &&
+         a.texAniMapMode==b.texAniMapMode && a.texAniMapDir==b.texAniMapDir && a.noCollDet==b.noCollDet &&
+         a.noLighmap==b.noLighmap && a.loadDontCollapse==b.loadDontCollapse && a.detailObject==b.detailObject &&
+         a.detailTextureScale==b.detailTextureScale && a.forceOccluder==b.forceOccluder &&
+         a.environmentMapping==b.environmentMapping &&
+         a.environmentalMappingStrength==b.environmentalMappingStrength && a.waveMode==b.waveMode &&
+         a.waveSpeed==b.waveSpeed && a.waveMaxAmplitude==b.waveMaxAmplitude && a.waveGridSize==b.waveGridSize &&
+         a.ignoreSun==b.ignoreSun && a.alphaFunc==b.alphaFunc &&
+         a.defaultMapping.x==b.defaultMapping.x && a.defaultMapping.y==b.defaultMapping.y;
+  }
+
+MaterialId MaterialRegistry::findLocked(const zCMaterialData& material, uint64_t h) const {
+  auto range = byHash.equal_range(h);
+  for(auto i=range.first; i!=range.second; ++i)
+    if(equal(get(i->second),material))
+      return i->second;
+  return MATERIAL_ID_INVALID;
+  }
+
+MaterialId MaterialRegistry::add(const zCMaterialData& material) {
+  const uint64_t              h = hash(material);
+  std::lock_guard<std::mutex> guard(sync);
+  MaterialId id = findLocked(material,h);
+  if(id!=MATERIAL_ID_INVALID)
+    return id;
+  if(count==CHUNK_SIZE*MAX_CHUNKS)
+    throw std::runtime_error("Too many distinct materials");
+
+  // Readers don't lock: the material is complete before its chunk is published or its id is returned
+  zCMaterialData* chunk = chunks[count/CHUNK_SIZE].load(std::memory_order_relaxed);
+  if(chunk==nullptr) {
+    chunk = new zCMaterialData[CHUNK_SIZE];
+    chunk[0] = material;
+    chunks[count/CHUNK_SIZE].store(chunk,std::memory_order_release);
+    } else {
+    chunk[count%CHUNK_SIZE] = material;
+    }
+  id = MaterialId(count);
+  count++;
+  byHash.emplace(h,id);
+  return id;
+  }
+
+void MaterialRegistry::add(const std::vector<zCMaterialData>& list, std::vector<MaterialId>& ids) {
+  ids.resize(list.size());
+  for(size_t i=0; i<list.size(); ++i)
+    ids[i] = add(list[i]);
+  }
+
+MaterialId MaterialRegistry::find(const zCMaterialData& material) const {
+  const uint64_t              h = hash(material);
+  std::lock_guard<std::mutex> guard(sync);
+  return findLocked(material,h);
+  }
+
+size_t MaterialRegistry::size() const {
+  std::lock_guard<std::mutex> guard(sync);
+  return count;
+  }
+
+void MaterialRegistry::clear() {
+  std::lock_guard<std::mutex> guard(sync);
+  for(size_t i=0; i<MAX_CHUNKS; ++i)
+    delete[] chunks[i].exchange(nullptr,std::memory_order_relaxed);
+  count = 0;
+  byHash.clear();
+  }
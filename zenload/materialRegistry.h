@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+/**
+ * @brief One canonical copy of every distinct material, addressed by a small MaterialId.
+ *
+ * Materials are keyed by a hash over all of their fields, so identical materials from different
+ * meshes get the same id. Ids are handed out in order of first registration and stay valid until clear(),
+ * references returned by get() as well. All methods may be called from several threads, except clear().
+ * get() takes no lock, as materials are stored in chunks which never move once allocated.
+ *
+ * The loaders register every material they read with global(), meshes only keep the ids
+ * (zCMesh::getMaterials(), zCProgMeshProto::getMaterials(), SubMesh::materialId).
+ */
+class MaterialRegistry {
+  public:
+    MaterialRegistry();
+    ~MaterialRegistry();
+
+    /**
+     * @return Registry shared by the whole process
+     */
+    static MaterialRegistry& global();
+
+    /**
+     * @return Id of the given material, registering it if it wasn't known yet
+     */
+    MaterialId add(const zCMaterialData& material);
+
+    /**
+     * @brief Registers a list of materials, ids has one entry per material afterwards
+     */
+    void add(const std::vector<zCMaterialData>& materials, std::vector<MaterialId>& ids);
+
+    /**
+     * @return Id of the given material, MATERIAL_ID_INVALID if it isn't registered
+     */
+    MaterialId find(const zCMaterialData& material) const;
+
+    /**
+     * @return Canonical material of an id. Must be a valid id, which was handed to the calling thread
+     *         after add() returned it (e.g. through the mesh it belongs to).
+     */
+    const zCMaterialData& get(MaterialId id) const {
+      return chunks[id/CHUNK_SIZE].load(std::memory_order_acquire)[id%CHUNK_SIZE];
+      }
+
+    size_t size() const;
+
+    /**
+     * @brief Forgets all materials. Invalidates all ids handed out before, for global() that includes
+     *        the ids of every loaded mesh. Must not run concurrently with any other method.
+     */
+    void clear();
+
+    /**
+     * @return Hash over all fields of the material
+     */
+    static uint64_t hash(const zCMaterialData& material);
+
+    /**
+     * @return Whether all fields of both materials are equal
+     */
+    static bool equal(const zCMaterialData& a, const zCMaterialData& b);
+
+  private:
+    static const size_t CHUNK_SIZE = 256;
+    static const size_t MAX_CHUNKS = 16384;  // Up to 4M materials
+
+    MaterialId findLocked(const zCMaterialData& material, uint64_t h) const;
+
+    mutable std::mutex                               sync;
+    std::unique_ptr<std::atomic<zCMaterialData*>[]>  chunks;     // MAX_CHUNKS entries, allocated on demand
+    size_t                                           count = 0;  // Guarded by sync
+    std::unordered_multimap<uint64_t,MaterialId>     byHash;
+  };
+}  // namespace ZenLoad
@@ -0,0 +1,161 @@
+#include "meshBatchLoader.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "parallel.h"
+#include "worldTiles.h"
+#include "zCMesh.h"
+#include "zCProgMeshProto.h"
+#include "zenParser.h"
+#include "utils/logger.h"
+#include "vdfs/fileIndex.h"
+
+using namespace ZenLoad;
+
+const MeshBatchLoader::Handle MeshBatchLoader::INVALID_HANDLE;
+
+struct MeshBatchLoader::Slot {
+  PackedMesh     mesh;
+  MeshLoadTiming timing;
+  bool           valid = false;
+  bool           used  = false;
+  };
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedMs(Clock::time_point since) {
+  return std::chrono::duration<double,std::milli>(Clock::now()-since).count();
+  }
+
+static bool isZCMesh(const std::string& name) {
+  if(name.size()<4)
+    return false;
+  const char* ext = name.c_str()+name.size()-4;
+  return ext[0]=='.' && (ext[1]=='M' || ext[1]=='m') && (ext[2]=='S' || ext[2]=='s') && (ext[3]=='H' || ext[3]=='h');
+  }
+
+MeshBatchLoader::MeshBatchLoader(const VDFS::FileIndex& fileIndex)
+  :fileIndex(fileIndex) {
+  }
+
+MeshBatchLoader::~MeshBatchLoader() {
+  }
+
+// Empties the mesh but keeps the capacity of its buffers
+static void resetMesh(PackedMesh& mesh) {
+  mesh.triangles .clear();
+  mesh.vertices  .clear();
+  mesh.indices   .clear();
+  mesh.verticesId.clear();
+  mesh.subMeshes .clear();
+  mesh.bbox[0]          = ZMath::float3(0,0,0);
+  mesh.bbox[1]          = ZMath::float3(0,0,0);
+  mesh.isUsingAlphaTest = false;
+  }
+
+bool MeshBatchLoader::loadFile(const std::string& name, Slot& slot, std::vector<uint8_t>& buffer) const {
+  slot.timing = MeshLoadTiming();
+  resetMesh(slot.mesh);
+
+  Clock::time_point start = Clock::now();
+  if(!fileIndex.getFileData(name,buffer) || buffer.empty())
+    return false;
+  slot.timing.fileSize = buffer.size();
+  slot.timing.readMs   = elapsedMs(start);
+
+  try {
+    ZenParser parser(buffer.data(),buffer.size());
+    if(isZCMesh(name)) {
+      start = Clock::now();
+      zCMesh mesh;
+      mesh.readObjectData(parser);
+      slot.timing.parseMs = elapsedMs(start);
+
+      // Packed by material like a single world tile, straight into the buffers of the slot
+      start = Clock::now();
+      packWorldMesh(mesh,slot.mesh);
+      slot.timing.packMs = elapsedMs(start);
+      } else {
+      start = Clock::now();
+      zCProgMeshProto mesh;
+      mesh.readObjectData(parser);
+      slot.timing.parseMs = elapsedMs(start);
+
+      start = Clock::now();
+      mesh.packMesh(slot.mesh);
+      slot.timing.packMs = elapsedMs(start);
+      }
+    }
+  catch(const std::exception& e) {
+    LogError() << name << ": " << e.what();
+    return false;
+    }
+  return true;
+  }
+
+MeshBatchStats MeshBatchLoader::load(const std::vector<std::string>& names, std::vector<Handle>& handles, size_t numThreads) {
+  const Clock::time_point start = Clock::now();
+
+  // Hand out slots up front, so workers never touch the slot list
+  handles.resize(names.size());
+  for(size_t i=0; i<names.size(); ++i) {
+    if(!freeSlots.empty()) {
+      handles[i] = freeSlots.back();
+      freeSlots.pop_back();
+      } else {
+      handles[i] = Handle(slots.size());
+      slots.emplace_back(new Slot());
+      }
+    slots[handles[i]]->used = true;
+    }
+
+  numThreads = std::max<size_t>(1,std::min(numThreads,names.size()));
+  if(fileBuffers.size()<numThreads)
+    fileBuffers.resize(numThreads);
+
+  parallelFor(names.size(),numThreads,[&](size_t i, size_t worker) {
+    Slot& s = *slots[handles[i]];
+    s.valid = loadFile(names[i],s,fileBuffers[worker]);
+    });
+
+  MeshBatchStats stats;
+  for(auto& h:handles) {
+    const Slot& s = *slots[h];
+    stats.busyMs += s.timing.readMs+s.timing.parseMs+s.timing.packMs;
+    if(s.valid) {
+      ++stats.loaded;
+      } else {
+      ++stats.failed;
+      release(h);
+      h = INVALID_HANDLE;
+      }
+    }
+  stats.wallMs = elapsedMs(start);
+  return stats;
+  }
+
+const PackedMesh* MeshBatchLoader::get(Handle h) const {
+  if(h>=slots.size() || !slots[h]->used || !slots[h]->valid)
+    return nullptr;
+  return &slots[h]->mesh;
+  }
+
+const MeshLoadTiming* MeshBatchLoader::timing(Handle h) const {
+  if(h>=slots.size() || !slots[h]->used)
+    return nullptr;
+  return &slots[h]->timing;
+  }
+
+void MeshBatchLoader::release(Handle h) {
+  if(h>=slots.size() || !slots[h]->used)
+    return;
+  slots[h]->used  = false;
+  slots[h]->valid = false;
+  freeSlots.push_back(h);
+  }
+
+void MeshBatchLoader::clear() {
+  for(size_t i=0; i<slots.size(); ++i)
+    release(Handle(i));
+  }
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zTypes.h"
+
+namespace VDFS
+{
+class FileIndex;
+}
+
+namespace ZenLoad
+{
+/**
+ * @brief Time spent on a single file of a batch, in milliseconds
+ */
+struct MeshLoadTiming {
+  double readMs   = 0.0;  // Fetching the file from the VDFS
+  double parseMs  = 0.0;  // Decoding the mesh
+  double packMs   = 0.0;  // Converting to PackedMesh
+  size_t fileSize = 0;
+  };
+
+struct MeshBatchStats {
+  size_t loaded = 0;
+  size_t failed = 0;
+  double wallMs = 0.0;   // Time the whole batch took
+  double busyMs = 0.0;   // Sum of all per-file timings, busyMs/wallMs is the achieved parallelism
+  };
+
+/**
+ * @brief Loads and packs many .MRM (zCProgMeshProto) and .MSH (zCMesh) files at once on a set of worker threads.
+ *
+ * Results live in slots addressed by handles. Released slots are handed out again by later batches,
+ * and their PackedMesh is repacked in place, so the vertex and index buffers keep their capacity.
+ * Every worker also keeps its file buffer between files and batches.
+ */
+class MeshBatchLoader {
+  public:
+    using Handle = uint32_t;
+    static const Handle INVALID_HANDLE = uint32_t(-1);
+
+    explicit MeshBatchLoader(const VDFS::FileIndex& fileIndex);
+    ~MeshBatchLoader();
+
+    /**
+     * @param names Files to load, the type is picked by the extension (.MSH or anything else as .MRM)
+     * @param handles One per name, INVALID_HANDLE for files which couldn't be loaded
+     * @param numThreads Number of threads to load on, 1 loads on the calling thread
+     */
+    MeshBatchStats load(const std::vector<std::string>& names, std::vector<Handle>& handles, size_t numThreads = 1);
+
+    /**
+     * @return The packed mesh of a handle, nullptr for invalid or released handles
+     */
+    const PackedMesh* get(Handle h) const;
+
+    /**
+     * @return Timing of the file a handle was loaded from
+     */
+    const MeshLoadTiming* timing(Handle h) const;
+
+    /**
+     * @brief Hands the slot back for reuse by the next batch
+     */
+    void release(Handle h);
+
+    /**
+     * @brief Releases all handles, keeping the allocated buffers
+     */
+    void clear();
+
+    /**
+     * @return Number of handles currently in use
+     */
+    size_t size() const { return slots.size()-freeSlots.size(); }
+
+  private:
+    struct Slot;
+
+    bool loadFile(const std::string& name, Slot& slot, std::vector<uint8_t>& buffer) const;
+
+    const VDFS::FileIndex&             fileIndex;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::vector<Handle>                freeSlots;
+    std::vector<std::vector<uint8_t>>  fileBuffers;  // One per worker
+  };
+}  // namespace ZenLoad
@@ -0,0 +1,286 @@
+#include "meshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace ZenLoad;
+
+// Tuning values from Forsyth's paper
+static const size_t FORSYTH_CACHE_SIZE    = 32;
+static const float  FORSYTH_CACHE_DECAY   = 1.5f;
+static const float  FORSYTH_LAST_TRI      = 0.75f;
+static const float  FORSYTH_VALENCE_SCALE = 2.0f;
+static const float  FORSYTH_VALENCE_POWER = 0.5f;
+static const size_t FORSYTH_VALENCE_TABLE = 32;
+
+static const uint32_t INVALID_INDEX = uint32_t(-1);
+
+namespace {
+struct ForsythScore {
+  float cache  [FORSYTH_CACHE_SIZE];
+  float valence[FORSYTH_VALENCE_TABLE];
+
+  ForsythScore() {
+    for(size_t i=0; i<FORSYTH_CACHE_SIZE; ++i) {
+      if(i<3) {
+        // The last triangle gets a fixed score, so it doesn't matter in which order its vertices come out
+        cache[i] = FORSYTH_LAST_TRI;
+        } else {
+        const float s = 1.f - float(i-3)/float(FORSYTH_CACHE_SIZE-3);
+        cache[i] = std::pow(s,FORSYTH_CACHE_DECAY);
+        }
+      }
+    for(size_t i=0; i<FORSYTH_VALENCE_TABLE; ++i)
+      valence[i] = valenceScore(uint32_t(i));
+    }
+
+  static float valenceScore(uint32_t liveTris) {
+    if(liveTris==0)
+      return 0.f;
+    return FORSYTH_VALENCE_SCALE*std::pow(float(liveTris),-FORSYTH_VALENCE_POWER);
+    }
+
+  float operator()(int cachePos, uint32_t liveTris) const {
+    if(liveTris==0)
+      return -1.f; // no triangle needs this vertex anymore
+    float score = cachePos>=0 ? cache[cachePos] : 0.f;
+    score += liveTris<FORSYTH_VALENCE_TABLE ? valence[liveTris] : valenceScore(liveTris);
+    return score;
+    }
+  };
+}
+
+static size_t countCacheMisses(const uint32_t* indices, size_t indexCount, size_t cacheSize) {
+  if(cacheSize==0)
+    return indexCount;
+
+  // Small FIFO, linear search is faster than anything fancy for sizes up to ~32
+  std::vector<uint32_t> fifo(cacheSize,INVALID_INDEX);
+  size_t head   = 0;
+  size_t misses = 0;
+  for(size_t i=0; i<indexCount; ++i) {
+    const uint32_t id = indices[i];
+    if(std::find(fifo.begin(),fifo.end(),id)!=fifo.end())
+      continue;
+    fifo[head] = id;
+    head = (head+1)%cacheSize;
+    ++misses;
+    }
+  return misses;
+  }
+
+float ZenLoad::computeACMR(const uint32_t* indices, size_t indexCount, size_t cacheSize) {
+  const size_t triCount = indexCount/3;
+  if(triCount==0)
+    return 0.f;
+  return float(countCacheMisses(indices,triCount*3,cacheSize))/float(triCount);
+  }
+
+void ZenLoad::optimizeVertexCache(uint32_t* dst, const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                  uint32_t* triRemap) {
+  static const ForsythScore score;
+
+  const size_t triCount = indexCount/3;
+  if(triCount==0)
+    return;
+
+  // Vertex -> triangle adjacency, stored as one flat list
+  std::vector<uint32_t> liveTris (vertexCount,0);
+  std::vector<uint32_t> adjOffset(vertexCount+1,0);
+  std::vector<uint32_t> adjTris  (triCount*3);
+
+  for(size_t i=0; i<triCount*3; ++i)
+    liveTris[indices[i]]++;
+  for(size_t v=0; v<vertexCount; ++v)
+    adjOffset[v+1] = adjOffset[v]+liveTris[v];
+  {
+  std::vector<uint32_t> fill(adjOffset.begin(),adjOffset.end()-1);
+  for(size_t i=0; i<triCount*3; ++i)
+    adjTris[fill[indices[i]]++] = uint32_t(i/3);
+  }
+
+  std::vector<int>     cachePos (vertexCount,-1);
+  std::vector<float>   vertScore(vertexCount);
+  std::vector<float>   triScore (triCount);
+  std::vector<uint8_t> emitted  (triCount,0);
+
+  for(size_t v=0; v<vertexCount; ++v)
+    vertScore[v] = score(-1,liveTris[v]);
+
+  uint32_t bestTri   = 0;
+  float    bestScore = -1.f;
+  for(size_t t=0; t<triCount; ++t) {
+    const uint32_t* tri = indices+t*3;
+    triScore[t] = vertScore[tri[0]]+vertScore[tri[1]]+vertScore[tri[2]];
+    if(triScore[t]>bestScore) {
+      bestScore = triScore[t];
+      bestTri   = uint32_t(t);
+      }
+    }
+
+  std::vector<uint32_t> cache, nextCache;
+  cache    .reserve(FORSYTH_CACHE_SIZE+3);
+  nextCache.reserve(FORSYTH_CACHE_SIZE+3);
+
+  size_t scanCursor = 0;
+  for(size_t out=0; out<triCount; ++out) {
+    if(bestTri==INVALID_INDEX) {
+      // Nothing in the cache has live triangles left: continue with the next unused one
+      while(emitted[scanCursor])
+        ++scanCursor;
+      bestTri = uint32_t(scanCursor);
+      }
+
+    const uint32_t* tri = indices+size_t(bestTri)*3;
+    emitted[bestTri] = 1;
+    dst[out*3+0] = tri[0];
+    dst[out*3+1] = tri[1];
+    dst[out*3+2] = tri[2];
+    if(triRemap!=nullptr)
+      triRemap[out] = bestTri;
+
+    // Take the triangle out of the adjacency of its vertices
+    for(int i=0; i<3; ++i) {
+      const uint32_t v     = tri[i];
+      uint32_t*      adj   = adjTris.data()+adjOffset[v];
+      uint32_t&      count = liveTris[v];
+      for(uint32_t j=0; j<count; ++j) {
+        if(adj[j]==bestTri) {
+          adj[j] = adj[count-1];
+          --count;
+          break;
+          }
+        }
+      }
+
+    // Emitted vertices go to the front of the cache, the rest is shifted back
+    nextCache.clear();
+    for(int i=0; i<3; ++i)
+      if(std::find(nextCache.begin(),nextCache.end(),tri[i])==nextCache.end())
+        nextCache.push_back(tri[i]);
+    for(uint32_t v:cache)
+      if(v!=tri[0] && v!=tri[1] && v!=tri[2])
+        nextCache.push_back(v);
+
+    for(size_t i=0; i<nextCache.size(); ++i) {
+      const uint32_t v = nextCache[i];
+      cachePos [v] = i<FORSYTH_CACHE_SIZE ? int(i) : -1;
+      vertScore[v] = score(cachePos[v],liveTris[v]);
+      }
+
+    // Only triangles touching the cache changed their score
+    bestTri   = INVALID_INDEX;
+    bestScore = -1.f;
+    for(uint32_t v:nextCache) {
+      const uint32_t* adj = adjTris.data()+adjOffset[v];
+      for(uint32_t j=0; j<liveTris[v]; ++j) {
+        const uint32_t  t  = adj[j];
+        const uint32_t* tv = indices+size_t(t)*3;
+        triScore[t] = vertScore[tv[0]]+vertScore[tv[1]]+vertScore[tv[2]];
+        if(triScore[t]>bestScore) {
+          bestScore = triScore[t];
+          bestTri   = t;
+          }
+        }
+      }
+
+    if(nextCache.size()>FORSYTH_CACHE_SIZE)
+      nextCache.resize(FORSYTH_CACHE_SIZE);
+    cache.swap(nextCache);
+    }
+  }
+
+void ZenLoad::optimizeVertexFetchRemap(std::vector<uint32_t>& remap, uint32_t* indices, size_t indexCount, size_t vertexCount) {
+  remap.assign(vertexCount,INVALID_INDEX);
+
+  uint32_t next = 0;
+  for(size_t i=0; i<indexCount; ++i) {
+    uint32_t& id = remap[indices[i]];
+    if(id==INVALID_INDEX)
+      id = next++;
+    indices[i] = id;
+    }
+
+  for(auto& id:remap)
+    if(id==INVALID_INDEX)
+      id = next++;
+  }
+
+/**
+ * Shared implementation for PackedMesh and PackedSkeletalMesh. onTriangles(subMesh, triRemap)
+ * is called after the triangles of a submesh got reordered, so callers can move per-triangle data.
+ */
+template<class Mesh, class Fn>
+static MeshOptimizeStats optimizeImpl(Mesh& mesh, size_t cacheSize, std::vector<uint32_t>& remap, Fn onTriangles) {
+  MeshOptimizeStats stats;
+  stats.cacheSize = cacheSize;
+
+  size_t missesBefore = 0, missesAfter = 0, triTotal = 0;
+
+  std::vector<uint32_t> local, sorted, triRemap;
+  for(size_t s=0; s<mesh.subMeshes.size(); ++s) {
+    auto& sm = mesh.subMeshes[s];
+    const size_t count = (sm.indexSize/3)*3;
+    if(count==0 || sm.indexOffset+count>mesh.indices.size())
+      continue;
+
+    uint32_t* ibo = mesh.indices.data()+sm.indexOffset;
+    missesBefore += countCacheMisses(ibo,count,cacheSize);
+    triTotal     += count/3;
+
+    // Work on submesh-local ids to keep the scratch buffers small
+    const uint32_t minId = *std::min_element(ibo,ibo+count);
+    const uint32_t maxId = *std::max_element(ibo,ibo+count);
+    local.resize(count);
+    for(size_t i=0; i<count; ++i)
+      local[i] = ibo[i]-minId;
+
+    sorted  .resize(count);
+    triRemap.resize(count/3);
+    optimizeVertexCache(sorted.data(),local.data(),count,size_t(maxId-minId)+1,triRemap.data());
+
+    for(size_t i=0; i<count; ++i)
+      ibo[i] = sorted[i]+minId;
+    missesAfter += countCacheMisses(ibo,count,cacheSize);
+
+    onTriangles(s,triRemap);
+    }
+
+  if(triTotal>0) {
+    stats.acmrBefore = float(missesBefore)/float(triTotal);
+    stats.acmrAfter  = float(missesAfter )/float(triTotal);
+    }
+
+  optimizeVertexFetchRemap(remap,mesh.indices.data(),mesh.indices.size(),mesh.vertices.size());
+  remapVertexStream(mesh.vertices,remap);
+  return stats;
+  }
+
+template<class T>
+static void remapTriangleStream(T* stream, const std::vector<uint32_t>& triRemap) {
+  std::vector<T> tmp(stream,stream+triRemap.size());
+  for(size_t i=0; i<triRemap.size(); ++i)
+    stream[i] = tmp[triRemap[i]];
+  }
+
+MeshOptimizeStats ZenLoad::optimizePackedMesh(PackedMesh& mesh, size_t cacheSize) {
+  const bool hasTriangles = !mesh.triangles.empty() && mesh.triangles.size()==mesh.indices.size()/3;
+
+  std::vector<uint32_t> remap;
+  MeshOptimizeStats stats = optimizeImpl(mesh,cacheSize,remap,[&](size_t s, const std::vector<uint32_t>& triRemap){
+    auto& sm = mesh.subMeshes[s];
+    if(hasTriangles)
+      remapTriangleStream(mesh.triangles.data()+sm.indexOffset/3,triRemap);
+    if(sm.triangleLightmapIndices.size()==triRemap.size())
+      remapTriangleStream(sm.triangleLightmapIndices.data(),triRemap);
+    });
+
+  // verticesId runs parallel to the vertices, which optimizeImpl already moved
+  remapVertexStream(mesh.verticesId,remap);
+  return stats;
+  }
+
+MeshOptimizeStats ZenLoad::optimizePackedMesh(PackedSkeletalMesh& mesh, size_t cacheSize) {
+  std::vector<uint32_t> remap;
+  return optimizeImpl(mesh,cacheSize,remap,[](size_t, const std::vector<uint32_t>&){});
+  }
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+/** Result of a vertex cache optimization pass.
+ *
+ *  ACMR is the average number of post-transform cache misses per triangle,
+ *  measured with a FIFO cache of MeshOptimizeStats::cacheSize entries.
+ *  It lies between ~0.5 (ideal) and 3.0 (no vertex reuse at all).
+ */
+struct MeshOptimizeStats {
+  size_t cacheSize  = 16;
+  float  acmrBefore = 0.f;
+  float  acmrAfter  = 0.f;
+  };
+
+/**
+ * @brief Simulates a FIFO post-transform cache of the given size
+ * @return Average cache miss ratio (misses per triangle) of the index list
+ */
+float computeACMR(const uint32_t* indices, size_t indexCount, size_t cacheSize = 16);
+
+/**
+ * @brief Reorders the triangles of the given list for post-transform cache locality
+ *        (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation").
+ * @param dst Output list, indexCount entries. Must not alias indices
+ * @param vertexCount Number of vertices referenced, i.e. max(index)+1
+ * @param triRemap Optional output, indexCount/3 entries: new triangle -> old triangle
+ */
+void optimizeVertexCache(uint32_t* dst, const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                         uint32_t* triRemap = nullptr);
+
+/**
+ * @brief Renumbers vertices in order of first use, rewriting indices in place
+ * @param remap Output, vertexCount entries: old vertex -> new vertex. Unreferenced
+ *        vertices are kept and moved behind all referenced ones.
+ */
+void optimizeVertexFetchRemap(std::vector<uint32_t>& remap, uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+/**
+ * @brief Moves the elements of a vertex stream to the positions computed by optimizeVertexFetchRemap
+ */
+template<class T>
+void remapVertexStream(std::vector<T>& stream, const std::vector<uint32_t>& remap) {
+  if(stream.size()!=remap.size())
+    return;
+  std::vector<T> tmp(stream.size());
+  for(size_t i=0; i<remap.size(); ++i)
+    tmp[remap[i]] = stream[i];
+  stream.swap(tmp);
+  }
+
+/**
+ * @brief Runs cache- and fetch-optimization over every submesh of the given mesh.
+ *        Submesh index ranges stay where they are, so materials are not affected.
+ *        Per-triangle data (PackedMesh::triangles, SubMesh::triangleLightmapIndices)
+ *        and PackedMesh::verticesId are reordered along with the indices.
+ */
+MeshOptimizeStats optimizePackedMesh(PackedMesh& mesh, size_t cacheSize = 16);
+MeshOptimizeStats optimizePackedMesh(PackedSkeletalMesh& mesh, size_t cacheSize = 16);
+}  // namespace ZenLoad
@@ -0,0 +1,253 @@
+#include "meshQuantizer.h"
+
+#include <cfloat>
+
+using namespace ZenLoad;
+
+static float dot(const ZMath::float3& a, const ZMath::float3& b) {
+  return a.x*b.x + a.y*b.y + a.z*b.z;
+  }
+
+static ZMath::float3 normalize(const ZMath::float3& n) {
+  const float l = std::sqrt(dot(n,n));
+  if(l<=0.f)
+    return n;
+  return n*(1.f/l);
+  }
+
+static float angleBetween(const ZMath::float3& a, const ZMath::float3& b) {
+  return std::acos(std::min(1.f,std::max(-1.f,dot(a,b))));
+  }
+
+void ZenLoad::encodeOctahedral(const ZMath::float3& n, int8_t out[2]) {
+  const float l1 = std::fabs(n.x)+std::fabs(n.y)+std::fabs(n.z);
+  if(l1<=0.f) {
+    out[0] = 0;
+    out[1] = 0;
+    return;
+    }
+
+  float x = n.x/l1;
+  float y = n.y/l1;
+  if(n.z<0.f) {
+    const float ox = x;
+    x = (1.f-std::fabs(y))*(ox>=0.f ? 1.f : -1.f);
+    y = (1.f-std::fabs(ox))*(y>=0.f ? 1.f : -1.f);
+    }
+
+  // Test all four roundings of the projected point and keep the closest
+  const ZMath::float3 ref = normalize(n);
+  const float fx = std::floor(x*127.f);
+  const float fy = std::floor(y*127.f);
+
+  float best = -2.f;
+  for(int i=0; i<4; ++i) {
+    const int8_t c[2] = {int8_t(std::min(127.f,std::max(-127.f,fx+float(i&1)))),
+                         int8_t(std::min(127.f,std::max(-127.f,fy+float(i>>1))))};
+    const float d = dot(decodeOctahedral(c),ref);
+    if(d>best) {
+      best   = d;
+      out[0] = c[0];
+      out[1] = c[1];
+      }
+    }
+  }
+
+static void encodePosition(const ZMath::float3& p, CompactPositionFormat fmt, const ZMath::float3 box[2], uint16_t out[3]) {
+  for(int i=0; i<3; ++i) {
+    if(fmt==CompactPositionFormat::Fixed16) {
+      const float ext = box[1].v[i]-box[0].v[i];
+      const float q   = ext>0.f ? (p.v[i]-box[0].v[i])/ext*65535.f : 0.f;
+      out[i] = uint16_t(std::min(65535.f,std::max(0.f,q+0.5f)));
+      } else {
+      out[i] = ZMath::floatToHalf(p.v[i]-(box[0].v[i]+box[1].v[i])*0.5f);
+      }
+    }
+  }
+
+static void encodeTexCoord(const ZMath::float2& uv, uint16_t out[2]) {
+  out[0] = ZMath::floatToHalf(uv.x);
+  out[1] = ZMath::floatToHalf(uv.y);
+  }
+
+static void encodeWeights(const float w[4], uint8_t out[4]) {
+  const float sum = w[0]+w[1]+w[2]+w[3];
+  if(sum<=0.f) {
+    out[0] = out[1] = out[2] = out[3] = 0;
+    return;
+    }
+
+  int q[4], total = 0, largest = 0;
+  for(int i=0; i<4; ++i) {
+    q[i]   = int(w[i]/sum*255.f+0.5f);
+    total += q[i];
+    if(w[i]>w[largest])
+      largest = i;
+    }
+  // Rounding may miss the total by a few steps, the dominant bone absorbs it
+  q[largest] += 255-total;
+  for(int i=0; i<4; ++i)
+    out[i] = uint8_t(std::min(255,std::max(0,q[i])));
+  }
+
+static void expandBox(ZMath::float3 box[2], const ZMath::float3& p) {
+  for(int i=0; i<3; ++i) {
+    box[0].v[i] = std::min(box[0].v[i],p.v[i]);
+    box[1].v[i] = std::max(box[1].v[i],p.v[i]);
+    }
+  }
+
+static void resetBox(ZMath::float3 box[2]) {
+  box[0] = ZMath::float3( FLT_MAX, FLT_MAX, FLT_MAX);
+  box[1] = ZMath::float3(-FLT_MAX,-FLT_MAX,-FLT_MAX);
+  }
+
+static void updateError(MeshQuantizationError& err, const ZMath::float3& a, const ZMath::float3& b) {
+  const ZMath::float3 d(a.x-b.x,a.y-b.y,a.z-b.z);
+  err.position = std::max(err.position,std::sqrt(dot(d,d)));
+  }
+
+static void updateError(MeshQuantizationError& err, const ZMath::float3& n, const ZMath::float3& decodedN,
+                        const ZMath::float2& uv, const ZMath::float2& decodedUv) {
+  if(dot(n,n)>0.f)
+    err.normal = std::max(err.normal,angleBetween(normalize(n),decodedN));
+  err.texCoord = std::max(err.texCoord,std::fabs(uv.x-decodedUv.x));
+  err.texCoord = std::max(err.texCoord,std::fabs(uv.y-decodedUv.y));
+  }
+
+WorldVertex ZenLoad::decodeVertex(const PackedMeshCompact& mesh, const WorldVertexCompact& v) {
+  WorldVertex ret;
+  ret.Position = decodePosition(mesh,v);
+  ret.Normal   = decodeOctahedral(v.Normal);
+  ret.TexCoord = decodeTexCoord(v.TexCoord);
+  ret.Color    = v.Color;
+  return ret;
+  }
+
+SkeletalVertex ZenLoad::decodeVertex(const PackedSkeletalMeshCompact& mesh, const SkeletalVertexCompact& v) {
+  SkeletalVertex ret;
+  ret.Normal   = decodeOctahedral(v.Normal);
+  ret.TexCoord = decodeTexCoord(v.TexCoord);
+  ret.Color    = v.Color;
+  for(int i=0; i<4; ++i) {
+    ret.LocalPositions[i] = decodePosition(v.LocalPositions[i],mesh.positionFormat,mesh.quantBox);
+    ret.BoneIndices[i]    = v.BoneIndices[i];
+    ret.Weights[i]        = float(v.Weights[i])/255.f;
+    }
+  return ret;
+  }
+
+void ZenLoad::quantizeMesh(const PackedMesh& in, PackedMeshCompact& out, CompactPositionFormat fmt, MeshQuantizationError* error) {
+  out.indices          = in.indices;
+  out.verticesId       = in.verticesId;
+  out.subMeshes        = in.subMeshes;
+  out.bbox[0]          = in.bbox[0];
+  out.bbox[1]          = in.bbox[1];
+  out.positionFormat   = fmt;
+  out.isUsingAlphaTest = in.isUsingAlphaTest;
+
+  // The stored bbox isn't guaranteed to be tight (or to contain everything), so measure it
+  resetBox(out.quantBox);
+  for(auto& v:in.vertices)
+    expandBox(out.quantBox,v.Position);
+  if(in.vertices.empty()) {
+    out.quantBox[0] = in.bbox[0];
+    out.quantBox[1] = in.bbox[1];
+    }
+
+  MeshQuantizationError err;
+  out.vertices.resize(in.vertices.size());
+  for(size_t i=0; i<in.vertices.size(); ++i) {
+    const WorldVertex&  src = in.vertices[i];
+    WorldVertexCompact& dst = out.vertices[i];
+
+    encodePosition(src.Position,fmt,out.quantBox,dst.Position);
+    encodeOctahedral(src.Normal,dst.Normal);
+    encodeTexCoord(src.TexCoord,dst.TexCoord);
+    dst.Color = src.Color;
+
+    if(error!=nullptr) {
+      const WorldVertex dec = decodeVertex(out,dst);
+      updateError(err,src.Position,dec.Position);
+      updateError(err,src.Normal,dec.Normal,src.TexCoord,dec.TexCoord);
+      }
+    }
+
+  if(error!=nullptr)
+    *error = err;
+  }
+
+void ZenLoad::quantizeMesh(const PackedSkeletalMesh& in, PackedSkeletalMeshCompact& out, CompactPositionFormat fmt, MeshQuantizationError* error) {
+  out.indices        = in.indices;
+  out.subMeshes      = in.subMeshes;
+  out.bbox[0]        = in.bbox[0];
+  out.bbox[1]        = in.bbox[1];
+  out.positionFormat = fmt;
+
+  // Local positions live in node-space, so they get a box of their own
+  resetBox(out.quantBox);
+  for(auto& v:in.vertices)
+    for(int i=0; i<4; ++i)
+      expandBox(out.quantBox,v.LocalPositions[i]);
+  if(in.vertices.empty()) {
+    out.quantBox[0] = ZMath::float3(0,0,0);
+    out.quantBox[1] = ZMath::float3(0,0,0);
+    }
+
+  MeshQuantizationError err;
+  out.vertices.resize(in.vertices.size());
+  for(size_t i=0; i<in.vertices.size(); ++i) {
+    const SkeletalVertex&  src = in.vertices[i];
+    SkeletalVertexCompact& dst = out.vertices[i];
+
+    dst.Color = src.Color;
+    for(int j=0; j<4; ++j) {
+      encodePosition(src.LocalPositions[j],fmt,out.quantBox,dst.LocalPositions[j]);
+      dst.BoneIndices[j] = src.BoneIndices[j];
+      }
+    encodeTexCoord(src.TexCoord,dst.TexCoord);
+    encodeOctahedral(src.Normal,dst.Normal);
+    encodeWeights(src.Weights,dst.Weights);
+
+    if(error!=nullptr) {
+      const SkeletalVertex dec = decodeVertex(out,dst);
+      const float sum = src.Weights[0]+src.Weights[1]+src.Weights[2]+src.Weights[3];
+      for(int j=0; j<4; ++j) {
+        // Unused slots carry no weight, their positions don't matter
+        if(src.Weights[j]>0.f)
+          updateError(err,src.LocalPositions[j],dec.LocalPositions[j]);
+        if(sum>0.f)
+          err.weight = std::max(err.weight,std::fabs(src.Weights[j]/sum-dec.Weights[j]));
+        }
+      updateError(err,src.Normal,dec.Normal,src.TexCoord,dec.TexCoord);
+      }
+    }
+
+  if(error!=nullptr)
+    *error = err;
+  }
+
+void ZenLoad::dequantizeMesh(const PackedMeshCompact& in, PackedMesh& out) {
+  out.triangles.clear();
+  out.indices          = in.indices;
+  out.verticesId       = in.verticesId;
+  out.subMeshes        = in.subMeshes;
+  out.bbox[0]          = in.bbox[0];
+  out.bbox[1]          = in.bbox[1];
+  out.isUsingAlphaTest = in.isUsingAlphaTest;
+
+  out.vertices.resize(in.vertices.size());
+  for(size_t i=0; i<in.vertices.size(); ++i)
+    out.vertices[i] = decodeVertex(in,in.vertices[i]);
+  }
+
+void ZenLoad::dequantizeMesh(const PackedSkeletalMeshCompact& in, PackedSkeletalMesh& out) {
+  out.indices   = in.indices;
+  out.subMeshes = in.subMeshes;
+  out.bbox[0]   = in.bbox[0];
+  out.bbox[1]   = in.bbox[1];
+
+  out.vertices.resize(in.vertices.size());
+  for(size_t i=0; i<in.vertices.size(); ++i)
+    out.vertices[i] = decodeVertex(in,in.vertices[i]);
+  }
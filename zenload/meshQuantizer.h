@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+/** Largest differences between original and decoded vertices, reported by quantizeMesh().
+ *  The encodings keep them within:
+ *  - position: Fixed16 half a step of 1/65535 of the quantization box per axis,
+ *              Half 2^-11 of the distance to the box center per axis
+ *  - normal:   0.012 radians, for unit length normals
+ *  - texCoord: 2^-11 of the value, 2^-25 below 2^-14 (half-float rounding)
+ *  - weight:   2/255, of the weights normalized to a sum of 1
+ */
+struct MeshQuantizationError {
+  float position = 0.f;  // Euclidean distance, in mesh units
+  float normal   = 0.f;  // Angle in radians
+  float texCoord = 0.f;  // Per component
+  float weight   = 0.f;  // Per weight, skeletal meshes only
+  };
+
+/**
+ * @brief Encodes a unit vector into two snorm8 values (octahedral mapping).
+ *        Picks the rounding with the smallest angular error.
+ */
+void encodeOctahedral(const ZMath::float3& n, int8_t out[2]);
+
+/**
+ * @brief Decodes an octahedral encoded normal. The result is normalized.
+ */
+inline ZMath::float3 decodeOctahedral(const int8_t in[2]) {
+  float x = std::max(float(in[0])/127.f,-1.f);
+  float y = std::max(float(in[1])/127.f,-1.f);
+  float z = 1.f-std::fabs(x)-std::fabs(y);
+  if(z<0.f) {
+    const float ox = x;
+    x = (1.f-std::fabs(y))*(ox>=0.f ? 1.f : -1.f);
+    y = (1.f-std::fabs(ox))*(y>=0.f ? 1.f : -1.f);
+    }
+  const float l = 1.f/std::sqrt(x*x+y*y+z*z);
+  return ZMath::float3(x*l,y*l,z*l);
+  }
+
+/**
+ * @brief Decodes a position stored in the given format, relative to the quantization box
+ */
+inline ZMath::float3 decodePosition(const uint16_t in[3], CompactPositionFormat fmt, const ZMath::float3 box[2]) {
+  ZMath::float3 ret;
+  for(int i=0; i<3; ++i) {
+    if(fmt==CompactPositionFormat::Fixed16)
+      ret.v[i] = box[0].v[i] + float(in[i])*((box[1].v[i]-box[0].v[i])/65535.f);
+    else
+      ret.v[i] = (box[0].v[i]+box[1].v[i])*0.5f + ZMath::halfToFloat(in[i]);
+    }
+  return ret;
+  }
+
+inline ZMath::float3 decodePosition(const PackedMeshCompact& mesh, const WorldVertexCompact& v) {
+  return decodePosition(v.Position,mesh.positionFormat,mesh.quantBox);
+  }
+
+inline ZMath::float2 decodeTexCoord(const uint16_t in[2]) {
+  return ZMath::float2(ZMath::halfToFloat(in[0]),ZMath::halfToFloat(in[1]));
+  }
+
+/**
+ * @brief Expands a compact vertex back to its full representation
+ */
+WorldVertex    decodeVertex(const PackedMeshCompact&         mesh, const WorldVertexCompact&    v);
+SkeletalVertex decodeVertex(const PackedSkeletalMeshCompact& mesh, const SkeletalVertexCompact& v);
+
+/**
+ * @brief Converts a packed mesh into the compact format
+ * @param error Optional output of the largest decoding errors
+ */
+void quantizeMesh(const PackedMesh& in, PackedMeshCompact& out,
+                  CompactPositionFormat fmt = CompactPositionFormat::Fixed16, MeshQuantizationError* error = nullptr);
+void quantizeMesh(const PackedSkeletalMesh& in, PackedSkeletalMeshCompact& out,
+                  CompactPositionFormat fmt = CompactPositionFormat::Fixed16, MeshQuantizationError* error = nullptr);
+
+/**
+ * @brief Expands a compact mesh back into the full format (PackedMesh::triangles is left empty)
+ */
+void dequantizeMesh(const PackedMeshCompact&         in, PackedMesh&         out);
+void dequantizeMesh(const PackedSkeletalMeshCompact& in, PackedSkeletalMesh& out);
+}  // namespace ZenLoad
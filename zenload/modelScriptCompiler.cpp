@@ -0,0 +1,342 @@
+#include "modelScriptCompiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <thread>
+
+#include "modelScriptParser.h"
+#include "zenParser.h"
+#include "utils/split.h"
+#include "vdfs/fileIndex.h"
+
+using namespace ZenLoad;
+
+// Bump when the written layout changes, so old cache entries are not used anymore
+static const uint32_t MSB_COMPILER_VERSION = 1;
+
+namespace {
+class MsbWriter {
+  public:
+    explicit MsbWriter(std::vector<uint8_t>& out):out(out){}
+
+    void begin(MdsParser::Chunk id) {
+      start = out.size();
+      pod(uint16_t(id));
+      pod(uint32_t(0));
+      }
+
+    void end() {
+      const uint32_t length = uint32_t(out.size()-start-sizeof(BinaryChunkInfo));
+      std::memcpy(&out[start+sizeof(uint16_t)],&length,sizeof(length));
+      }
+
+    void dword(uint32_t v) { pod(v); }
+    void i32(int32_t v)    { pod(v); }
+    void flt(float v)      { pod(v); }
+
+    void str(const std::string& s) {
+      out.insert(out.end(),s.begin(),s.end());
+      out.push_back('\n');
+      }
+
+  private:
+    template<class T>
+    void pod(const T& v) {
+      const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
+      out.insert(out.end(),p,p+sizeof(T));
+      }
+
+    std::vector<uint8_t>& out;
+    size_t                start = 0;
+  };
+}
+
+// Inverse of MdsParser::makeAniFlags
+static std::string aniFlags(uint32_t flags) {
+  std::string s;
+  if(flags & MSB_MOVE_MODEL)
+    s.push_back('M');
+  if(flags & MSB_ROTATE_MODEL)
+    s.push_back('R');
+  if(flags & MSB_QUEUE_ANI)
+    s.push_back('E');
+  if(flags & MSB_FLY)
+    s.push_back('F');
+  if(flags & MSB_IDLE)
+    s.push_back('I');
+  return s;
+  }
+
+static const char* aniDir(EModelScriptAniDir dir) {
+  return dir==MSB_BACKWARD ? "R" : "F";
+  }
+
+static const char* aniDef(EModelScriptAniDef def) {
+  static const char* names[DEF_LAST] = {
+    "",
+    "DEF_CREATE_ITEM", "DEF_INSERT_ITEM", "DEF_REMOVE_ITEM", "DEF_DESTROY_ITEM", "DEF_PLACE_ITEM", "DEF_EXCHANGE_ITEM",
+    "DEF_FIGHTMODE", "DEF_PLACE_MUNITION", "DEF_REMOVE_MUNITION", "DEF_DRAWSOUND", "DEF_UNDRAWSOUND", "DEF_SWAPMESH",
+    "DEF_DRAWTORCH", "DEF_INV_TORCH", "DEF_DROP_TORCH",
+    "DEF_HIT_LIMB", "DEF_HIT_DIR", "DEF_DAM_MULTIPLY", "DEF_PAR_FRAME", "DEF_OPT_FRAME", "DEF_HIT_END", "DEF_WINDOW",
+    };
+  return def<DEF_LAST ? names[def] : "";
+  }
+
+static const char* fightMode(EFightMode m) {
+  static const char* names[FM_LAST] = {"", "FIST", "1H", "2H", "BOW", "CBOW", "MAG"};
+  return m<FM_LAST ? names[m] : "";
+  }
+
+// Arguments in the order MdsParser::readEvent reads them
+static void writeEvent(MsbWriter& w, const zCModelEvent& e) {
+  w.i32(e.m_Frame);
+  w.str(aniDef(e.m_Def));
+  switch(e.m_Def) {
+    case DEF_CREATE_ITEM:
+    case DEF_EXCHANGE_ITEM:
+      w.str(e.m_Slot);
+      w.str(e.m_Item);
+      break;
+    case DEF_INSERT_ITEM:
+    case DEF_PLACE_MUNITION:
+      w.str(e.m_Slot);
+      break;
+    case DEF_FIGHTMODE:
+      w.str(fightMode(e.m_Fmode));
+      break;
+    case DEF_SWAPMESH:
+      w.str(e.m_Slot);
+      w.str(e.m_Slot2);
+      break;
+    case DEF_DAM_MULTIPLY:
+    case DEF_PAR_FRAME:
+    case DEF_OPT_FRAME:
+    case DEF_HIT_END:
+    case DEF_WINDOW: {
+      std::string frames;
+      for(size_t i=0; i<e.m_Int.size(); ++i) {
+        if(i>0)
+          frames.push_back(' ');
+        frames += std::to_string(e.m_Int[i]);
+        }
+      w.str(frames);
+      break;
+      }
+    default:
+      break;
+    }
+  }
+
+bool ZenLoad::compileModelScript(ZenParser& mds, std::vector<uint8_t>& msb) {
+  msb.clear();
+
+  MdsParserTxt p(mds);
+  MsbWriter    w(msb);
+  size_t       numChunks = 0;
+  while(true) {
+    // Event chunks append to the lists of the parser, unknown events append nothing
+    const size_t numTags     = p.eventTag.size();
+    const size_t numModelTag = p.modelTag.size();
+
+    const MdsParser::Chunk ch = p.parse();
+    if(ch==MdsParser::CHUNK_EOF || ch==MdsParser::CHUNK_ERROR)
+      break;
+
+    switch(ch) {
+      case MdsParser::CHUNK_MESH_AND_TREE:
+        w.begin(ch);
+        w.dword(p.meshAndThree.m_Disabled ? 1 : 0);
+        w.str(p.meshAndThree.m_Name);
+        w.end();
+        break;
+      case MdsParser::CHUNK_REGISTER_MESH:
+        w.begin(ch);
+        w.str(p.meshesASC.back());
+        w.end();
+        break;
+      case MdsParser::CHUNK_ANI:
+        w.begin(ch);
+        w.str(p.ani.m_Name);
+        w.dword(p.ani.m_Layer);
+        w.str(p.ani.m_Next);
+        w.flt(p.ani.m_BlendIn);
+        w.flt(p.ani.m_BlendOut);
+        w.str(aniFlags(p.ani.m_Flags));
+        w.str(p.ani.m_Asc);
+        w.str(aniDir(p.ani.m_Dir));
+        w.i32(p.ani.m_FirstFrame);
+        w.i32(p.ani.m_LastFrame);
+        w.flt(p.ani.m_MaxFps);
+        w.flt(p.ani.m_Speed);
+        w.flt(p.ani.m_ColVolScale);
+        w.end();
+        break;
+      case MdsParser::CHUNK_ANI_ALIAS:
+        w.begin(ch);
+        w.str(p.alias.m_Name);
+        w.dword(p.alias.m_Layer);
+        w.str(p.alias.m_Next);
+        w.flt(p.alias.m_BlendIn);
+        w.flt(p.alias.m_BlendOut);
+        w.str(aniFlags(p.alias.m_Flags));
+        w.str(p.alias.m_Alias);
+        w.str(aniDir(p.alias.m_Dir));
+        w.end();
+        break;
+      case MdsParser::CHUNK_ANI_BLEND:
+        w.begin(ch);
+        w.str(p.blend.m_Name);
+        w.str(p.blend.m_Next);
+        w.flt(p.blend.m_BlendIn);
+        w.flt(p.blend.m_BlendOut);
+        w.end();
+        break;
+      case MdsParser::CHUNK_ANI_COMB:
+        w.begin(ch);
+        w.str(p.comb.m_Name);
+        w.dword(p.comb.m_Layer);
+        w.str(p.comb.m_Next);
+        w.flt(p.comb.m_BlendIn);
+        w.flt(p.comb.m_BlendOut);
+        w.str(aniFlags(p.comb.m_Flags));
+        w.str(p.comb.m_Asc);
+        w.dword(p.comb.m_LastFrame);
+        w.end();
+        break;
+      case MdsParser::CHUNK_ANI_DISABLE:
+        w.begin(ch);
+        w.str(p.disable.m_Name);
+        w.end();
+        break;
+      case MdsParser::CHUNK_EVENT_SFX:
+      case MdsParser::CHUNK_EVENT_SFX_GRND: {
+        const zCModelScriptEventSfx& e = (ch==MdsParser::CHUNK_EVENT_SFX ? p.sfx : p.gfx).back();
+        w.begin(ch);
+        w.i32(e.m_Frame);
+        w.str(e.m_Name);
+        w.flt(e.m_Range);
+        w.dword(e.m_EmptySlot ? 1 : 0);
+        w.end();
+        break;
+        }
+      case MdsParser::CHUNK_EVENT_PFX: {
+        const zCModelScriptEventPfx& e = p.pfx.back();
+        w.begin(ch);
+        w.i32(e.m_Frame);
+        w.i32(e.m_Num);
+        w.str(e.m_Name);
+        w.str(e.m_Pos);
+        w.dword(e.m_isAttached ? 1 : 0);
+        w.end();
+        break;
+        }
+      case MdsParser::CHUNK_EVENT_PFX_STOP:
+        w.begin(ch);
+        w.i32(p.pfxStop.back().m_Frame);
+        w.i32(p.pfxStop.back().m_Num);
+        w.end();
+        break;
+      case MdsParser::CHUNK_EVENT_TAG:
+      case MdsParser::CHUNK_MODEL_TAG: {
+        const std::vector<zCModelEvent>& list = ch==MdsParser::CHUNK_EVENT_TAG ? p.eventTag : p.modelTag;
+        if(list.size()==(ch==MdsParser::CHUNK_EVENT_TAG ? numTags : numModelTag))
+          continue;
+        w.begin(ch);
+        writeEvent(w,list.back());
+        w.end();
+        break;
+        }
+      case MdsParser::CHUNK_EVENT_MMSTARTANI:
+        w.begin(ch);
+        w.i32(p.mmStartAni.back().m_Frame);
+        w.str(p.mmStartAni.back().m_Animation);
+        w.str(p.mmStartAni.back().m_Node);
+        w.end();
+        break;
+      default:
+        continue;
+      }
+    numChunks++;
+    }
+  return numChunks>0;
+  }
+
+bool ZenLoad::compileModelScript(const uint8_t* text, size_t size, std::vector<uint8_t>& msb) {
+  ZenParser zen(text,size);
+  return compileModelScript(zen,msb);
+  }
+
+ModelScriptCache::ModelScriptCache(std::string dir)
+  :directory(std::move(dir)) {
+  if(!directory.empty() && directory.back()!='/' && directory.back()!='\\')
+    directory.push_back('/');
+  }
+
+uint64_t ModelScriptCache::hash(const uint8_t* text, size_t size) {
+  // FNV-1a
+  uint64_t h = 14695981039346656037ull;
+  auto feed = [&h](const uint8_t* p, size_t n) {
+    for(size_t i=0; i<n; ++i) {
+      h ^= p[i];
+      h *= 1099511628211ull;
+      }
+    };
+  feed(reinterpret_cast<const uint8_t*>(&MSB_COMPILER_VERSION),sizeof(MSB_COMPILER_VERSION));
+  feed(text,size);
+  return h;
+  }
+
+std::string ModelScriptCache::entryPath(const uint8_t* text, size_t size) const {
+  char name[32] = {};
+  std::snprintf(name,sizeof(name),"%016llx.msb",static_cast<unsigned long long>(hash(text,size)));
+  return directory+name;
+  }
+
+bool ModelScriptCache::load(const std::string& name, const VDFS::FileIndex& index, std::vector<uint8_t>& msb) {
+  const std::string base = Utils::baseName(name);
+  if(index.hasFile(base+".MSB"))
+    return index.getFileData(base+".MSB",msb) && !msb.empty();
+
+  std::vector<uint8_t> text;
+  if(!index.getFileData(base+".MDS",text) || text.empty())
+    return false;
+  return load(text.data(),text.size(),msb);
+  }
+
+bool ModelScriptCache::load(const uint8_t* text, size_t size, std::vector<uint8_t>& msb) {
+  const std::string path = entryPath(text,size);
+  {
+    std::ifstream in(path,std::ios::binary);
+    in.seekg(0,std::ios::end);
+    const std::streamoff length = in ? std::streamoff(in.tellg()) : -1;
+    if(length>0) {
+      msb.resize(size_t(length));
+      in.seekg(0,std::ios::beg);
+      if(in.read(reinterpret_cast<char*>(msb.data()),std::streamsize(msb.size())))
+        return true;
+      }
+  }
+
+  if(!compileModelScript(text,size,msb))
+    return false;
+
+  // Write next to the entry and rename, so readers never see a partial file. Thread ids repeat across
+  // processes, the random part keeps the temporary names of processes sharing the directory apart.
+  std::random_device rnd;
+  const uint64_t     salt = (uint64_t(rnd())<<32 | rnd()) ^ std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                            uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+  char suffix[32] = {};
+  std::snprintf(suffix,sizeof(suffix),".%016llx.tmp",static_cast<unsigned long long>(salt));
+  const std::string tmp = path+suffix;
+
+  std::ofstream out(tmp,std::ios::binary);
+  out.write(reinterpret_cast<const char*>(msb.data()),std::streamsize(msb.size()));
+  out.close();
+  if(!out || std::rename(tmp.c_str(),path.c_str())!=0)
+    std::remove(tmp.c_str());  // Compiled fine, only caching failed
+  return true;
+  }
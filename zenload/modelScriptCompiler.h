@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VDFS
+{
+class FileIndex;
+}
+
+namespace ZenLoad
+{
+class ZenParser;
+
+/**
+ * @brief Parses a text model script (.MDS) with MdsParserTxt and writes it as a binary model script,
+ *        which MdsParserBin reads back into the same structures.
+ *
+ * Only the chunks MdsParser understands are written, one after the other without container chunks.
+ * Events MdsParser drops (unknown tags) are dropped here as well.
+ * @return Whether anything was parsed
+ */
+bool compileModelScript(ZenParser& mds, std::vector<uint8_t>& msb);
+bool compileModelScript(const uint8_t* text, size_t size, std::vector<uint8_t>& msb);
+
+/**
+ * @brief Directory of compiled model scripts, keyed by a hash of the text they were compiled from.
+ *        Entries are written to a temporary file first and renamed, so several processes may share the directory.
+ */
+class ModelScriptCache {
+  public:
+    /**
+     * @param directory Existing directory to keep the compiled scripts in
+     */
+    explicit ModelScriptCache(std::string directory);
+
+    /**
+     * @brief Binary form of a model script. A .MSB in the index is used as it is, a .MDS is taken from the
+     *        cache or compiled and stored.
+     * @param name Script name, with either extension or without one
+     */
+    bool load(const std::string& name, const VDFS::FileIndex& index, std::vector<uint8_t>& msb);
+
+    /**
+     * @brief Binary form of the given script text, from the cache or compiled and stored
+     */
+    bool load(const uint8_t* text, size_t size, std::vector<uint8_t>& msb);
+
+    /**
+     * @return Path of the cache entry for the given script text
+     */
+    std::string entryPath(const uint8_t* text, size_t size) const;
+
+    /**
+     * @return Content hash the entries are named by, includes the version of the binary layout
+     */
+    static uint64_t hash(const uint8_t* text, size_t size);
+
+  private:
+    std::string directory;
+  };
+}  // namespace ZenLoad
@@ -0,0 +1,274 @@
+#include "modelScriptRegistry.h"
+
+#include <algorithm>
+#include <cctype>
+#include <memory>
+
+#include "modelScriptCompiler.h"
+#include "modelScriptParser.h"
+#include "parallel.h"
+#include "zenParser.h"
+#include "utils/logger.h"
+#include "utils/split.h"
+#include "vdfs/fileIndex.h"
+
+using namespace ZenLoad;
+
+// Script contents in declaration order, with names still as strings. Filled on the worker threads.
+struct ModelScriptRegistry::Entry {
+  AnimationKind      kind       = AnimationKind::Ani;
+  std::string        name, next, asc;
+  uint32_t           layer      = 0;
+  uint32_t           flags      = 0;
+  float              blendIn    = 0.f;
+  float              blendOut   = 0.f;
+  EModelScriptAniDir dir        = MSB_FORWARD;
+  int32_t            firstFrame = 0;
+  int32_t            lastFrame  = 0;
+  float              maxFps     = 0.f;
+  float              speed      = 0.f;
+  float              colVol     = 1.f;
+  };
+
+struct ModelScriptRegistry::Parsed {
+  std::string              mesh;
+  std::vector<Entry>       entries;
+  std::vector<std::string> disabled;
+  bool                     valid = false;
+  };
+
+// Names in the scripts are case-insensitive
+static std::string upper(std::string s) {
+  for(auto& c:s)
+    c = char(std::toupper(static_cast<unsigned char>(c)));
+  return s;
+  }
+
+bool ModelScriptRegistry::parse(const std::string& file, const VDFS::FileIndex& index, ModelScriptCache* cache,
+                                Parsed& out) {
+  std::vector<uint8_t> data;
+  bool binary = true;
+  if(cache!=nullptr) {
+    if(!cache->load(file,index,data))
+      return false;
+    } else {
+    const std::string base = Utils::baseName(file);
+    const std::string ext  = upper(file.substr(base.size()));
+    binary = ext==".MSB" || (ext.empty() && index.hasFile(base+".MSB"));
+    if(!index.getFileData(base+(binary ? ".MSB" : ".MDS"),data) || data.empty())
+      return false;
+    }
+
+  try {
+    ZenParser zen(data.data(),data.size());
+    std::unique_ptr<MdsParser> p;
+    if(binary)
+      p.reset(new MdsParserBin(zen));
+    else
+      p.reset(new MdsParserTxt(zen));
+
+    while(true) {
+      const MdsParser::Chunk ch = p->parse();
+      if(ch==MdsParser::CHUNK_EOF)
+        break;
+      if(ch==MdsParser::CHUNK_ERROR)
+        return false;
+
+      Entry e;
+      switch(ch) {
+        case MdsParser::CHUNK_MESH_AND_TREE:
+          out.mesh = p->meshAndThree.m_Name;
+          continue;
+        case MdsParser::CHUNK_ANI_DISABLE:
+          out.disabled.push_back(upper(p->disable.m_Name));
+          continue;
+        case MdsParser::CHUNK_ANI:
+          e.kind       = AnimationKind::Ani;
+          e.name       = p->ani.m_Name;
+          e.next       = p->ani.m_Next;
+          e.asc        = p->ani.m_Asc;
+          e.layer      = p->ani.m_Layer;
+          e.flags      = p->ani.m_Flags;
+          e.blendIn    = p->ani.m_BlendIn;
+          e.blendOut   = p->ani.m_BlendOut;
+          e.dir        = p->ani.m_Dir;
+          e.firstFrame = p->ani.m_FirstFrame;
+          e.lastFrame  = p->ani.m_LastFrame;
+          e.maxFps     = p->ani.m_MaxFps;
+          e.speed      = p->ani.m_Speed;
+          e.colVol     = p->ani.m_ColVolScale;
+          break;
+        case MdsParser::CHUNK_ANI_ALIAS:
+          e.kind     = AnimationKind::Alias;
+          e.name     = p->alias.m_Name;
+          e.next     = p->alias.m_Next;
+          e.asc      = p->alias.m_Alias;
+          e.layer    = p->alias.m_Layer;
+          e.flags    = p->alias.m_Flags;
+          e.blendIn  = p->alias.m_BlendIn;
+          e.blendOut = p->alias.m_BlendOut;
+          e.dir      = p->alias.m_Dir;
+          break;
+        case MdsParser::CHUNK_ANI_COMB:
+          e.kind      = AnimationKind::Comb;
+          e.name      = p->comb.m_Name;
+          e.next      = p->comb.m_Next;
+          e.asc       = p->comb.m_Asc;
+          e.layer     = p->comb.m_Layer;
+          e.flags     = p->comb.m_Flags;
+          e.blendIn   = p->comb.m_BlendIn;
+          e.blendOut  = p->comb.m_BlendOut;
+          e.lastFrame = int32_t(p->comb.m_LastFrame);
+          break;
+        case MdsParser::CHUNK_ANI_BLEND:
+          e.kind     = AnimationKind::Blend;
+          e.name     = p->blend.m_Name;
+          e.next     = p->blend.m_Next;
+          e.layer    = p->blend.m_Layer;
+          e.blendIn  = p->blend.m_BlendIn;
+          e.blendOut = p->blend.m_BlendOut;
+          break;
+        default:
+          // Events are collected by the parser, see AnimationEventTimeline
+          continue;
+        }
+      e.name = upper(e.name);
+      e.next = upper(e.next);
+      e.asc  = upper(e.asc);
+      out.entries.push_back(std::move(e));
+      }
+    }
+  catch(const std::exception& e) {
+    LogError() << file << ": " << e.what();
+    return false;
+    }
+  return true;
+  }
+
+void ModelScriptRegistry::add(const std::string& file, const Parsed& script) {
+  const ModelId id = ModelId(models.size());
+
+  Model m;
+  m.name           = pool.intern(Utils::baseName(file));
+  m.mesh           = pool.intern(upper(script.mesh));
+  m.firstAnimation = AnimationId(animations.size());
+  m.numAnimations  = uint32_t(script.entries.size());
+  models.push_back(m);
+  modelIds[pool.get(m.name)] = id;
+
+  // Intern all names first, so the lookup table is complete before references are resolved
+  for(const Entry& e:script.entries) {
+    Animation a;
+    a.name        = pool.intern(e.name);
+    a.model       = id;
+    a.kind        = e.kind;
+    a.dir         = e.dir;
+    a.layer       = e.layer;
+    a.flags       = e.flags;
+    a.blendIn     = e.blendIn;
+    a.blendOut    = e.blendOut;
+    a.asc         = pool.intern(e.asc);
+    a.firstFrame  = e.firstFrame;
+    a.lastFrame   = e.lastFrame;
+    a.maxFps      = e.maxFps;
+    a.speed       = e.speed;
+    a.colVolScale = e.colVol;
+    byName.emplace_back(a.name,AnimationId(animations.size()));
+    animations.push_back(a);
+    }
+  // Stable, so for duplicate names the last definition is found, as it overrides the earlier ones
+  std::stable_sort(byName.begin()+m.firstAnimation,byName.end(),
+                   [](const std::pair<uint32_t,AnimationId>& a, const std::pair<uint32_t,AnimationId>& b) {
+    return a.first<b.first;
+    });
+
+  for(const std::string& d:script.disabled) {
+    const AnimationId a = findAnimation(id,pool.find(d));
+    if(a!=ANIMATION_ID_INVALID)
+      animations[a].disabled = true;
+    }
+
+  for(size_t i=0; i<script.entries.size(); ++i) {
+    const Entry& e = script.entries[i];
+    Animation&   a = animations[m.firstAnimation+i];
+    if(!e.next.empty())
+      a.next = findAnimation(id,pool.find(e.next));
+
+    if(e.kind==AnimationKind::Comb) {
+      // The combined animations are named by the prefix and 1..count, e.g. T_LOOK1..T_LOOK9
+      a.comboFirst = uint32_t(comboIds.size());
+      a.comboCount = uint32_t(std::max(e.lastFrame,0));
+      for(uint32_t c=1; c<=a.comboCount; ++c)
+        comboIds.push_back(findAnimation(id,pool.find(e.asc+std::to_string(c))));
+      }
+    }
+
+  // Aliases may point to other aliases, follow them to the animation with the data
+  for(uint32_t i=0; i<m.numAnimations; ++i) {
+    const AnimationId self = m.firstAnimation+i;
+    AnimationId       a    = self;
+    for(uint32_t depth=0; a!=ANIMATION_ID_INVALID && animations[a].kind==AnimationKind::Alias; ++depth) {
+      if(depth==m.numAnimations) {
+        LogWarn() << file << ": alias cycle at " << pool.get(animations[self].name);
+        a = ANIMATION_ID_INVALID;
+        break;
+        }
+      a = findAnimation(id,animations[a].asc);
+      }
+    animations[self].source = a;
+    }
+  }
+
+size_t ModelScriptRegistry::load(const std::vector<std::string>& files, const VDFS::FileIndex& index,
+                                 size_t numThreads, ModelScriptCache* cache) {
+  std::vector<Parsed> parsed(files.size());
+
+  parallelFor(files.size(),numThreads,[&](size_t i, size_t) {
+    parsed[i].valid = parse(files[i],index,cache,parsed[i]);
+    });
+
+  // Ids only depend on the order of the files, not on the threads
+  size_t loaded = 0;
+  for(size_t i=0; i<files.size(); ++i) {
+    if(!parsed[i].valid) {
+      LogWarn() << "Could not load model script " << files[i];
+      continue;
+      }
+    add(files[i],parsed[i]);
+    ++loaded;
+    }
+  return loaded;
+  }
+
+void ModelScriptRegistry::clear() {
+  pool = StringPool();
+  models.clear();
+  animations.clear();
+  comboIds.clear();
+  byName.clear();
+  modelIds.clear();
+  }
+
+ModelId ModelScriptRegistry::findModel(const std::string& name) const {
+  auto it = modelIds.find(Utils::baseName(name));
+  return it==modelIds.end() ? MODEL_ID_INVALID : it->second;
+  }
+
+AnimationId ModelScriptRegistry::findAnimation(ModelId model, const std::string& name) const {
+  const uint32_t id = pool.find(upper(name));
+  return id==0 ? ANIMATION_ID_INVALID : findAnimation(model,id);
+  }
+
+AnimationId ModelScriptRegistry::findAnimation(ModelId model, uint32_t nameId) const {
+  if(model>=models.size() || nameId==0)
+    return ANIMATION_ID_INVALID;
+  const Model& m     = models[model];
+  auto         begin = byName.begin()+m.firstAnimation;
+  auto         end   = begin+m.numAnimations;
+  auto         it    = std::upper_bound(begin,end,nameId,[](uint32_t id, const std::pair<uint32_t,AnimationId>& e) {
+    return id<e.first;
+    });
+  if(it==begin || (it-1)->first!=nameId)
+    return ANIMATION_ID_INVALID;
+  return (it-1)->second;
+  }
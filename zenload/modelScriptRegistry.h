@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "animationEvents.h"
+#include "zCModelScript.h"
+
+namespace VDFS
+{
+class FileIndex;
+}
+
+namespace ZenLoad
+{
+class ModelScriptCache;
+
+using AnimationId = uint32_t;
+using ModelId     = uint32_t;
+enum : uint32_t {
+  ANIMATION_ID_INVALID = uint32_t(-1),
+  MODEL_ID_INVALID     = uint32_t(-1),
+  };
+
+/**
+ * @brief Animations of many model scripts, with all names resolved to dense ids.
+ *
+ * Animation ids are global and the animations of one model are contiguous. Next-animations, alias targets
+ * and combo lists are resolved while loading, so following them at runtime is a plain array lookup.
+ * Names are interned into a StringPool, the same name has the same id in every model.
+ */
+class ModelScriptRegistry {
+  public:
+    enum class AnimationKind : uint8_t {
+      Ani,    // Animation with its own data (.MAN)
+      Alias,  // Plays another animation of the model with different settings
+      Comb,   // Blends a list of animations, see combo()
+      Blend,  // Only blends to the next animation
+      };
+
+    struct Animation {
+      uint32_t           name        = 0;  // Id in names()
+      ModelId            model       = MODEL_ID_INVALID;
+      AnimationKind      kind        = AnimationKind::Ani;
+      bool               disabled    = false;  // Named by aniDisable
+      EModelScriptAniDir dir         = MSB_FORWARD;
+      AnimationId        next        = ANIMATION_ID_INVALID;
+      AnimationId        source      = ANIMATION_ID_INVALID;  // Animation with the data, follows aliases. Itself for Ani.
+      uint32_t           layer       = 0;
+      uint32_t           flags       = 0;  // EModelScriptAniFlags
+      float              blendIn     = 0.f;
+      float              blendOut    = 0.f;
+      uint32_t           asc         = 0;  // Id in names() of the source file, the alias target or the combo prefix
+      int32_t            firstFrame  = 0;
+      int32_t            lastFrame   = 0;
+      float              maxFps      = 0.f;
+      float              speed       = 0.f;
+      float              colVolScale = 1.f;
+      uint32_t           comboFirst  = 0;  // Range in the combo table
+      uint32_t           comboCount  = 0;
+      };
+
+    struct Model {
+      uint32_t    name           = 0;  // Id in names(), the script name without extension
+      AnimationId firstAnimation = 0;
+      uint32_t    numAnimations  = 0;
+      uint32_t    mesh           = 0;  // Id in names() of meshAndTree
+      };
+
+    /**
+     * @brief Parses model scripts and adds them as models, in the order given
+     * @param files Script names. .MSB is read as binary, .MDS as text. Without extension .MSB is preferred.
+     * @param cache Optional, if set all scripts are taken from it and text scripts are compiled once
+     * @param numThreads Threads to parse on, 1 parses on the calling thread
+     * @return Number of scripts loaded
+     */
+    size_t load(const std::vector<std::string>& files, const VDFS::FileIndex& index, size_t numThreads = 1,
+                ModelScriptCache* cache = nullptr);
+
+    void clear();
+
+    /**
+     * @brief Name lookups, meant for setting up. Ids should be kept instead of calling these per frame.
+     */
+    ModelId     findModel(const std::string& name) const;
+    AnimationId findAnimation(ModelId model, const std::string& name) const;
+    AnimationId findAnimation(ModelId model, uint32_t nameId) const;
+
+    const Model&     model(ModelId id) const { return models[id]; }
+    const Animation& animation(AnimationId id) const { return animations[id]; }
+    size_t           modelCount() const { return models.size(); }
+    size_t           animationCount() const { return animations.size(); }
+
+    AnimationId next(AnimationId id) const { return animations[id].next; }
+    AnimationId source(AnimationId id) const { return animations[id].source; }
+
+    /**
+     * @return Animations blended by a combo, ANIMATION_ID_INVALID for the ones missing in the model
+     */
+    const AnimationId* combo(AnimationId id, size_t& count) const {
+      count = animations[id].comboCount;
+      return comboIds.data()+animations[id].comboFirst;
+      }
+
+    const StringPool&  names() const { return pool; }
+    const std::string& name(uint32_t id) const { return pool.get(id); }
+
+  private:
+    struct Entry;
+    struct Parsed;
+
+    static bool parse(const std::string& file, const VDFS::FileIndex& index, ModelScriptCache* cache, Parsed& out);
+    void        add(const std::string& file, const Parsed& script);
+
+    StringPool                             pool;
+    std::vector<Model>                     models;
+    std::vector<Animation>                 animations;
+    std::vector<AnimationId>               comboIds;
+    std::vector<std::pair<uint32_t,AnimationId>> byName;  // Per model sorted by name id, same range as the animations
+    std::unordered_map<std::string,ModelId> modelIds;
+  };
+}  // namespace ZenLoad
@@ -0,0 +1,88 @@
+#include "morphBlending.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "parallel.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace ZenLoad;
+
+// Vertices blended per block before they are scattered to the positions
+static const size_t BLOCK = 64;
+
+// out[i] = a*s0[i] + b*s1[i] over count floats
+static void blendSamples(const float* s0, const float* s1, float a, float b, float* out, size_t count) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 va = _mm_set1_ps(a);
+  const __m128 vb = _mm_set1_ps(b);
+  for(; i+4<=count; i+=4) {
+    const __m128 x = _mm_mul_ps(_mm_loadu_ps(s0+i),va);
+    const __m128 y = _mm_mul_ps(_mm_loadu_ps(s1+i),vb);
+    _mm_store_ps(out+i,_mm_add_ps(x,y));
+    }
+#endif
+  for(; i<count; ++i)
+    out[i] = s0[i]*a + s1[i]*b;
+  }
+
+void ZenLoad::applyMorph(const MorphLayer& layer, ZMath::float3* positions) {
+  const zCMorphMesh::Animation* ani = layer.animation;
+  if(ani==nullptr || layer.weight==0.f || ani->numFrames==0 || ani->vertexIndex.empty())
+    return;
+  const size_t   numVerts  = ani->vertexIndex.size();
+  const uint32_t numFrames = ani->numFrames;
+  if(ani->samples.size()<size_t(numFrames)*numVerts)
+    return;
+
+  float frame = layer.frame;
+  if(layer.loop) {
+    frame = std::fmod(frame,float(numFrames));
+    if(frame<0.f)
+      frame += float(numFrames);
+    } else {
+    frame = std::max(0.f,std::min(frame,float(numFrames-1)));
+    }
+  const uint32_t f0 = std::min(uint32_t(frame),numFrames-1);
+  const uint32_t f1 = f0+1<numFrames ? f0+1 : (layer.loop ? 0 : f0);
+  const float    t  = frame-float(f0);
+
+  // Samples of one frame are contiguous: blend both frames as a flat float stream, then scatter by index
+  const float*    s0  = &ani->samples[size_t(f0)*numVerts].x;
+  const float*    s1  = &ani->samples[size_t(f1)*numVerts].x;
+  const uint32_t* idx = ani->vertexIndex.data();
+  const float     a   = layer.weight*(1.f-t);
+  const float     b   = layer.weight*t;
+
+  alignas(16) float delta[BLOCK*3];
+  for(size_t begin=0; begin<numVerts; begin+=BLOCK) {
+    const size_t count = std::min(BLOCK,numVerts-begin);
+    blendSamples(s0+begin*3,s1+begin*3,a,b,delta,count*3);
+    for(size_t i=0; i<count; ++i) {
+      ZMath::float3& p = positions[idx[begin+i]];
+      p.x += delta[i*3+0];
+      p.y += delta[i*3+1];
+      p.z += delta[i*3+2];
+      }
+    }
+  }
+
+static void applyRange(const MorphInstance* instances, size_t count) {
+  for(size_t i=0; i<count; ++i) {
+    const MorphInstance& inst = instances[i];
+    for(size_t l=0; l<inst.numLayers; ++l)
+      applyMorph(inst.layers[l],inst.positions);
+    }
+  }
+
+void ZenLoad::applyMorphs(const MorphInstance* instances, size_t numInstances, size_t numThreads) {
+  // Every instance has its own positions, so the instances can be split without synchronization
+  parallelRanges(numInstances,numThreads,[instances](size_t begin, size_t count) {
+    applyRange(instances+begin,count);
+    });
+  }
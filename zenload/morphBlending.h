@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "zCMorphMesh.h"
+
+namespace ZenLoad
+{
+/**
+ * @brief One playing morph animation, e.g. a viseme or a blink
+ */
+struct MorphLayer {
+  const zCMorphMesh::Animation* animation = nullptr;
+  float                         frame     = 0.f;  // Fractional, interpolated between the two nearest frames
+  float                         weight    = 1.f;
+  bool                          loop      = true; // Interpolate the last frame towards the first one
+  };
+
+/**
+ * @brief One head to be morphed. The samples of all layers are added to the positions in place,
+ *        which are usually initialized from zCMorphMesh::getMorphPositions first.
+ */
+struct MorphInstance {
+  const MorphLayer* layers    = nullptr;
+  size_t            numLayers = 0;
+  ZMath::float3*    positions = nullptr;
+  };
+
+/**
+ * @brief Adds one weighted, interpolated frame of a morph animation to the positions
+ * @param positions Must hold every vertex the animation indexes, as zCMorphMesh::getMorphPositions does
+ *                  for the animations of the same mesh
+ */
+void applyMorph(const MorphLayer& layer, ZMath::float3* positions);
+
+/**
+ * @brief Applies the layers of every instance
+ * @param numThreads Threads to split the instances over, 1 runs on the calling thread only
+ */
+void applyMorphs(const MorphInstance* instances, size_t numInstances, size_t numThreads = 1);
+}  // namespace ZenLoad
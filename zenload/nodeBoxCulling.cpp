@@ -0,0 +1,274 @@
+#include "nodeBoxCulling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "zCMeshSoftSkin.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace ZenLoad;
+
+void NodeBoxSoA::resize(size_t count) {
+  // Four lanes may be loaded from any box, so there are three empty boxes after the last one
+  const size_t padded = count+3;
+  for(int i=0; i<3; ++i) {
+    center[i].resize(padded,0.f);
+    extent[i].resize(padded,0.f);
+    for(int j=0; j<3; ++j)
+      axis[i][j].resize(padded,i==j ? 1.f : 0.f);
+    }
+  }
+
+static void setBox(NodeBoxSoA& soa, size_t i, const ZMath::float3& c, const ZMath::float3* a, const ZMath::float3& e) {
+  for(int k=0; k<3; ++k) {
+    // Keep the axes unit length, a scaled axis is moved into the extent
+    const float len = std::sqrt(a[k].x*a[k].x + a[k].y*a[k].y + a[k].z*a[k].z);
+    const float inv = len>0.f ? 1.f/len : 0.f;
+    soa.center[k][i]  = c.v[k];
+    soa.extent[k][i]  = e.v[k]*len;
+    soa.axis[k][0][i] = a[k].x*inv;
+    soa.axis[k][1][i] = a[k].y*inv;
+    soa.axis[k][2][i] = a[k].z*inv;
+    }
+  }
+
+void NodeBoxHierarchy::build(const zCMeshSoftSkin& skin) {
+  const std::vector<oBBox3d>&  roots = skin.getNodeBoxes();
+  const std::vector<int32_t>&  index = skin.getNodeIndexList();
+
+  std::vector<const oBBox3d*> order;
+  parents.clear();
+  nodes  .clear();
+  levels .assign(1,0);
+  for(size_t i=0; i<roots.size(); ++i) {
+    order  .push_back(&roots[i]);
+    parents.push_back(-1);
+    nodes  .push_back(i<index.size() ? uint32_t(index[i]) : uint32_t(i));
+    }
+  levels.push_back(order.size());
+
+  // Append the children of every level as the next one
+  while(levels[levels.size()-2]<levels.back()) {
+    for(size_t p=levels[levels.size()-2]; p<levels.back(); ++p) {
+      for(const oBBox3d& c:order[p]->children) {
+        order  .push_back(&c);
+        parents.push_back(int32_t(p));
+        nodes  .push_back(nodes[p]);
+        }
+      }
+    if(order.size()==levels.back())
+      break;
+    levels.push_back(order.size());
+    }
+
+  boxes.resize(order.size());
+  leaves.resize(order.size());
+  for(size_t i=0; i<order.size(); ++i) {
+    setBox(boxes,i,order[i]->center,order[i]->axis,order[i]->extends);
+    leaves[i] = order[i]->children.empty() ? 1 : 0;
+    }
+  }
+
+void NodeBoxHierarchy::pose(const ZMath::Matrix* nodeTransforms, NodeBoxSoA& out) const {
+  out.resize(size());
+  for(size_t i=0; i<size(); ++i) {
+    ZMath::float3 c(boxes.center[0][i],boxes.center[1][i],boxes.center[2][i]);
+    ZMath::float3 e(boxes.extent[0][i],boxes.extent[1][i],boxes.extent[2][i]);
+    ZMath::float3 a[3];
+    for(int k=0; k<3; ++k)
+      a[k] = ZMath::float3(boxes.axis[k][0][i],boxes.axis[k][1][i],boxes.axis[k][2][i]);
+
+    if(nodeTransforms!=nullptr) {
+      // Row vectors, translation in _41.._43
+      const ZMath::Matrix& m = nodeTransforms[nodes[i]];
+      c = ZMath::float3(c.x*m._11 + c.y*m._21 + c.z*m._31 + m._41,
+                        c.x*m._12 + c.y*m._22 + c.z*m._32 + m._42,
+                        c.x*m._13 + c.y*m._23 + c.z*m._33 + m._43);
+      for(int k=0; k<3; ++k)
+        a[k] = ZMath::float3(a[k].x*m._11 + a[k].y*m._21 + a[k].z*m._31,
+                             a[k].x*m._12 + a[k].y*m._22 + a[k].z*m._32,
+                             a[k].x*m._13 + a[k].y*m._23 + a[k].z*m._33);
+      }
+    setBox(out,i,c,a,e);
+    }
+  }
+
+// Runs test(begin,end,flags) on every level. Children of boxes that were not hit are cleared, and once a level
+// has no hit at all the levels below are cleared without testing them.
+template<class Test>
+static bool cullLevels(const NodeBoxHierarchy& h, uint8_t* flags, const Test& test) {
+  bool rootHit = false;
+  for(size_t l=0; l<h.levelCount(); ++l) {
+    const size_t begin = h.levelBegin(l), end = h.levelEnd(l);
+    test(begin,end,flags);
+
+    bool levelHit = false;
+    for(size_t i=begin; i<end; ++i) {
+      if(l>0 && flags[h.parent(i)]==0)
+        flags[i] = 0;
+      levelHit |= flags[i]!=0;
+      }
+    if(l==0)
+      rootHit = levelHit;
+    if(!levelHit) {
+      std::memset(flags+end,0,h.size()-end);
+      break;
+      }
+    }
+  return rootHit;
+  }
+
+#if defined(__SSE2__)
+static inline __m128 absPs(__m128 v) {
+  return _mm_andnot_ps(_mm_set1_ps(-0.f),v);
+  }
+
+static inline __m128 dot3(__m128 x0, __m128 y0, __m128 z0, __m128 x1, __m128 y1, __m128 z1) {
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0,x1),_mm_mul_ps(y0,y1)),_mm_mul_ps(z0,z1));
+  }
+
+// Writes the lanes of a compare mask for the boxes i..end
+static inline void storeFlags(__m128 mask, size_t i, size_t end, uint8_t* flags) {
+  const int bits = _mm_movemask_ps(mask);
+  for(size_t j=0; j<4 && i+j<end; ++j)
+    flags[i+j] = uint8_t((bits>>j) & 1);
+  }
+#endif
+
+bool ZenLoad::cullFrustum(const NodeBoxHierarchy& h, const NodeBoxSoA& b, const ZMath::float4* planes, size_t numPlanes,
+                          uint8_t* visible) {
+  return cullLevels(h,visible,[&](size_t begin, size_t end, uint8_t* flags) {
+    size_t i = begin;
+#if defined(__SSE2__)
+    for(; i<end; i+=4) {
+      const __m128 cx = _mm_loadu_ps(&b.center[0][i]), cy = _mm_loadu_ps(&b.center[1][i]), cz = _mm_loadu_ps(&b.center[2][i]);
+      __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+      for(size_t p=0; p<numPlanes; ++p) {
+        const __m128 nx = _mm_set1_ps(planes[p].x), ny = _mm_set1_ps(planes[p].y), nz = _mm_set1_ps(planes[p].z);
+        const __m128 d  = _mm_add_ps(dot3(nx,ny,nz,cx,cy,cz),_mm_set1_ps(planes[p].w));
+        __m128 r = _mm_setzero_ps();
+        for(int k=0; k<3; ++k) {
+          const __m128 an = dot3(nx,ny,nz,_mm_loadu_ps(&b.axis[k][0][i]),_mm_loadu_ps(&b.axis[k][1][i]),_mm_loadu_ps(&b.axis[k][2][i]));
+          r = _mm_add_ps(r,_mm_mul_ps(_mm_loadu_ps(&b.extent[k][i]),absPs(an)));
+          }
+        inside = _mm_and_ps(inside,_mm_cmpge_ps(_mm_add_ps(d,r),_mm_setzero_ps()));
+        }
+      storeFlags(inside,i,end,flags);
+      }
+#endif
+    for(; i<end; ++i) {
+      bool inside = true;
+      for(size_t p=0; p<numPlanes && inside; ++p) {
+        const ZMath::float4& n = planes[p];
+        float r = 0.f;
+        for(int k=0; k<3; ++k)
+          r += b.extent[k][i]*std::fabs(n.x*b.axis[k][0][i] + n.y*b.axis[k][1][i] + n.z*b.axis[k][2][i]);
+        inside = n.x*b.center[0][i] + n.y*b.center[1][i] + n.z*b.center[2][i] + n.w + r>=0.f;
+        }
+      flags[i] = inside ? 1 : 0;
+      }
+    });
+  }
+
+bool ZenLoad::intersectSphere(const NodeBoxHierarchy& h, const NodeBoxSoA& b, const ZMath::float3& center, float radius,
+                              uint8_t* hit) {
+  return cullLevels(h,hit,[&](size_t begin, size_t end, uint8_t* flags) {
+    size_t i = begin;
+#if defined(__SSE2__)
+    const __m128 sx = _mm_set1_ps(center.x), sy = _mm_set1_ps(center.y), sz = _mm_set1_ps(center.z);
+    const __m128 r2 = _mm_set1_ps(radius*radius);
+    for(; i<end; i+=4) {
+      // Distance from the sphere center to the box, measured along the box axes
+      const __m128 vx = _mm_sub_ps(sx,_mm_loadu_ps(&b.center[0][i]));
+      const __m128 vy = _mm_sub_ps(sy,_mm_loadu_ps(&b.center[1][i]));
+      const __m128 vz = _mm_sub_ps(sz,_mm_loadu_ps(&b.center[2][i]));
+      __m128 dist2 = _mm_setzero_ps();
+      for(int k=0; k<3; ++k) {
+        const __m128 p = dot3(vx,vy,vz,_mm_loadu_ps(&b.axis[k][0][i]),_mm_loadu_ps(&b.axis[k][1][i]),_mm_loadu_ps(&b.axis[k][2][i]));
+        const __m128 q = _mm_max_ps(_mm_sub_ps(absPs(p),_mm_loadu_ps(&b.extent[k][i])),_mm_setzero_ps());
+        dist2 = _mm_add_ps(dist2,_mm_mul_ps(q,q));
+        }
+      storeFlags(_mm_cmple_ps(dist2,r2),i,end,flags);
+      }
+#endif
+    for(; i<end; ++i) {
+      const float vx = center.x-b.center[0][i], vy = center.y-b.center[1][i], vz = center.z-b.center[2][i];
+      float dist2 = 0.f;
+      for(int k=0; k<3; ++k) {
+        const float p = vx*b.axis[k][0][i] + vy*b.axis[k][1][i] + vz*b.axis[k][2][i];
+        const float q = std::max(std::fabs(p)-b.extent[k][i],0.f);
+        dist2 += q*q;
+        }
+      flags[i] = dist2<=radius*radius ? 1 : 0;
+      }
+    });
+  }
+
+bool ZenLoad::intersectRay(const NodeBoxHierarchy& h, const NodeBoxSoA& b, const ZMath::float3& origin,
+                           const ZMath::float3& dir, float maxDistance, uint8_t* hit, int32_t& nearestBox, float& nearest) {
+  // Entry distance of every box, only valid where the box is hit
+  std::vector<float> entry(b.size());
+  const bool any = cullLevels(h,hit,[&](size_t begin, size_t end, uint8_t* flags) {
+    size_t i = begin;
+#if defined(__SSE2__)
+    const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+    const __m128 dx = _mm_set1_ps(dir.x),    dy = _mm_set1_ps(dir.y),    dz = _mm_set1_ps(dir.z);
+    for(; i<end; i+=4) {
+      // Slab test in the frame of the box
+      const __m128 vx = _mm_sub_ps(ox,_mm_loadu_ps(&b.center[0][i]));
+      const __m128 vy = _mm_sub_ps(oy,_mm_loadu_ps(&b.center[1][i]));
+      const __m128 vz = _mm_sub_ps(oz,_mm_loadu_ps(&b.center[2][i]));
+      __m128 tMin = _mm_setzero_ps(), tMax = _mm_set1_ps(maxDistance);
+      for(int k=0; k<3; ++k) {
+        const __m128 ax = _mm_loadu_ps(&b.axis[k][0][i]), ay = _mm_loadu_ps(&b.axis[k][1][i]), az = _mm_loadu_ps(&b.axis[k][2][i]);
+        const __m128 o  = dot3(vx,vy,vz,ax,ay,az);
+        const __m128 d  = dot3(dx,dy,dz,ax,ay,az);
+        const __m128 e  = _mm_loadu_ps(&b.extent[k][i]);
+        const __m128 inv = _mm_div_ps(_mm_set1_ps(1.f),d);
+        const __m128 t0  = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_setzero_ps(),e),o),inv);
+        const __m128 t1  = _mm_mul_ps(_mm_sub_ps(e,o),inv);
+        // A ray parallel to the slab gives NaN or infinities: min/max return the second operand for NaN,
+        // so the current interval is kept, and the ray is rejected below if it starts outside the slab
+        tMin = _mm_max_ps(_mm_min_ps(t0,t1),tMin);
+        tMax = _mm_min_ps(_mm_max_ps(t0,t1),tMax);
+        const __m128 parallelOut = _mm_and_ps(_mm_cmpeq_ps(d,_mm_setzero_ps()),_mm_cmpgt_ps(absPs(o),e));
+        tMax = _mm_or_ps(_mm_andnot_ps(parallelOut,tMax),_mm_and_ps(parallelOut,_mm_set1_ps(-1.f)));
+        }
+      _mm_storeu_ps(&entry[i],tMin);
+      storeFlags(_mm_cmple_ps(tMin,tMax),i,end,flags);
+      }
+#endif
+    for(; i<end; ++i) {
+      const float vx = origin.x-b.center[0][i], vy = origin.y-b.center[1][i], vz = origin.z-b.center[2][i];
+      float tMin = 0.f, tMax = maxDistance;
+      for(int k=0; k<3 && tMin<=tMax; ++k) {
+        const float o = vx*b.axis[k][0][i] + vy*b.axis[k][1][i] + vz*b.axis[k][2][i];
+        const float d = dir.x*b.axis[k][0][i] + dir.y*b.axis[k][1][i] + dir.z*b.axis[k][2][i];
+        const float e = b.extent[k][i];
+        if(d==0.f) {
+          if(std::fabs(o)>e)
+            tMax = -1.f;
+          continue;
+          }
+        const float t0 = (-e-o)/d, t1 = (e-o)/d;
+        tMin = std::max(tMin,std::min(t0,t1));
+        tMax = std::min(tMax,std::max(t0,t1));
+        }
+      entry[i] = tMin;
+      flags[i] = tMin<=tMax ? 1 : 0;
+      }
+    });
+
+  nearestBox = -1;
+  nearest    = maxDistance;
+  for(size_t i=0; i<h.size(); ++i)
+    if(hit[i] && h.isLeaf(i) && entry[i]<=nearest) {
+      nearestBox = int32_t(i);
+      nearest    = entry[i];
+      }
+  return any;
+  }
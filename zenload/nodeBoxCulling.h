@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "utils/mathlib.h"
+
+namespace ZenLoad
+{
+class zCMeshSoftSkin;
+
+/**
+ * @brief Oriented boxes as structure of arrays, padded so four boxes can be loaded from every index
+ */
+struct NodeBoxSoA {
+  std::vector<float> center[3];
+  std::vector<float> axis[3][3];  // axis[i][component], unit length
+  std::vector<float> extent[3];   // Half sizes along the axes
+
+  void   resize(size_t count);
+  size_t size() const { return center[0].size(); }  // Including the padding
+  };
+
+/**
+ * @brief The node bounding boxes of a zCMeshSoftSkin, flattened in breadth-first order.
+ *
+ * The boxes of all nodes form the first level, their children the following ones, so every level
+ * is a contiguous range and parents always come before their children. Boxes are in the space of
+ * their node and are moved with the model-space node transforms (see MeshSkinning::computeNodeTransforms).
+ */
+class NodeBoxHierarchy {
+  public:
+    NodeBoxHierarchy() = default;
+    explicit NodeBoxHierarchy(const zCMeshSoftSkin& skin) { build(skin); }
+
+    void build(const zCMeshSoftSkin& skin);
+
+    /**
+     * @brief Moves the boxes into model space
+     * @param nodeTransforms One per node of the model, indexed like zCModelMeshLib::getNodes(). nullptr keeps the boxes as stored.
+     */
+    void pose(const ZMath::Matrix* nodeTransforms, NodeBoxSoA& out) const;
+
+    size_t            size()       const { return parents.size(); }
+    size_t            levelCount() const { return levels.empty() ? 0 : levels.size()-1; }
+    size_t            levelBegin(size_t l) const { return levels[l]; }
+    size_t            levelEnd  (size_t l) const { return levels[l+1]; }
+    int32_t           parent(size_t box) const { return parents[box]; }  // -1 for the boxes of the first level
+    uint32_t          node  (size_t box) const { return nodes[box]; }    // Model node the box moves with
+    bool              isLeaf(size_t box) const { return leaves[box]!=0; }
+    const NodeBoxSoA& rest() const { return boxes; }
+
+  private:
+    NodeBoxSoA            boxes;
+    std::vector<int32_t>  parents;
+    std::vector<uint32_t> nodes;
+    std::vector<uint8_t>  leaves;
+    std::vector<size_t>   levels;
+  };
+
+/**
+ * @brief Culls posed boxes against convex volumes. Each test writes one flag per box, a box only counts
+ *        as hit if its parent is hit as well. Levels below the last one with a hit are not tested at all.
+ * @return Whether any box of the first level was hit, false rejects the whole model
+ */
+bool cullFrustum(const NodeBoxHierarchy& h, const NodeBoxSoA& posed, const ZMath::float4* planes, size_t numPlanes,
+                 uint8_t* visible);  // Planes: dot(xyz,p)+w>=0 is inside
+
+bool intersectSphere(const NodeBoxHierarchy& h, const NodeBoxSoA& posed, const ZMath::float3& center, float radius,
+                     uint8_t* hit);
+
+/**
+ * @brief Ray test, additionally reports the nearest hit of a leaf box
+ * @param maxDistance Length of the ray in units of dir
+ * @param nearest Box and distance of the nearest leaf hit, box is -1 if there is none
+ */
+bool intersectRay(const NodeBoxHierarchy& h, const NodeBoxSoA& posed, const ZMath::float3& origin,
+                  const ZMath::float3& dir, float maxDistance, uint8_t* hit, int32_t& nearestBox, float& nearest);
+}  // namespace ZenLoad
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace ZenLoad
+{
+/**
+ * @brief Calls fn(i,worker) for every i in [0,count), handing the indices out one at a time,
+ *        so items of uneven cost balance out over the threads.
+ * @param numThreads Threads to run on, 1 runs on the calling thread only. The calling thread is worker 0,
+ *                   workers are numbered below min(numThreads,count).
+ */
+template<class Fn>
+void parallelFor(size_t count, size_t numThreads, const Fn& fn) {
+  numThreads = std::max<size_t>(1,std::min(numThreads,count));
+  std::atomic<size_t> next(0);
+  auto worker = [&](size_t id) {
+    for(size_t i=next++; i<count; i=next++)
+      fn(i,id);
+    };
+
+  std::vector<std::thread> threads;
+  for(size_t i=1; i<numThreads; ++i)
+    threads.emplace_back(worker,i);
+  worker(0);
+  for(auto& t:threads)
+    t.join();
+  }
+
+/**
+ * @brief Splits [0,count) into one contiguous range per thread and calls fn(begin,num) for each,
+ *        for items of about the same cost which are cheaper to process in runs.
+ * @param numThreads Threads to run on, 1 runs on the calling thread only, which takes the first range
+ */
+template<class Fn>
+void parallelRanges(size_t count, size_t numThreads, const Fn& fn) {
+  numThreads = std::max<size_t>(1,std::min(numThreads,count));
+  if(numThreads==1) {
+    fn(size_t(0),count);
+    return;
+    }
+
+  const size_t perThread = (count+numThreads-1)/numThreads;
+  std::vector<std::thread> workers;
+  for(size_t begin=perThread; begin<count; begin+=perThread)
+    workers.emplace_back(fn,begin,std::min(perThread,count-begin));
+  fn(size_t(0),std::min(perThread,count));
+  for(std::thread& th:workers)
+    th.join();
+  }
+}  // namespace ZenLoad
@@ -0,0 +1,446 @@
+#include "portalVisibility.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include "zCMesh.h"
+
+using namespace ZenLoad;
+
+static const float    PLANE_EPSILON = 1.f;  // World units
+static const uint32_t MAX_DEPTH     = 64;
+
+namespace
+{
+using Polygon = std::vector<ZMath::float3>;
+
+struct Plane {
+  ZMath::float3 n;
+  float         d = 0.f;
+
+  float dist(const ZMath::float3& p) const { return n.x*p.x + n.y*p.y + n.z*p.z - d; }
+  };
+
+struct Portal {
+  Polygon  poly;
+  Plane    plane;
+  uint32_t node[2];
+  int      side[2];  // Sign of the plane distance on the side of node[i], 0 if unknown
+  };
+
+struct Link {
+  uint32_t portal;
+  uint32_t to;
+  int      farSide;  // Side of the portal plane 'to' is on
+  };
+
+ZMath::float3 sub(const ZMath::float3& a, const ZMath::float3& b) {
+  return ZMath::float3(a.x-b.x,a.y-b.y,a.z-b.z);
+  }
+
+ZMath::float3 cross(const ZMath::float3& a, const ZMath::float3& b) {
+  return ZMath::float3(a.y*b.z-a.z*b.y,a.z*b.x-a.x*b.z,a.x*b.y-a.y*b.x);
+  }
+
+float dot(const ZMath::float3& a, const ZMath::float3& b) {
+  return a.x*b.x + a.y*b.y + a.z*b.z;
+  }
+
+bool makePlane(const ZMath::float3& a, const ZMath::float3& b, const ZMath::float3& c, Plane& out) {
+  ZMath::float3 n = cross(sub(b,a),sub(c,a));
+  const float   l = std::sqrt(dot(n,n));
+  if(l<=1e-6f)
+    return false;
+  out.n = n*(1.f/l);
+  out.d = dot(out.n,a);
+  return true;
+  }
+
+// Newell's method, robust for the slightly non-planar polygons of the mesh
+bool polygonPlane(const Polygon& poly, Plane& out) {
+  ZMath::float3 n(0,0,0), c(0,0,0);
+  for(size_t i=0; i<poly.size(); ++i) {
+    const ZMath::float3& a = poly[i];
+    const ZMath::float3& b = poly[(i+1)%poly.size()];
+    n.x += (a.y-b.y)*(a.z+b.z);
+    n.y += (a.z-b.z)*(a.x+b.x);
+    n.z += (a.x-b.x)*(a.y+b.y);
+    c.x += a.x; c.y += a.y; c.z += a.z;
+    }
+  const float l = std::sqrt(dot(n,n));
+  if(poly.size()<3 || l<=1e-6f)
+    return false;
+  out.n = n*(1.f/l);
+  out.d = dot(out.n,c)/float(poly.size());
+  return true;
+  }
+
+int signOf(float d) {
+  return d>PLANE_EPSILON ? 1 : (d<-PLANE_EPSILON ? -1 : 0);
+  }
+
+// Keeps the part of the polygon with sign*dist >= -epsilon
+void clip(Polygon& poly, const Plane& pl, int sign) {
+  if(poly.empty())
+    return;
+  Polygon out;
+  out.reserve(poly.size()+1);
+  for(size_t i=0; i<poly.size(); ++i) {
+    const ZMath::float3& a  = poly[i];
+    const ZMath::float3& b  = poly[(i+1)%poly.size()];
+    const float          da = float(sign)*pl.dist(a);
+    const float          db = float(sign)*pl.dist(b);
+    if(da>=-PLANE_EPSILON)
+      out.push_back(a);
+    if((da>=-PLANE_EPSILON)!=(db>=-PLANE_EPSILON)) {
+      const float t = (da+PLANE_EPSILON)/(da-db);
+      out.emplace_back(a.x+(b.x-a.x)*t,a.y+(b.y-a.y)*t,a.z+(b.z-a.z)*t);
+      }
+    }
+  poly.swap(out);
+  if(poly.size()<3)
+    poly.clear();
+  }
+
+/**
+ * Clips the target by every plane through an edge of 'edges' and a vertex of 'points', which has both polygons
+ * on opposite sides. Any line through source and pass portal stays on the side of the pass portal behind it.
+ */
+void clipBySeparators(const Polygon& edges, const Polygon& points, bool edgesAreSource, Polygon& target) {
+  for(size_t i=0; i<edges.size() && !target.empty(); ++i) {
+    const ZMath::float3& e0 = edges[i];
+    const ZMath::float3& e1 = edges[(i+1)%edges.size()];
+    for(const ZMath::float3& p:points) {
+      Plane pl;
+      if(!makePlane(e0,e1,p,pl))
+        continue;
+
+      int  edgeSide = 0;
+      bool valid    = true;
+      for(const ZMath::float3& v:edges) {
+        const int s = signOf(pl.dist(v));
+        if(s==0)
+          continue;
+        if(edgeSide!=0 && s!=edgeSide) {
+          valid = false;
+          break;
+          }
+        edgeSide = s;
+        }
+      if(!valid || edgeSide==0)
+        continue;
+
+      bool pointsOff = false;
+      for(const ZMath::float3& v:points) {
+        const int s = signOf(pl.dist(v));
+        if(s==edgeSide) {
+          valid = false;
+          break;
+          }
+        pointsOff |= s!=0;
+        }
+      if(!valid || !pointsOff)
+        continue;
+
+      clip(target,pl,edgesAreSource ? -edgeSide : edgeSide);
+      if(target.empty())
+        return;
+      }
+    }
+  }
+
+struct Flow {
+  const std::vector<Portal>&            portals;
+  const std::vector<std::vector<Link>>& links;
+  std::vector<uint8_t>                  onStack;
+  std::vector<uint8_t>                  visible;
+  std::vector<uint8_t>                  flooded;
+  std::vector<uint32_t>                 floodStack;
+  const Portal*                         source    = nullptr;
+  int                                   sourceFar = 0;
+
+  Flow(const std::vector<Portal>& portals, const std::vector<std::vector<Link>>& links)
+    :portals(portals), links(links), onStack(links.size(),0), visible(links.size(),0), flooded(links.size(),0) {}
+
+  void reset() {
+    std::fill(visible.begin(),visible.end(),0);
+    std::fill(flooded.begin(),flooded.end(),0);
+    }
+
+  void run(uint32_t node, uint32_t entered, const Polygon* pass, const Plane* passPlane, int passFar, uint32_t depth) {
+    visible[node] = 1;
+    if(depth>=MAX_DEPTH) {
+      // Too deep to clip any further, take everything behind as visible to stay conservative
+      floodFill(node);
+      return;
+      }
+    onStack[node] = 1;
+    for(const Link& l:links[node]) {
+      if(l.portal==entered || onStack[l.to])
+        continue;
+
+      const Portal& t = portals[l.portal];
+      Polygon poly = t.poly;
+      if(sourceFar!=0)
+        clip(poly,source->plane,sourceFar);
+      if(pass!=nullptr && !poly.empty()) {
+        if(passFar!=0)
+          clip(poly,*passPlane,passFar);
+        clipBySeparators(source->poly,*pass,true, poly);
+        clipBySeparators(*pass,source->poly,false,poly);
+        }
+      if(poly.empty())
+        continue;
+      run(l.to,l.portal,&poly,&t.plane,l.farSide,depth+1);
+      }
+    onStack[node] = 0;
+    }
+
+  void floodFill(uint32_t node) {
+    if(flooded[node])
+      return;
+    flooded[node] = 1;
+    floodStack.push_back(node);
+    while(!floodStack.empty()) {
+      const uint32_t n = floodStack.back();
+      floodStack.pop_back();
+      visible[n] = 1;
+      for(const Link& l:links[n])
+        if(!flooded[l.to]) {
+          flooded[l.to] = 1;
+          floodStack.push_back(l.to);
+          }
+      }
+    }
+  };
+
+void compressRow(const std::vector<uint8_t>& bits, std::vector<uint8_t>& out) {
+  const size_t numBytes = (bits.size()+7)/8;
+  for(size_t i=0; i<numBytes;) {
+    uint8_t b = 0;
+    for(size_t j=0; j<8 && i*8+j<bits.size(); ++j)
+      if(bits[i*8+j])
+        b |= uint8_t(1<<j);
+    if(b!=0) {
+      out.push_back(b);
+      ++i;
+      continue;
+      }
+
+    // Count the run of zero bytes starting here
+    size_t run = 0;
+    while(i+run<numBytes && run<255) {
+      bool zero = true;
+      for(size_t j=0; j<8 && (i+run)*8+j<bits.size(); ++j)
+        zero &= bits[(i+run)*8+j]==0;
+      if(!zero)
+        break;
+      ++run;
+      }
+    out.push_back(0);
+    out.push_back(uint8_t(run));
+    i += run;
+    }
+  }
+}
+
+void PortalVisibility::build(const zCBspTreeData& tree, const zCMesh& mesh) {
+  build(tree,mesh.getPortalPolygons());
+  }
+
+void PortalVisibility::build(const zCBspTreeData& tree, const std::vector<zCPortalPolygon>& portalPolygons) {
+  const uint32_t outdoor = uint32_t(tree.sectors.size());
+  numSectors = outdoor+1;
+  data.clear();
+  sectorRows.clear();
+  leafRows.clear();
+
+  // Rough center of every sector, to find out which side of a portal it is on
+  std::vector<ZMath::float3> centers(outdoor,ZMath::float3(0,0,0));
+  std::vector<bool>          hasCenter(outdoor,false);
+  for(uint32_t s=0; s<outdoor; ++s) {
+    size_t cnt = 0;
+    for(uint32_t leaf:tree.sectors[s].bspNodeIndices) {
+      if(leaf>=tree.leafIndices.size() || tree.leafIndices[leaf]>=tree.nodes.size())
+        continue;
+      const zCBspNode& n = tree.nodes[tree.leafIndices[leaf]];
+      centers[s].x += (n.bbox3dMin.x+n.bbox3dMax.x)*0.5f;
+      centers[s].y += (n.bbox3dMin.y+n.bbox3dMax.y)*0.5f;
+      centers[s].z += (n.bbox3dMin.z+n.bbox3dMax.z)*0.5f;
+      ++cnt;
+      }
+    if(cnt>0) {
+      centers[s]   = centers[s]*(1.f/float(cnt));
+      hasCenter[s] = true;
+      }
+    }
+
+  std::map<uint32_t,const zCPortal*> portalOfMaterial;
+  for(const zCPortal& p:tree.portals)
+    portalOfMaterial[p.materialIndex] = &p;
+
+  std::vector<Portal> portals;
+  for(const zCPortalPolygon& pp:portalPolygons) {
+    auto it = portalOfMaterial.find(pp.materialIndex);
+    if(it==portalOfMaterial.end())
+      continue;
+
+    Portal p;
+    p.node[0] = it->second->frontSectorIndex<outdoor ? it->second->frontSectorIndex : outdoor;
+    p.node[1] = it->second->backSectorIndex <outdoor ? it->second->backSectorIndex  : outdoor;
+    p.poly    = pp.vertices;
+    if(p.node[0]==p.node[1] || !polygonPlane(p.poly,p.plane))
+      continue;
+
+    for(int i=0; i<2; ++i)
+      p.side[i] = (p.node[i]<outdoor && hasCenter[p.node[i]]) ? signOf(p.plane.dist(centers[p.node[i]])) : 0;
+    if(p.side[0]==0)
+      p.side[0] = -p.side[1];
+    if(p.side[1]==0)
+      p.side[1] = -p.side[0];
+    if(p.side[0]==p.side[1]) {
+      // Both centers on the same side, can't tell
+      p.side[0] = 0;
+      p.side[1] = 0;
+      }
+    portals.push_back(std::move(p));
+    }
+
+  std::vector<std::vector<Link>> links(numSectors);
+  for(uint32_t i=0; i<portals.size(); ++i) {
+    const Portal& p = portals[i];
+    links[p.node[0]].push_back({i,p.node[1],p.side[1]});
+    links[p.node[1]].push_back({i,p.node[0],p.side[0]});
+    }
+
+  // What can be seen through every portal, looking out of the sector it belongs to
+  std::vector<std::vector<std::vector<uint8_t>>> throughPortal(numSectors);
+  Flow flow(portals,links);
+  for(uint32_t s=0; s<numSectors; ++s) {
+    for(const Link& l:links[s]) {
+      flow.reset();
+      flow.source       = &portals[l.portal];
+      flow.sourceFar    = l.farSide;
+      flow.onStack[s]   = 1;
+      flow.run(l.to,l.portal,nullptr,nullptr,0,1);
+      flow.onStack[s]   = 0;
+      throughPortal[s].push_back(flow.visible);
+      }
+    }
+
+  std::vector<uint8_t> row(numSectors);
+  for(uint32_t s=0; s<numSectors; ++s) {
+    std::fill(row.begin(),row.end(),0);
+    row[s] = 1;
+    for(auto& v:throughPortal[s])
+      for(uint32_t i=0; i<numSectors; ++i)
+        row[i] |= v[i];
+    sectorRows.push_back(uint32_t(data.size()));
+    compressRow(row,data);
+    }
+
+  // Leaves only look through the portals they are in front of
+  std::vector<uint32_t> leafSector(tree.leafIndices.size(),outdoor);
+  for(uint32_t s=0; s<outdoor; ++s)
+    for(uint32_t leaf:tree.sectors[s].bspNodeIndices)
+      if(leaf<leafSector.size() && leafSector[leaf]==outdoor)
+        leafSector[leaf] = s;
+
+  std::map<std::vector<uint8_t>,uint32_t> known;
+  std::vector<uint8_t>                    packed;
+  for(size_t leaf=0; leaf<tree.leafIndices.size(); ++leaf) {
+    const uint32_t s = leafSector[leaf];
+    std::fill(row.begin(),row.end(),0);
+    row[s] = 1;
+
+    const bool hasBox = tree.leafIndices[leaf]<tree.nodes.size();
+    for(size_t k=0; k<links[s].size(); ++k) {
+      const Portal& p    = portals[links[s][k].portal];
+      const int     near = -links[s][k].farSide;
+      bool          sees = near==0 || !hasBox;
+      if(!sees) {
+        const zCBspNode& n = tree.nodes[tree.leafIndices[leaf]];
+        for(int c=0; c<8 && !sees; ++c) {
+          const ZMath::float3 corner((c&1) ? n.bbox3dMax.x : n.bbox3dMin.x,
+                                     (c&2) ? n.bbox3dMax.y : n.bbox3dMin.y,
+                                     (c&4) ? n.bbox3dMax.z : n.bbox3dMin.z);
+          sees = float(near)*p.plane.dist(corner)>=-PLANE_EPSILON;
+          }
+        }
+      if(sees)
+        for(uint32_t i=0; i<numSectors; ++i)
+          row[i] |= throughPortal[s][k][i];
+      }
+
+    packed.clear();
+    compressRow(row,packed);
+    auto ins = known.emplace(packed,uint32_t(data.size()));
+    if(ins.second)
+      data.insert(data.end(),packed.begin(),packed.end());
+    leafRows.push_back(ins.first->second);
+    }
+  }
+
+bool PortalVisibility::testBit(uint32_t offset, uint32_t bit) const {
+  const uint32_t target = bit/8;
+  uint32_t       pos    = 0;
+  for(size_t at=offset; at<data.size();) {
+    if(data[at]==0) {
+      pos += data[at+1];
+      if(target<pos)
+        return false;
+      at += 2;
+      continue;
+      }
+    if(pos==target)
+      return (data[at] & (1<<(bit%8)))!=0;
+    ++pos;
+    ++at;
+    }
+  return false;
+  }
+
+void PortalVisibility::decompress(uint32_t offset, std::vector<uint8_t>& bits) const {
+  bits.assign(numSectors,0);
+  uint32_t pos = 0;
+  for(size_t at=offset; at<data.size() && pos*8<numSectors;) {
+    if(data[at]==0) {
+      pos += data[at+1];
+      at  += 2;
+      continue;
+      }
+    for(uint32_t j=0; j<8 && pos*8+j<numSectors; ++j)
+      bits[pos*8+j] = (data[at]>>j) & 1;
+    ++pos;
+    ++at;
+    }
+  }
+
+bool PortalVisibility::isVisible(SectorIndex from, SectorIndex to) const {
+  if(numSectors==0)
+    return true;
+  return testBit(sectorRows[toRow(from)],toRow(to));
+  }
+
+bool PortalVisibility::isVisibleFromLeaf(uint32_t leaf, SectorIndex to) const {
+  if(leaf>=leafRows.size())
+    return true;
+  return testBit(leafRows[leaf],toRow(to));
+  }
+
+void PortalVisibility::decompressSectorRow(SectorIndex from, std::vector<uint8_t>& bits) const {
+  if(numSectors==0) {
+    bits.clear();
+    return;
+    }
+  decompress(sectorRows[toRow(from)],bits);
+  }
+
+void PortalVisibility::decompressLeafRow(uint32_t leaf, std::vector<uint8_t>& bits) const {
+  if(leaf>=leafRows.size()) {
+    bits.assign(numSectors,1);
+    return;
+    }
+  decompress(leafRows[leaf],bits);
+  }
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+class zCMesh;
+
+/**
+ * @brief Potentially visible sectors, precomputed from the portal polygons of the world.
+ *
+ * The outdoor world counts as one more sector, passed as SECTOR_INDEX_INVALID. A sector sees another one,
+ * if a line of sight may exist through the chain of portals in between. Portal chains are cut with separating
+ * planes, so the result is conservative: it may report too much, but never too little.
+ *
+ * Rows are stored as run-length compressed bitsets (a zero byte is followed by the number of zero bytes).
+ */
+class PortalVisibility {
+  public:
+    /**
+     * @param tree Loaded BSP-tree, with the portals connected
+     * @param mesh Worldmesh the tree was loaded with, for the portal polygons
+     */
+    void build(const zCBspTreeData& tree, const zCMesh& mesh);
+
+    /**
+     * @brief Same as above, with the portal polygons given directly
+     */
+    void build(const zCBspTreeData& tree, const std::vector<zCPortalPolygon>& portalPolygons);
+
+    /**
+     * @return Whether anything in sector 'to' may be visible from sector 'from'
+     */
+    bool isVisible(SectorIndex from, SectorIndex to) const;
+
+    /**
+     * @return Whether anything in sector 'to' may be visible from the given leaf (index into zCBspTreeData::leafIndices)
+     *         Tighter than the sector of the leaf, as portals facing away from the leaf are left out.
+     */
+    bool isVisibleFromLeaf(uint32_t leaf, SectorIndex to) const;
+
+    /**
+     * @brief Expands the row of a sector or leaf into one bit per sector, outdoors being the last one
+     */
+    void decompressSectorRow(SectorIndex from, std::vector<uint8_t>& bits) const;
+    void decompressLeafRow(uint32_t leaf, std::vector<uint8_t>& bits) const;
+
+    /**
+     * @return Number of sectors including outdoors, which is the last one
+     */
+    uint32_t sectorCount() const { return numSectors; }
+
+    /**
+     * @return Size of all compressed rows in bytes
+     */
+    size_t compressedSize() const { return data.size(); }
+
+  private:
+    uint32_t toRow(SectorIndex s) const { return s<numSectors-1 ? s : numSectors-1; }
+    bool     testBit(uint32_t offset, uint32_t bit) const;
+    void     decompress(uint32_t offset, std::vector<uint8_t>& bits) const;
+
+    uint32_t              numSectors = 0;
+    std::vector<uint8_t>  data;
+    std::vector<uint32_t> sectorRows;  // Offsets into data
+    std::vector<uint32_t> leafRows;    // Offsets into data, leaves with equal rows share them
+  };
+}  // namespace ZenLoad
@@ -0,0 +1,213 @@
+#include "poseEvaluator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "parallel.h"
+#include "utils/logger.h"
+#include "zCModelMeshLib.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace ZenLoad;
+
+ZMath::float4 ZenLoad::quatNlerp(const ZMath::float4& a, const ZMath::float4& b, float t) {
+#if defined(__SSE2__)
+  const __m128 qa = _mm_setr_ps(a.x,a.y,a.z,a.w);
+  __m128       qb = _mm_setr_ps(b.x,b.y,b.z,b.w);
+
+  __m128 d = _mm_mul_ps(qa,qb);
+  d = _mm_add_ps(d,_mm_shuffle_ps(d,d,_MM_SHUFFLE(2,3,0,1)));
+  d = _mm_add_ps(d,_mm_shuffle_ps(d,d,_MM_SHUFFLE(1,0,3,2)));
+  // Flip the sign of b if it is on the other hemisphere
+  const __m128 sign = _mm_and_ps(_mm_cmplt_ps(d,_mm_setzero_ps()),_mm_set1_ps(-0.f));
+  qb = _mm_xor_ps(qb,sign);
+
+  __m128 r = _mm_add_ps(qa,_mm_mul_ps(_mm_sub_ps(qb,qa),_mm_set1_ps(t)));
+  __m128 len = _mm_mul_ps(r,r);
+  len = _mm_add_ps(len,_mm_shuffle_ps(len,len,_MM_SHUFFLE(2,3,0,1)));
+  len = _mm_add_ps(len,_mm_shuffle_ps(len,len,_MM_SHUFFLE(1,0,3,2)));
+  r = _mm_div_ps(r,_mm_sqrt_ps(len));
+
+  alignas(16) float f[4];
+  _mm_store_ps(f,r);
+  return ZMath::float4(f[0],f[1],f[2],f[3]);
+#else
+  const float s   = (a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w)<0.f ? -1.f : 1.f;
+  const float x   = a.x + (b.x*s-a.x)*t;
+  const float y   = a.y + (b.y*s-a.y)*t;
+  const float z   = a.z + (b.z*s-a.z)*t;
+  const float w   = a.w + (b.w*s-a.w)*t;
+  const float inv = 1.f/std::sqrt(x*x + y*y + z*z + w*w);
+  return ZMath::float4(x*inv,y*inv,z*inv,w*inv);
+#endif
+  }
+
+ZMath::float4 ZenLoad::quatSlerp(const ZMath::float4& a, const ZMath::float4& b, float t) {
+  float d = a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
+  float s = 1.f;
+  if(d<0.f) {
+    d = -d;
+    s = -1.f;
+    }
+  if(d>0.9995f)
+    return quatNlerp(a,b,t);  // Nearly parallel, sin(theta) is too small to divide by
+
+  const float theta = std::acos(d);
+  const float inv   = 1.f/std::sin(theta);
+  const float wa    = std::sin((1.f-t)*theta)*inv;
+  const float wb    = std::sin(t*theta)*inv*s;
+  return ZMath::float4(a.x*wa + b.x*wb, a.y*wa + b.y*wb, a.z*wa + b.z*wb, a.w*wa + b.w*wb);
+  }
+
+void ZenLoad::quatToMatrix(const ZMath::float4& q, const ZMath::float3& position, ZMath::Matrix& out) {
+  const float xx = q.x*q.x, yy = q.y*q.y, zz = q.z*q.z;
+  const float xy = q.x*q.y, xz = q.x*q.z, yz = q.y*q.z;
+  const float wx = q.w*q.x, wy = q.w*q.y, wz = q.w*q.z;
+
+  // Rotation for column vectors, stored transposed like the hierarchy
+  out._11 = 1.f-2.f*(yy+zz); out._12 = 2.f*(xy+wz);     out._13 = 2.f*(xz-wy);     out._14 = 0.f;
+  out._21 = 2.f*(xy-wz);     out._22 = 1.f-2.f*(xx+zz); out._23 = 2.f*(yz+wx);     out._24 = 0.f;
+  out._31 = 2.f*(xz+wy);     out._32 = 2.f*(yz-wx);     out._33 = 1.f-2.f*(xx+yy); out._34 = 0.f;
+  out._41 = position.x;      out._42 = position.y;      out._43 = position.z;      out._44 = 1.f;
+  }
+
+void PoseEvaluator::build(const zCModelMeshLib& lib) {
+  hierarchy.build(lib);
+  nodeChecksum = lib.getNodeChecksum();
+
+  const std::vector<ModelNode>& nodes = lib.getNodes();
+  bindLocal.resize(nodes.size());
+  for(size_t i=0; i<nodes.size(); ++i)
+    bindLocal[i] = nodes[i].transformLocal;
+
+  clearCache();
+  }
+
+bool PoseEvaluator::makeRemap(const zCModelAni& ani, PoseRemap& out) const {
+  const zCModelAni::ModelAniHeader& h   = ani.getModelAniHeader();
+  const std::vector<uint32_t>&      idx = ani.getNodeIndexList();
+
+  out.nodeChecksum = h.nodeChecksum;
+  out.numNodes     = h.numNodes;
+  out.libNodes.clear();
+
+  if(h.nodeChecksum!=nodeChecksum) {
+    LogWarn() << "Animation " << h.aniName << " doesn't fit the hierarchy (node checksum mismatch)";
+    return false;
+    }
+  if(h.numNodes==0 || idx.size()!=h.numNodes || ani.getNumSamples()<size_t(h.numNodes)*h.numFrames)
+    return false;
+
+  out.libNodes.resize(h.numNodes);
+  for(size_t i=0; i<idx.size(); ++i) {
+    if(idx[i]>=bindLocal.size()) {
+      LogWarn() << "Animation " << h.aniName << " refers to node " << idx[i] << " of " << bindLocal.size();
+      out.libNodes.clear();
+      return false;
+      }
+    out.libNodes[i] = uint16_t(idx[i]);
+    }
+  return true;
+  }
+
+const PoseRemap& PoseEvaluator::remap(const zCModelAni& ani) {
+  const zCModelAni::ModelAniHeader& h = ani.getModelAniHeader();
+
+  std::lock_guard<std::mutex> guard(cacheSync);
+  auto it = cache.find(&ani);
+  if(it!=cache.end() && it->second.nodeChecksum==h.nodeChecksum && it->second.numNodes==h.numNodes)
+    return it->second;
+
+  PoseRemap& r = cache[&ani];
+  makeRemap(ani,r);
+  return r;
+  }
+
+void PoseEvaluator::clearCache() {
+  std::lock_guard<std::mutex> guard(cacheSync);
+  cache.clear();
+  }
+
+void PoseEvaluator::evaluateLocal(const zCModelAni& ani, const PoseRemap& remap, float frame, bool loop,
+                                  Interpolation mode, ZMath::Matrix* local) const {
+  std::vector<zCModelAni::AniSample> frames;
+  evaluateLocal(ani,remap,frame,loop,mode,local,frames);
+  }
+
+void PoseEvaluator::evaluateLocal(const zCModelAni& ani, const PoseRemap& remap, float frame, bool loop,
+                                  Interpolation mode, ZMath::Matrix* local,
+                                  std::vector<zCModelAni::AniSample>& frames) const {
+  std::copy(bindLocal.begin(),bindLocal.end(),local);
+
+  const uint32_t numFrames = ani.getModelAniHeader().numFrames;
+  if(!remap.isValid() || numFrames==0)
+    return;
+
+  float f = frame;
+  if(loop) {
+    f = std::fmod(f,float(numFrames));
+    if(f<0.f)
+      f += float(numFrames);
+    } else {
+    f = std::max(0.f,std::min(f,float(numFrames-1)));
+    }
+
+  uint32_t f0 = std::min(uint32_t(f),numFrames-1);
+  uint32_t f1 = f0+1;
+  if(f1>=numFrames)
+    f1 = loop ? 0 : numFrames-1;
+  const float t = f-float(f0);
+
+  const size_t                 numNodes = remap.numNodes;
+  const zCModelAni::AniSample* s0       = nullptr;
+  const zCModelAni::AniSample* s1       = nullptr;
+  if(ani.isQuantized()) {
+    // Only the two frames in use are decoded
+    frames.resize(numNodes*2);
+    ani.unpackFrame(f0,&frames[0]);
+    ani.unpackFrame(f1,&frames[numNodes]);
+    s0 = &frames[0];
+    s1 = &frames[numNodes];
+    } else {
+    s0 = &ani.getAniSamples()[f0*numNodes];
+    s1 = &ani.getAniSamples()[f1*numNodes];
+    }
+  for(size_t i=0; i<numNodes; ++i) {
+    const ZMath::float3& p0 = s0[i].position;
+    const ZMath::float3& p1 = s1[i].position;
+    const ZMath::float4  q  = mode==Interpolation::Slerp ? quatSlerp(s0[i].rotation,s1[i].rotation,t)
+                                                         : quatNlerp(s0[i].rotation,s1[i].rotation,t);
+    const ZMath::float3  p(p0.x+(p1.x-p0.x)*t, p0.y+(p1.y-p0.y)*t, p0.z+(p1.z-p0.z)*t);
+    quatToMatrix(q,p,local[remap.libNodes[i]]);
+    }
+  }
+
+void PoseEvaluator::evaluateRange(const PoseJob* jobs, const PoseRemap* const* remaps, size_t numJobs,
+                                  Interpolation mode) const {
+  std::vector<ZMath::Matrix>         local(bindLocal.size());
+  std::vector<zCModelAni::AniSample> frames;
+  for(size_t i=0; i<numJobs; ++i) {
+    const PoseJob& job = jobs[i];
+    if(job.animation==nullptr) {
+      hierarchy.computeNodeTransforms(nullptr,job.out);
+      continue;
+      }
+    evaluateLocal(*job.animation,*remaps[i],job.frame,job.loop,mode,local.data(),frames);
+    hierarchy.computeNodeTransforms(local.data(),job.out);
+    }
+  }
+
+void PoseEvaluator::evaluate(const PoseJob* jobs, size_t numJobs, Interpolation mode, size_t numThreads) {
+  // Resolve the mappings up front, so the workers don't touch the cache
+  std::vector<const PoseRemap*> remaps(numJobs,nullptr);
+  for(size_t i=0; i<numJobs; ++i)
+    if(jobs[i].animation!=nullptr)
+      remaps[i] = &remap(*jobs[i].animation);
+
+  parallelRanges(numJobs,numThreads,[this,jobs,&remaps,mode](size_t begin, size_t count) {
+    evaluateRange(jobs+begin,remaps.data()+begin,count,mode);
+    });
+  }
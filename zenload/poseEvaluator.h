@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "skinning.h"
+#include "zCModelAni.h"
+
+namespace ZenLoad
+{
+class zCModelMeshLib;
+
+/**
+ * @brief Maps the nodes of one animation to the nodes of a hierarchy
+ */
+struct PoseRemap {
+  uint32_t              nodeChecksum = 0;
+  uint32_t              numNodes     = 0;  // Nodes of the animation
+  std::vector<uint16_t> libNodes;          // Hierarchy node of every animation node, empty if the animation doesn't fit
+
+  bool isValid() const { return !libNodes.empty(); }
+  };
+
+/**
+ * @brief Pose of one character, sampled from one animation
+ */
+struct PoseJob {
+  const zCModelAni* animation = nullptr;  // nullptr for the bind pose
+  float             frame     = 0.f;      // Fractional frame
+  bool              loop      = true;     // Blend the last frame into the first one, otherwise clamp
+  ZMath::Matrix*    out       = nullptr;  // Model-space transform of every node of the hierarchy
+  };
+
+/**
+ * @brief Samples zCModelAni data into node transforms of a zCModelMeshLib hierarchy.
+ *
+ * Rotations are interpolated between the two closest frames, positions are lerped. Nodes the
+ * animation doesn't move keep their bind pose. Matrices use the layout of ModelNode::transformLocal.
+ */
+class PoseEvaluator {
+  public:
+    enum class Interpolation : uint8_t {
+      Nlerp,  // Normalized lerp, cheap and close enough for frames sampled at 25 fps
+      Slerp,
+      };
+
+    PoseEvaluator() = default;
+    explicit PoseEvaluator(const zCModelMeshLib& lib) { build(lib); }
+
+    void build(const zCModelMeshLib& lib);
+
+    /**
+     * @brief Builds the node mapping of an animation. Fails if the animation was made for another hierarchy
+     *        (nodeChecksum differs) or refers to nodes that don't exist.
+     */
+    bool makeRemap(const zCModelAni& ani, PoseRemap& out) const;
+
+    /**
+     * @brief makeRemap(), cached per animation. Cached entries are checked against the nodeChecksum
+     *        and node count of the animation, so reloading an animation at the same address rebuilds it.
+     */
+    const PoseRemap& remap(const zCModelAni& ani);
+
+    /**
+     * @brief Drops all cached mappings
+     */
+    void clearCache();
+
+    /**
+     * @brief Node-local transforms of one animation frame. Quantized animations are decoded on the fly.
+     * @param local One transform per node of the hierarchy
+     */
+    void evaluateLocal(const zCModelAni& ani, const PoseRemap& remap, float frame, bool loop,
+                       Interpolation mode, ZMath::Matrix* local) const;
+
+    /**
+     * @brief Evaluates the poses of many characters. Mappings are taken from the cache and built if missing.
+     * @param numThreads Threads to split the jobs over, 1 runs on the calling thread only
+     */
+    void evaluate(const PoseJob* jobs, size_t numJobs, Interpolation mode = Interpolation::Nlerp,
+                  size_t numThreads = 1);
+
+    size_t nodeCount() const { return bindLocal.size(); }
+
+    /**
+     * @brief Node hierarchy, usable to skin meshes with the evaluated poses
+     */
+    const MeshSkinning& getHierarchy() const { return hierarchy; }
+
+  private:
+    void evaluateLocal(const zCModelAni& ani, const PoseRemap& remap, float frame, bool loop,
+                       Interpolation mode, ZMath::Matrix* local, std::vector<zCModelAni::AniSample>& frames) const;
+    void evaluateRange(const PoseJob* jobs, const PoseRemap* const* remaps, size_t numJobs, Interpolation mode) const;
+
+    MeshSkinning               hierarchy;
+    std::vector<ZMath::Matrix> bindLocal;
+    uint32_t                   nodeChecksum = 0;
+
+    std::mutex                                      cacheSync;
+    std::unordered_map<const zCModelAni*,PoseRemap> cache;
+  };
+
+/**
+ * @brief Interpolates two quaternions (x,y,z,w), taking the shorter arc
+ */
+ZMath::float4 quatNlerp(const ZMath::float4& a, const ZMath::float4& b, float t);
+ZMath::float4 quatSlerp(const ZMath::float4& a, const ZMath::float4& b, float t);
+
+/**
+ * @brief Transform of a rotation and translation, in the layout of ModelNode::transformLocal
+ */
+void quatToMatrix(const ZMath::float4& q, const ZMath::float3& position, ZMath::Matrix& out);
+}  // namespace ZenLoad
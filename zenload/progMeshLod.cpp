@@ -0,0 +1,133 @@
+#include "progMeshLod.h"
+
+#include <algorithm>
+
+#include "zCProgMeshProto.h"
+
+using namespace ZenLoad;
+
+static const uint32_t REMOVED_ALWAYS = uint32_t(-1);  // Degenerate or broken to begin with
+
+void ProgMeshLod::build(const zCProgMeshProto& mesh) {
+  subMeshes.clear();
+  subMeshes.resize(mesh.getNumSubmeshes());
+  numTriangles = 0;
+  minTriangles = 0;
+
+  uint32_t vertexOffset = 0;
+  for(size_t s=0; s<mesh.getNumSubmeshes(); ++s) {
+    const zCProgMeshProto::SubMesh& src = mesh.getSubmesh(s);
+    SubMesh&                        sm  = subMeshes[s];
+    const size_t                    numWedges = src.m_WedgeList.size();
+
+    sm.vertexOffset = vertexOffset;
+    sm.triangles    = src.m_TriangleList;
+    vertexOffset   += uint32_t(numWedges);
+
+    // A wedge may only collapse into one before it, anything else would loop
+    sm.parent.resize(numWedges);
+    sm.minWedges = 0;
+    for(size_t w=0; w<numWedges; ++w) {
+      const bool collapses = w<src.m_WedgeMap.size() && src.m_WedgeMap[w]<w;
+      sm.parent[w] = collapses ? src.m_WedgeMap[w] : uint16_t(w);
+      if(!collapses)
+        sm.minWedges = uint32_t(w+1);
+      }
+
+    // Two wedges merge at the first wedge c both collapse chains share. As chains only go down,
+    // stepping the larger one finds it. Both resolve to c as long as the chain entries right before c
+    // are dropped, so the triangle is gone once the wedge count is at or below the smaller of them.
+    auto meet = [&sm](uint16_t a, uint16_t b) -> uint32_t {
+      if(a==b)
+        return REMOVED_ALWAYS;
+      uint32_t prevA = uint32_t(-1), prevB = uint32_t(-1);  // Chain entries right before the current ones
+      while(a!=b) {
+        uint16_t& hi   = a>b ? a : b;
+        uint32_t& prev = a>b ? prevA : prevB;
+        if(sm.parent[hi]==hi)
+          return 0;
+        prev = hi;
+        hi   = sm.parent[hi];
+        }
+      return std::min(prevA,prevB);
+      };
+
+    sm.removedAt.resize(sm.triangles.size());
+    for(size_t i=0; i<sm.triangles.size(); ++i) {
+      const uint16_t* w = sm.triangles[i].m_Wedges;
+      if(w[0]>=numWedges || w[1]>=numWedges || w[2]>=numWedges) {
+        sm.removedAt[i] = REMOVED_ALWAYS;
+        continue;
+        }
+      sm.removedAt[i] = std::max(meet(w[0],w[1]),std::max(meet(w[1],w[2]),meet(w[0],w[2])));
+      if(sm.removedAt[i]<sm.minWedges)
+        ++sm.minTriangles;
+      }
+    sm.sortedRemovedAt = sm.removedAt;
+    std::sort(sm.sortedRemovedAt.begin(),sm.sortedRemovedAt.end());
+
+    numTriangles += uint32_t(sm.triangles.size());
+    minTriangles += sm.minTriangles;
+    }
+  }
+
+uint32_t ProgMeshLod::wedgesForTarget(const SubMesh& sm, uint32_t target) const {
+  const uint32_t numWedges = uint32_t(sm.parent.size());
+  if(target>=sm.sortedRemovedAt.size())
+    return numWedges;
+  // Largest wedge count which keeps at most target triangles
+  const uint32_t n = sm.sortedRemovedAt[target];
+  return std::min(numWedges,std::max(n,sm.minWedges));
+  }
+
+uint16_t ProgMeshLod::resolve(const SubMesh& sm, uint16_t wedge, uint32_t numWedges) const {
+  while(wedge>=numWedges && sm.parent[wedge]!=wedge)
+    wedge = sm.parent[wedge];
+  return wedge;
+  }
+
+uint32_t ProgMeshLod::buildLevel(uint32_t targetTriangles, PackedMeshLod& out) const {
+  out.indices.clear();
+  out.subMeshes.resize(subMeshes.size());
+  out.numTriangles = 0;
+  out.indices.reserve(size_t(std::min(targetTriangles,numTriangles))*3);
+
+  // Every submesh keeps at least what it can't lose, the rest of the budget goes by share of what can be removed
+  const uint64_t budget    = targetTriangles>minTriangles ? targetTriangles-minTriangles : 0;
+  const uint64_t removable = numTriangles-minTriangles;
+
+  for(size_t s=0; s<subMeshes.size(); ++s) {
+    const SubMesh& sm = subMeshes[s];
+    uint32_t target = uint32_t(sm.triangles.size());
+    if(targetTriangles<numTriangles && removable>0)
+      target = sm.minTriangles + uint32_t(budget*(sm.triangles.size()-sm.minTriangles)/removable);
+
+    const uint32_t numWedges = wedgesForTarget(sm,target);
+    out.subMeshes[s].indexOffset = out.indices.size();
+    for(size_t i=0; i<sm.triangles.size(); ++i) {
+      if(sm.removedAt[i]>=numWedges)
+        continue;
+      const uint16_t* w = sm.triangles[i].m_Wedges;
+      const uint16_t a = resolve(sm,w[0],numWedges);
+      const uint16_t b = resolve(sm,w[1],numWedges);
+      const uint16_t c = resolve(sm,w[2],numWedges);
+      if(a==b || b==c || a==c)
+        continue;
+      out.indices.push_back(sm.vertexOffset+a);
+      out.indices.push_back(sm.vertexOffset+b);
+      out.indices.push_back(sm.vertexOffset+c);
+      }
+    out.subMeshes[s].indexSize = out.indices.size()-out.subMeshes[s].indexOffset;
+    }
+
+  out.numTriangles = uint32_t(out.indices.size()/3);
+  return out.numTriangles;
+  }
+
+void ProgMeshLod::buildLevels(const std::vector<float>& triangleFractions, std::vector<PackedMeshLod>& out) const {
+  out.resize(triangleFractions.size());
+  for(size_t i=0; i<triangleFractions.size(); ++i) {
+    const float f = std::min(1.f,std::max(0.f,triangleFractions[i]));
+    buildLevel(uint32_t(f*float(numTriangles)+0.5f),out[i]);
+    }
+  }
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+class zCProgMeshProto;
+
+/**
+ * @brief Index buffer of one level of detail. Indices refer to the vertices written by
+ *        zCProgMeshProto::packMesh, so all levels share the same vertex buffer.
+ */
+struct PackedMeshLod {
+  struct SubMesh {
+    size_t indexOffset = 0;
+    size_t indexSize   = 0;
+    };
+
+  std::vector<uint32_t> indices;
+  std::vector<SubMesh>  subMeshes;  // Same order as PackedMesh::subMeshes
+  uint32_t              numTriangles = 0;
+  };
+
+/**
+ * @brief Reduced levels of detail from the progressive mesh data of a zCProgMeshProto.
+ *
+ * The wedges of a submesh are stored in collapse order: keeping only the first n of them, every other
+ * wedge is replaced by following m_WedgeMap until it lands below n. Triangles whose wedges merge
+ * that way disappear. build() precomputes at which wedge count every triangle disappears, so picking
+ * a level for a triangle budget is a lookup and emitting it a single pass over the triangles.
+ */
+class ProgMeshLod {
+  public:
+    void build(const zCProgMeshProto& mesh);
+
+    /**
+     * @brief Builds the level with at most targetTriangles triangles, spread over the submeshes
+     *        by their share of the full mesh
+     * @return Number of triangles written
+     */
+    uint32_t buildLevel(uint32_t targetTriangles, PackedMeshLod& out) const;
+
+    /**
+     * @brief One level per entry of triangleFractions (1 = full detail, 0.25 = a quarter of the triangles)
+     */
+    void buildLevels(const std::vector<float>& triangleFractions, std::vector<PackedMeshLod>& out) const;
+
+    uint32_t fullTriangleCount() const { return numTriangles; }
+
+    /**
+     * @return Fewest triangles the mesh can be reduced to
+     */
+    uint32_t minTriangleCount() const { return minTriangles; }
+
+  private:
+    struct SubMesh {
+      uint32_t               vertexOffset = 0;  // First vertex of the submesh in packMesh's output
+      uint32_t               minWedges    = 1;  // Wedges which never collapse, always kept
+      uint32_t               minTriangles = 0;  // Triangles left with minWedges
+      std::vector<uint16_t>  parent;            // Sanitized m_WedgeMap, wedges without one point to themselves
+      std::vector<zTriangle> triangles;
+      std::vector<uint32_t>  removedAt;         // Triangle is gone when the wedge count is <= this
+      std::vector<uint32_t>  sortedRemovedAt;
+      };
+
+    uint32_t wedgesForTarget(const SubMesh& sm, uint32_t target) const;
+    uint16_t resolve(const SubMesh& sm, uint16_t wedge, uint32_t numWedges) const;
+
+    std::vector<SubMesh> subMeshes;
+    uint32_t             numTriangles = 0;
+    uint32_t             minTriangles = 0;
+  };
+}  // namespace ZenLoad
@@ -0,0 +1,122 @@
+#include "skeleton.h"
+
+#include <algorithm>
+
+#include "parallel.h"
+#include "zCModelMeshLib.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace ZenLoad;
+
+void Skeleton::build(const zCModelMeshLib& lib) {
+  const std::vector<ModelNode>& nodes = lib.getNodes();
+  const size_t n = nodes.size();
+
+  names.resize(n);
+  nodeIds.clear();
+  for(size_t i=0; i<n; ++i) {
+    names[i] = nodes[i].name;
+    nodeIds.emplace(names[i],uint32_t(i));  // The first node of a name wins, like zCModelMeshLib::findNodeIndex
+    }
+
+  auto parentOf = [&](size_t i) {
+    return (nodes[i].parentValid() && nodes[i].parentIndex<n) ? uint32_t(nodes[i].parentIndex) : uint32_t(NODE_INVALID);
+    };
+
+  // Nodes are usually stored parents first, but don't rely on it
+  order      .clear();
+  orderParent.clear();
+  position.assign(n,NODE_INVALID);
+  std::vector<uint32_t> chain;
+  for(size_t i=0; i<n; ++i) {
+    chain.clear();
+    for(uint32_t c=uint32_t(i); c!=NODE_INVALID && position[c]==NODE_INVALID && chain.size()<n; c=parentOf(c))
+      chain.push_back(c);
+    for(auto it=chain.rbegin(); it!=chain.rend(); ++it) {
+      if(position[*it]!=NODE_INVALID)
+        continue;  // Cyclic parents, already placed through the loop
+      // A parent which isn't placed yet is part of a cycle, the node is taken as a root then
+      const uint32_t p = parentOf(*it);
+      position[*it] = uint32_t(order.size());
+      order      .push_back(*it);
+      orderParent.push_back(p!=NODE_INVALID && position[p]!=NODE_INVALID ? p : uint32_t(NODE_INVALID));
+      }
+    }
+
+  bind.resize(n);
+  for(size_t i=0; i<n; ++i)
+    bind[i] = nodes[order[i]].transformLocal;
+  }
+
+uint32_t Skeleton::findNode(const std::string& name) const {
+  auto it = nodeIds.find(name);
+  return it==nodeIds.end() ? uint32_t(NODE_INVALID) : it->second;
+  }
+
+uint32_t Skeleton::parent(uint32_t node) const {
+  return orderParent[position[node]];
+  }
+
+// out = a*b, row vectors
+static inline void multiply(const ZMath::Matrix& a, const ZMath::Matrix& b, ZMath::Matrix& out) {
+#if defined(__SSE2__)
+  const __m128 b0 = _mm_loadu_ps(b.m[0]), b1 = _mm_loadu_ps(b.m[1]), b2 = _mm_loadu_ps(b.m[2]), b3 = _mm_loadu_ps(b.m[3]);
+  for(int r=0; r<4; ++r) {
+    __m128 v = _mm_mul_ps(_mm_set1_ps(a.m[r][0]),b0);
+    v = _mm_add_ps(v,_mm_mul_ps(_mm_set1_ps(a.m[r][1]),b1));
+    v = _mm_add_ps(v,_mm_mul_ps(_mm_set1_ps(a.m[r][2]),b2));
+    v = _mm_add_ps(v,_mm_mul_ps(_mm_set1_ps(a.m[r][3]),b3));
+    _mm_storeu_ps(out.m[r],v);
+    }
+#else
+  for(int r=0; r<4; ++r)
+    for(int c=0; c<4; ++c)
+      out.m[r][c] = a.m[r][0]*b.m[0][c] + a.m[r][1]*b.m[1][c] + a.m[r][2]*b.m[2][c] + a.m[r][3]*b.m[3][c];
+#endif
+  }
+
+void Skeleton::computeRange(const ZMath::Matrix* localPoses, ZMath::Matrix* out, size_t count) const {
+  const size_t n = order.size();
+  if(localPoses==nullptr) {
+    // The bind pose is the same for every instance
+    if(count==0)
+      return;
+    for(size_t i=0; i<n; ++i) {
+      const uint32_t node = order[i];
+      if(orderParent[i]==NODE_INVALID)
+        out[node] = bind[i]; else
+        multiply(bind[i],out[orderParent[i]],out[node]);
+      }
+    for(size_t inst=1; inst<count; ++inst)
+      std::copy(out,out+n,out+inst*n);
+    return;
+    }
+
+  // One instance after the other, so the transforms of an instance stay in the cache while its children need them
+  for(size_t inst=0; inst<count; ++inst) {
+    const ZMath::Matrix* local = localPoses+inst*n;
+    ZMath::Matrix*       world = out+inst*n;
+    for(size_t i=0; i<n; ++i) {
+      const uint32_t node = order[i];
+      if(orderParent[i]==NODE_INVALID)
+        world[node] = local[node]; else
+        multiply(local[node],world[orderParent[i]],world[node]);
+      }
+    }
+  }
+
+void Skeleton::computeWorldTransforms(const ZMath::Matrix* localPoses, ZMath::Matrix* out, size_t count,
+                                      size_t numThreads) const {
+  if(localPoses==nullptr) {
+    computeRange(localPoses,out,count);
+    return;
+    }
+
+  const size_t n = order.size();
+  parallelRanges(count,numThreads,[=](size_t begin, size_t num) {
+    computeRange(localPoses+begin*n,out+begin*n,num);
+    });
+  }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/mathlib.h"
+
+namespace ZenLoad
+{
+class zCModelMeshLib;
+
+/**
+ * @brief Node hierarchy of a zCModelMeshLib, compiled for evaluating many poses.
+ *
+ * Nodes keep the indices of the library, so transforms in and out are indexed like zCModelMeshLib::getNodes().
+ * Internally the nodes are visited in a fixed order with parents before their children, and the bind pose
+ * is stored in that order. Matrices use the layout of ModelNode::transformLocal.
+ */
+class Skeleton {
+  public:
+    enum : uint32_t {
+      NODE_INVALID = uint32_t(-1),
+      };
+
+    Skeleton() = default;
+    explicit Skeleton(const zCModelMeshLib& lib) { build(lib); }
+
+    void build(const zCModelMeshLib& lib);
+
+    /**
+     * @brief Concatenates node-local transforms into model space, for several instances in one pass
+     * @param localPoses count*size() transforms relative to the parent node, one block per instance.
+     *                   nullptr for the bind pose of every instance.
+     * @param out count*size() model-space transforms
+     * @param numThreads Threads to split the instances over, 1 runs on the calling thread only
+     */
+    void computeWorldTransforms(const ZMath::Matrix* localPoses, ZMath::Matrix* out, size_t count,
+                                size_t numThreads = 1) const;
+
+    /**
+     * @return Index of the node with that name, NODE_INVALID if there is none
+     */
+    uint32_t findNode(const std::string& name) const;
+
+    size_t   size() const { return order.size(); }
+    uint32_t parent(uint32_t node) const;  // NODE_INVALID for root nodes
+    const std::string& name(uint32_t node) const { return names[node]; }
+
+    /**
+     * @return Node at position i of the evaluation order
+     */
+    uint32_t orderedNode(size_t i) const { return order[i]; }
+
+    /**
+     * @return Bind-pose transform of a node, relative to its parent
+     */
+    const ZMath::Matrix& bindLocal(uint32_t node) const { return bind[position[node]]; }
+
+  private:
+    void computeRange(const ZMath::Matrix* localPoses, ZMath::Matrix* out, size_t count) const;
+
+    // Per position of the evaluation order
+    std::vector<uint32_t>      order;        // Node index
+    std::vector<uint32_t>      orderParent;  // Node index of the parent, NODE_INVALID for roots
+    std::vector<ZMath::Matrix> bind;         // Bind-pose transform relative to the parent
+
+    std::vector<uint32_t>      position;     // Per node, its position in the order
+    std::vector<std::string>   names;
+    std::unordered_map<std::string,uint32_t> nodeIds;
+  };
+}  // namespace ZenLoad
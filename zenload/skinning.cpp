@@ -0,0 +1,170 @@
+#include "skinning.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "parallel.h"
+#include "utils/alignment.h"
+#include "zCModelMeshLib.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace ZenLoad;
+
+// SkeletalVertex::BoneIndices is 8 bit, so every instance gets a full palette
+static const size_t PALETTE_SIZE = 256;
+
+// Inverse of the upper 3x3 part, identity if singular
+static void invert3x3(const ZMath::Matrix& a, float* out) {
+  const float c00 = a.m[1][1]*a.m[2][2] - a.m[1][2]*a.m[2][1];
+  const float c01 = a.m[1][2]*a.m[2][0] - a.m[1][0]*a.m[2][2];
+  const float c02 = a.m[1][0]*a.m[2][1] - a.m[1][1]*a.m[2][0];
+  const float det = a.m[0][0]*c00 + a.m[0][1]*c01 + a.m[0][2]*c02;
+  if(std::fabs(det)<1e-12f) {
+    for(int i=0; i<9; ++i)
+      out[i] = (i%4==0) ? 1.f : 0.f;
+    return;
+    }
+  const float inv = 1.f/det;
+  out[0] = c00*inv;
+  out[1] = (a.m[0][2]*a.m[2][1] - a.m[0][1]*a.m[2][2])*inv;
+  out[2] = (a.m[0][1]*a.m[1][2] - a.m[0][2]*a.m[1][1])*inv;
+  out[3] = c01*inv;
+  out[4] = (a.m[0][0]*a.m[2][2] - a.m[0][2]*a.m[2][0])*inv;
+  out[5] = (a.m[0][2]*a.m[1][0] - a.m[0][0]*a.m[1][2])*inv;
+  out[6] = c02*inv;
+  out[7] = (a.m[0][1]*a.m[2][0] - a.m[0][0]*a.m[2][1])*inv;
+  out[8] = (a.m[0][0]*a.m[1][1] - a.m[0][1]*a.m[1][0])*inv;
+  }
+
+void MeshSkinning::build(const zCModelMeshLib& lib) {
+  skeleton.build(lib);
+
+  const size_t n = skeleton.size();
+  std::vector<ZMath::Matrix> bind(n);
+  computeNodeTransforms(nullptr,bind.data());
+  invBindRotation.resize(n*9);
+  for(size_t i=0; i<n; ++i)
+    invert3x3(bind[i],&invBindRotation[i*9]);
+  }
+
+void MeshSkinning::fillPalette(const ZMath::Matrix* nodeTransforms, Bone* palette) const {
+  const size_t n = std::min(skeleton.size(),PALETTE_SIZE);
+  for(size_t i=0; i<n; ++i) {
+    const ZMath::Matrix& m   = nodeTransforms[i];
+    const float*         inv = &invBindRotation[i*9];
+    Bone&                b   = palette[i];
+    for(int r=0; r<4; ++r) {
+      b.pos[r][0] = m.m[r][0];
+      b.pos[r][1] = m.m[r][1];
+      b.pos[r][2] = m.m[r][2];
+      b.pos[r][3] = 0.f;
+      }
+    for(int r=0; r<3; ++r) {
+      for(int c=0; c<3; ++c)
+        b.normal[r][c] = inv[r*3+0]*m.m[0][c] + inv[r*3+1]*m.m[1][c] + inv[r*3+2]*m.m[2][c];
+      b.normal[r][3] = 0.f;
+      }
+    }
+  }
+
+#if defined(__SSE2__)
+static inline __m128 transformPoint(const float (&m)[4][4], const ZMath::float3& p) {
+  __m128 r = _mm_load_ps(m[3]);
+  r = _mm_add_ps(r,_mm_mul_ps(_mm_set1_ps(p.x),_mm_load_ps(m[0])));
+  r = _mm_add_ps(r,_mm_mul_ps(_mm_set1_ps(p.y),_mm_load_ps(m[1])));
+  r = _mm_add_ps(r,_mm_mul_ps(_mm_set1_ps(p.z),_mm_load_ps(m[2])));
+  return r;
+  }
+
+static inline __m128 transformVector(const float (&m)[3][4], __m128 x, __m128 y, __m128 z) {
+  __m128 r = _mm_mul_ps(x,_mm_load_ps(m[0]));
+  r = _mm_add_ps(r,_mm_mul_ps(y,_mm_load_ps(m[1])));
+  r = _mm_add_ps(r,_mm_mul_ps(z,_mm_load_ps(m[2])));
+  return r;
+  }
+
+static inline void store(__m128 v, ZMath::float3& out) {
+  alignas(16) float f[4];
+  _mm_store_ps(f,v);
+  out.x = f[0];
+  out.y = f[1];
+  out.z = f[2];
+  }
+#endif
+
+void MeshSkinning::skinRange(const SkeletalVertex* vertices, size_t numVertices,
+                             const SkinningInstance* instances, size_t numInstances) const {
+  std::vector<Bone,Utils::AlignedAllocator<Bone,16>> palette(PALETTE_SIZE);
+  for(Bone& b:palette) {
+    // Bones outside of the hierarchy stay in place
+    std::fill(&b.pos[0][0],   &b.pos[0][0]+16,   0.f);
+    std::fill(&b.normal[0][0],&b.normal[0][0]+12,0.f);
+    for(int i=0; i<3; ++i) {
+      b.pos[i][i]    = 1.f;
+      b.normal[i][i] = 1.f;
+      }
+    }
+
+  for(size_t inst=0; inst<numInstances; ++inst) {
+    const SkinningInstance& si = instances[inst];
+    fillPalette(si.nodeTransforms,palette.data());
+    const Bone* bones = palette.data();
+
+    for(size_t i=0; i<numVertices; ++i) {
+      const SkeletalVertex& v = vertices[i];
+#if defined(__SSE2__)
+      __m128 pos = _mm_setzero_ps();
+      __m128 nrm = _mm_setzero_ps();
+      const __m128 nx = _mm_set1_ps(v.Normal.x), ny = _mm_set1_ps(v.Normal.y), nz = _mm_set1_ps(v.Normal.z);
+      for(int j=0; j<4; ++j) {
+        if(v.Weights[j]==0.f)
+          continue;
+        const Bone&  b = bones[v.BoneIndices[j]];
+        const __m128 w = _mm_set1_ps(v.Weights[j]);
+        pos = _mm_add_ps(pos,_mm_mul_ps(w,transformPoint(b.pos,v.LocalPositions[j])));
+        if(si.normals!=nullptr)
+          nrm = _mm_add_ps(nrm,_mm_mul_ps(w,transformVector(b.normal,nx,ny,nz)));
+        }
+      store(pos,si.positions[i]);
+      if(si.normals!=nullptr) {
+        __m128 len = _mm_mul_ps(nrm,nrm);
+        len = _mm_add_ps(len,_mm_shuffle_ps(len,len,_MM_SHUFFLE(2,3,0,1)));
+        len = _mm_add_ps(len,_mm_shuffle_ps(len,len,_MM_SHUFFLE(1,0,3,2)));
+        const __m128 valid = _mm_cmpgt_ps(len,_mm_setzero_ps());
+        nrm = _mm_and_ps(_mm_div_ps(nrm,_mm_sqrt_ps(len)),valid);
+        store(nrm,si.normals[i]);
+        }
+#else
+      float pos[3] = {}, nrm[3] = {};
+      for(int j=0; j<4; ++j) {
+        const float w = v.Weights[j];
+        if(w==0.f)
+          continue;
+        const Bone&          b = bones[v.BoneIndices[j]];
+        const ZMath::float3& p = v.LocalPositions[j];
+        for(int c=0; c<3; ++c)
+          pos[c] += w*(p.x*b.pos[0][c] + p.y*b.pos[1][c] + p.z*b.pos[2][c] + b.pos[3][c]);
+        if(si.normals!=nullptr)
+          for(int c=0; c<3; ++c)
+            nrm[c] += w*(v.Normal.x*b.normal[0][c] + v.Normal.y*b.normal[1][c] + v.Normal.z*b.normal[2][c]);
+        }
+      si.positions[i] = ZMath::float3(pos[0],pos[1],pos[2]);
+      if(si.normals!=nullptr) {
+        const float len = std::sqrt(nrm[0]*nrm[0] + nrm[1]*nrm[1] + nrm[2]*nrm[2]);
+        const float inv = len>0.f ? 1.f/len : 0.f;
+        si.normals[i] = ZMath::float3(nrm[0]*inv,nrm[1]*inv,nrm[2]*inv);
+        }
+#endif
+      }
+    }
+  }
+
+void MeshSkinning::skin(const SkeletalVertex* vertices, size_t numVertices,
+                        const SkinningInstance* instances, size_t numInstances, size_t numThreads) const {
+  parallelRanges(numInstances,numThreads,[=](size_t begin, size_t count) {
+    skinRange(vertices,numVertices,instances+begin,count);
+    });
+  }
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "skeleton.h"
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+class zCModelMeshLib;
+
+/**
+ * @brief One posed copy of a skeletal mesh to be skinned
+ */
+struct SkinningInstance {
+  const ZMath::Matrix* nodeTransforms = nullptr;  // Model-space transform of every node, see MeshSkinning::computeNodeTransforms
+  ZMath::float3*       positions      = nullptr;  // Output, one per vertex
+  ZMath::float3*       normals        = nullptr;  // Output, may be nullptr
+  };
+
+/**
+ * @brief CPU skinning of SkeletalVertex data against the node hierarchy of a zCModelMeshLib.
+ *
+ * Matrices use the layout of ModelNode::transformLocal (row vectors, translation in _41.._43).
+ * Bone indices of the vertices are node indices of the library. Positions are blended from the
+ * node-local positions, normals are taken from bind space to the pose and renormalized.
+ */
+class MeshSkinning {
+  public:
+    MeshSkinning() = default;
+    explicit MeshSkinning(const zCModelMeshLib& lib) { build(lib); }
+
+    /**
+     * @brief Takes the hierarchy and the bind pose of the library
+     */
+    void build(const zCModelMeshLib& lib);
+
+    /**
+     * @brief Concatenates node-local transforms into model space
+     * @param local One transform per node, relative to its parent. nullptr for the bind pose.
+     * @param out One transform per node
+     */
+    void computeNodeTransforms(const ZMath::Matrix* local, ZMath::Matrix* out) const {
+      skeleton.computeWorldTransforms(local,out,1);
+      }
+
+    /**
+     * @brief Skins the vertices once per instance
+     * @param numThreads Threads to split the instances over, 1 runs on the calling thread only
+     */
+    void skin(const SkeletalVertex* vertices, size_t numVertices,
+              const SkinningInstance* instances, size_t numInstances, size_t numThreads = 1) const;
+
+    void skin(const PackedSkeletalMesh& mesh, const SkinningInstance* instances, size_t numInstances,
+              size_t numThreads = 1) const {
+      skin(mesh.vertices.data(), mesh.vertices.size(), instances, numInstances, numThreads);
+      }
+
+    size_t          nodeCount()   const { return skeleton.size(); }
+    const Skeleton& getSkeleton() const { return skeleton; }
+
+  private:
+    // Per-bone matrices of one instance, rows padded to four floats
+    struct alignas(16) Bone {
+      float pos[4][4];     // Node transform
+      float normal[3][4];  // Inverse bind rotation, then node rotation
+      };
+
+    void fillPalette(const ZMath::Matrix* nodeTransforms, Bone* palette) const;
+    void skinRange(const SkeletalVertex* vertices, size_t numVertices,
+                   const SkinningInstance* instances, size_t numInstances) const;
+
+    Skeleton                   skeleton;
+    std::vector<float>         invBindRotation;  // 3x3 per node
+  };
+}  // namespace ZenLoad
@@ -0,0 +1,194 @@
+#include "staticLightSampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "zCMesh.h"
+
+using namespace ZenLoad;
+
+const uint32_t StaticLightSampler::NO_TRIANGLE;
+
+static const uint32_t MAX_CELLS_PER_AXIS = 4096;
+static const float    TRIS_PER_CELL      = 4.f;
+
+void StaticLightSampler::build(const zCMesh& mesh, float cellSize) {
+  cellStart.clear();
+  cells.clear();
+  cellsX  = cellsZ = 0;
+  numTris = 0;
+
+  auto& vertices = mesh.getVertices();
+  auto& indices  = mesh.getIndices();
+  auto& features = mesh.getFeatures();
+  auto& featIds  = mesh.getFeatureIndices();
+
+  float bmin[2] = { 1e30f, 1e30f};
+  float bmax[2] = {-1e30f,-1e30f};
+  std::vector<Tri>   tris;
+  std::vector<float> rects;  // Min x, max x, min z, max z of every kept triangle
+  tris.reserve(indices.size()/3);
+  for(size_t i=0; i+2<indices.size(); i+=3) {
+    const ZMath::float3& a = vertices[indices[i+0]];
+    const ZMath::float3& b = vertices[indices[i+1]];
+    const ZMath::float3& c = vertices[indices[i+2]];
+
+    const float e1x = b.x-a.x, e1z = b.z-a.z;
+    const float e2x = c.x-a.x, e2z = c.z-a.z;
+    const float det = e1x*e2z - e2x*e1z;
+    const float len = std::sqrt((e1x*e1x+e1z*e1z)*(e2x*e2x+e2z*e2z));
+    if(std::fabs(det)<=len*1e-4f)
+      continue;  // Wall or degenerate, nothing can stand on it
+
+    Tri t;
+    t.x0     = a.x;
+    t.z0     = a.z;
+    t.inv[0] =  e2z/det;
+    t.inv[1] = -e2x/det;
+    t.inv[2] = -e1z/det;
+    t.inv[3] =  e1x/det;
+    t.y0     = a.y;
+    t.dy1    = b.y-a.y;
+    t.dy2    = c.y-a.y;
+    for(int v=0; v<3; ++v)
+      t.color[v] = i+v<featIds.size() && featIds[i+v]<features.size() ? features[featIds[i+v]].lightStat : 0xFFFFFFFF;
+    t.id = uint32_t(i/3);
+    tris.push_back(t);
+
+    const float rc[4] = {std::min(a.x,std::min(b.x,c.x)),std::max(a.x,std::max(b.x,c.x)),
+                         std::min(a.z,std::min(b.z,c.z)),std::max(a.z,std::max(b.z,c.z))};
+    rects.insert(rects.end(),rc,rc+4);
+    bmin[0] = std::min(bmin[0],rc[0]);
+    bmax[0] = std::max(bmax[0],rc[1]);
+    bmin[1] = std::min(bmin[1],rc[2]);
+    bmax[1] = std::max(bmax[1],rc[3]);
+    }
+
+  if(tris.empty())
+    return;
+
+  if(cellSize<=0.f) {
+    // Aim for a handful of triangles per cell
+    const float area = std::max(1.f,(bmax[0]-bmin[0])*(bmax[1]-bmin[1]));
+    cellSize = std::sqrt(area*TRIS_PER_CELL/float(tris.size()));
+    }
+  cellSize = std::max(cellSize,(bmax[0]-bmin[0])/MAX_CELLS_PER_AXIS);
+  cellSize = std::max(cellSize,(bmax[1]-bmin[1])/MAX_CELLS_PER_AXIS);
+  origin      = ZMath::float3(bmin[0],0,bmin[1]);
+  invCellSize = 1.f/cellSize;
+  cellsX      = std::min(MAX_CELLS_PER_AXIS,uint32_t((bmax[0]-bmin[0])*invCellSize)+1);
+  cellsZ      = std::min(MAX_CELLS_PER_AXIS,uint32_t((bmax[1]-bmin[1])*invCellSize)+1);
+
+  // Cell range covered by each triangle's xz-bbox
+  auto range = [&](size_t tri, uint32_t r[4]) {
+    auto clampCell = [](float f, uint32_t n) {
+      return uint32_t(std::min(float(n-1),std::max(0.f,f)));
+      };
+    const float* bb = &rects[tri*4];
+    r[0] = clampCell((bb[0]-origin.x)*invCellSize,cellsX);
+    r[1] = clampCell((bb[1]-origin.x)*invCellSize,cellsX);
+    r[2] = clampCell((bb[2]-origin.z)*invCellSize,cellsZ);
+    r[3] = clampCell((bb[3]-origin.z)*invCellSize,cellsZ);
+    };
+
+  cellStart.assign(size_t(cellsX)*cellsZ+1,0);
+  for(size_t i=0; i<tris.size(); ++i) {
+    uint32_t r[4];
+    range(i,r);
+    for(uint32_t z=r[2]; z<=r[3]; ++z)
+      for(uint32_t x=r[0]; x<=r[1]; ++x)
+        cellStart[z*cellsX+x+1]++;
+    }
+  for(size_t i=1; i<cellStart.size(); ++i)
+    cellStart[i] += cellStart[i-1];
+
+  // Triangles are copied into every cell they touch, so a query reads one contiguous range
+  cells.resize(cellStart.back());
+  std::vector<uint32_t> fill(cellStart.begin(),cellStart.end()-1);
+  for(size_t i=0; i<tris.size(); ++i) {
+    uint32_t r[4];
+    range(i,r);
+    for(uint32_t z=r[2]; z<=r[3]; ++z)
+      for(uint32_t x=r[0]; x<=r[1]; ++x)
+        cells[fill[z*cellsX+x]++] = tris[i];
+    }
+  numTris = tris.size();
+  }
+
+bool StaticLightSampler::cellOf(float x, float z, uint32_t& cell) const {
+  const float fx = (x-origin.x)*invCellSize;
+  const float fz = (z-origin.z)*invCellSize;
+  if(!(fx>=0.f && fz>=0.f && fx<float(cellsX) && fz<float(cellsZ)))
+    return false;
+  cell = uint32_t(fz)*cellsX+uint32_t(fx);
+  return true;
+  }
+
+const StaticLightSampler::Tri* StaticLightSampler::testCell(uint32_t cell, const ZMath::float3& pos, float tolerance, Hit& hit) const {
+  const float eps   = 1e-5f;
+  const Tri*  found = nullptr;
+  for(uint32_t i=cellStart[cell], end=cellStart[cell+1]; i<end; ++i) {
+    const Tri&  t  = cells[i];
+    const float dx = pos.x-t.x0;
+    const float dz = pos.z-t.z0;
+    const float u  = t.inv[0]*dx + t.inv[1]*dz;
+    const float v  = t.inv[2]*dx + t.inv[3]*dz;
+    if(u<-eps || v<-eps || u+v>1.f+eps)
+      continue;
+    const float h = t.y0 + u*t.dy1 + v*t.dy2;
+    if(h>pos.y+tolerance || (found!=nullptr && h<=hit.height))
+      continue;
+    hit.triangle = t.id;
+    hit.height   = h;
+    hit.u        = u;
+    hit.v        = v;
+    found        = &t;
+    }
+  return found;
+  }
+
+bool StaticLightSampler::findBelow(const ZMath::float3& pos, Hit& hit, float tolerance) const {
+  uint32_t cell;
+  hit = Hit();
+  return cellOf(pos.x,pos.z,cell) && testCell(cell,pos,tolerance,hit)!=nullptr;
+  }
+
+ZMath::float4 StaticLightSampler::shade(const Tri& t, const Hit& hit) {
+  const float u = std::min(1.f,std::max(0.f,hit.u));
+  const float v = std::min(1.f-u,std::max(0.f,hit.v));
+  const float w[3] = {1.f-u-v,u,v};
+
+  ZMath::float4 ret(0,0,0,0);
+  for(int i=0; i<3; ++i) {
+    ZMath::float4 c;
+    c.fromABGR8(t.color[i]);
+    ret.x += w[i]*c.x;
+    ret.y += w[i]*c.y;
+    ret.z += w[i]*c.z;
+    ret.w += w[i]*c.w;
+    }
+  return ret;
+  }
+
+bool StaticLightSampler::sample(const ZMath::float3& pos, ZMath::float4& out) const {
+  uint32_t   cell;
+  Hit        hit;
+  const Tri* t = cellOf(pos.x,pos.z,cell) ? testCell(cell,pos,1.f,hit) : nullptr;
+  out = t!=nullptr ? shade(*t,hit) : fallback;
+  return t!=nullptr;
+  }
+
+size_t StaticLightSampler::sample(const ZMath::float3* positions, ZMath::float4* out, size_t count, uint8_t* found) const {
+  size_t ret = 0;
+  for(size_t i=0; i<count; ++i) {
+    uint32_t   cell;
+    Hit        hit;
+    const Tri* t = cellOf(positions[i].x,positions[i].z,cell) ? testCell(cell,positions[i],1.f,hit) : nullptr;
+    out[i] = t!=nullptr ? shade(*t,hit) : fallback;
+    if(found!=nullptr)
+      found[i] = t!=nullptr ? 1 : 0;
+    if(t!=nullptr)
+      ++ret;
+    }
+  return ret;
+  }
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+class zCMesh;
+
+/**
+ * @brief Looks up the static light of the world polygon below a position, for shading dynamic objects.
+ *        Triangles are binned into a uniform grid over the xz-plane, each one storing its projected
+ *        barycentric setup, so a query is a cell lookup and a few 2D point-in-triangle tests.
+ */
+class StaticLightSampler {
+  public:
+    static const uint32_t NO_TRIANGLE = uint32_t(-1);
+
+    struct Hit {
+      uint32_t triangle = NO_TRIANGLE;  // Index into zCMesh::getIndices()/3
+      float    height   = 0.f;          // World y of the polygon below the position
+      float    u = 0.f, v = 0.f;        // Barycentrics of the second and third vertex
+      };
+
+    /**
+     * @param mesh Worldmesh, polygons facing (nearly) sideways are left out
+     * @param cellSize Size of a grid cell along x and z in world units, 0 picks one from the triangle density
+     */
+    void build(const zCMesh& mesh, float cellSize = 0.f);
+
+    /**
+     * @brief Finds the highest polygon at or below pos.y (plus tolerance)
+     * @return False if there is none
+     */
+    bool findBelow(const ZMath::float3& pos, Hit& hit, float tolerance = 1.f) const;
+
+    /**
+     * @brief Interpolated static light at the polygon below the given position
+     * @return False if there is no polygon below, out is set to the fallback then
+     */
+    bool sample(const ZMath::float3& pos, ZMath::float4& out) const;
+
+    /**
+     * @brief Batched sample(). Fastest when neighbouring positions come after each other, as they share cells.
+     * @param found Optional, set to 1 for positions which had a polygon below
+     * @return Number of positions with a polygon below
+     */
+    size_t sample(const ZMath::float3* positions, ZMath::float4* out, size_t count, uint8_t* found = nullptr) const;
+
+    void setFallback(const ZMath::float4& c) { fallback = c; }
+
+    size_t triangleCount() const { return numTris; }
+
+  private:
+    struct Tri {
+      float    x0, z0;         // First vertex on the xz-plane
+      float    inv[4];         // Inverse of the 2x2 edge matrix, maps (dx,dz) to (u,v)
+      float    y0, dy1, dy2;   // Height at the first vertex and along both edges
+      uint32_t color[3];
+      uint32_t id;             // Index into zCMesh::getIndices()/3
+      };
+
+    bool       cellOf(float x, float z, uint32_t& cell) const;
+    const Tri* testCell(uint32_t cell, const ZMath::float3& pos, float tolerance, Hit& hit) const;
+
+    static ZMath::float4 shade(const Tri& t, const Hit& hit);
+
+    ZMath::float3         origin;
+    float                 invCellSize = 0.f;
+    uint32_t              cellsX = 0, cellsZ = 0;
+    std::vector<uint32_t> cellStart;  // cellsX*cellsZ+1 offsets into cells
+    std::vector<Tri>      cells;      // Triangles of every cell, back to back
+    size_t                numTris = 0;
+    ZMath::float4         fallback = ZMath::float4(1,1,1,1);
+  };
+}  // namespace ZenLoad
@@ -0,0 +1,617 @@
+#include "triangleBvh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "zCMesh.h"
+
+using namespace ZenLoad;
+
+const uint32_t BvhHit::NO_HIT;
+
+static const int      NUM_BINS       = 12;
+static const uint32_t MIN_LEAF_SIZE  = 4;
+static const uint32_t MAX_LEAF_SIZE  = 16;
+static const uint32_t MAX_SAH_DEPTH  = 64;    // Deeper nodes fall back to median splits, keeps the stack bounded
+static const uint32_t PARALLEL_SPLIT = 4096;  // Smallest subtree worth a thread of its own
+static const float    TRAVERSE_COST  = 0.5f;  // Relative to testing one pack
+
+static float area(const float bmin[3], const float bmax[3]) {
+  const float dx = bmax[0]-bmin[0], dy = bmax[1]-bmin[1], dz = bmax[2]-bmin[2];
+  return dx*dy + dy*dz + dz*dx;
+  }
+
+static float packCost(uint32_t count) {
+  return float((count+3)/4);
+  }
+
+namespace ZenLoad
+{
+struct BvhBuilder {
+  using Node    = TriangleBvh::Node;
+  using TriPack = TriangleBvh::TriPack;
+
+  struct Prim {
+    float bmin[3];
+    float bmax[3];
+    float c[3];
+    };
+
+  struct Bin {
+    float    bmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX};
+    float    bmax[3] = {-FLT_MAX,-FLT_MAX,-FLT_MAX};
+    uint32_t count   = 0;
+
+    void grow(const float mn[3], const float mx[3]) {
+      for(int i=0; i<3; ++i) {
+        bmin[i] = std::min(bmin[i],mn[i]);
+        bmax[i] = std::max(bmax[i],mx[i]);
+        }
+      }
+    };
+
+  const ZMath::float3*  positions;
+  const uint32_t*       indices;
+  const int16_t*        materials;
+  std::vector<Prim>     prims;
+  std::vector<uint32_t> order;
+  std::vector<Node>     nodes;
+  std::atomic<uint32_t> nodeCount{1};
+  std::atomic<int>      spareThreads{0};
+
+  void buildNode(uint32_t id, uint32_t begin, uint32_t end, uint32_t depth) {
+    Node&    n     = nodes[id];
+    uint32_t count = end-begin;
+
+    Bin all, centers;
+    for(uint32_t i=begin; i<end; ++i) {
+      const Prim& p = prims[order[i]];
+      all.grow(p.bmin,p.bmax);
+      centers.grow(p.c,p.c);
+      }
+    std::copy(all.bmin,all.bmin+3,n.bmin);
+    std::copy(all.bmax,all.bmax+3,n.bmax);
+
+    if(count<=MIN_LEAF_SIZE) {
+      makeLeaf(n,begin,count);
+      return;
+      }
+
+    int   bestAxis  = -1, bestBin = 0;
+    float bestCost  = FLT_MAX;
+    if(depth<MAX_SAH_DEPTH) {
+      for(int axis=0; axis<3; ++axis) {
+        const float ext = centers.bmax[axis]-centers.bmin[axis];
+        if(!(ext>0.f))
+          continue;
+
+        Bin bins[NUM_BINS];
+        const float scale = float(NUM_BINS)/ext;
+        for(uint32_t i=begin; i<end; ++i) {
+          const Prim& p = prims[order[i]];
+          const int   b = std::min(NUM_BINS-1,int((p.c[axis]-centers.bmin[axis])*scale));
+          bins[b].grow(p.bmin,p.bmax);
+          bins[b].count++;
+          }
+
+        // Sweep from the right to get the cost of every right side, then from the left
+        float rightCost[NUM_BINS];
+        Bin   acc;
+        for(int b=NUM_BINS-1; b>0; --b) {
+          acc.grow(bins[b].bmin,bins[b].bmax);
+          acc.count += bins[b].count;
+          rightCost[b] = acc.count>0 ? area(acc.bmin,acc.bmax)*packCost(acc.count) : 0.f;
+          }
+        acc = Bin();
+        for(int b=0; b<NUM_BINS-1; ++b) {
+          acc.grow(bins[b].bmin,bins[b].bmax);
+          acc.count += bins[b].count;
+          if(acc.count==0 || acc.count==count)
+            continue;
+          const float cost = area(acc.bmin,acc.bmax)*packCost(acc.count) + rightCost[b+1];
+          if(cost<bestCost) {
+            bestCost = cost;
+            bestAxis = axis;
+            bestBin  = b;
+            }
+          }
+        }
+
+      const float nodeArea = area(n.bmin,n.bmax);
+      if(count<=MAX_LEAF_SIZE && (bestAxis<0 || bestCost+TRAVERSE_COST*nodeArea>=packCost(count)*nodeArea)) {
+        makeLeaf(n,begin,count);
+        return;
+        }
+      }
+
+    uint32_t mid = begin;
+    if(bestAxis>=0) {
+      const float ext   = centers.bmax[bestAxis]-centers.bmin[bestAxis];
+      const float scale = float(NUM_BINS)/ext;
+      const float cmin  = centers.bmin[bestAxis];
+      auto it = std::partition(order.begin()+begin,order.begin()+end,[&](uint32_t i){
+        return std::min(NUM_BINS-1,int((prims[i].c[bestAxis]-cmin)*scale))<=bestBin;
+        });
+      mid = uint32_t(it-order.begin());
+      }
+    if(mid==begin || mid==end) {
+      // No usable split plane (or too deep): split at the median of the longest centroid axis
+      int axis = 0;
+      for(int i=1; i<3; ++i)
+        if(centers.bmax[i]-centers.bmin[i]>centers.bmax[axis]-centers.bmin[axis])
+          axis = i;
+      mid = begin+count/2;
+      std::nth_element(order.begin()+begin,order.begin()+mid,order.begin()+end,[&](uint32_t a, uint32_t b){
+        return prims[a].c[axis]<prims[b].c[axis];
+        });
+      }
+
+    const uint32_t left = nodeCount.fetch_add(2);
+    n.start = left;
+    n.packs = 0;
+
+    if(count>=PARALLEL_SPLIT && spareThreads.fetch_sub(1)>0) {
+      std::thread th([this,left,begin,mid,depth](){ buildNode(left,begin,mid,depth+1); });
+      buildNode(left+1,mid,end,depth+1);
+      th.join();
+      spareThreads.fetch_add(1);
+      } else {
+      if(count>=PARALLEL_SPLIT)
+        spareThreads.fetch_add(1);
+      buildNode(left,  begin,mid,depth+1);
+      buildNode(left+1,mid,  end,depth+1);
+      }
+    }
+
+  // Leaves keep their triangle range until packs are written
+  void makeLeaf(Node& n, uint32_t begin, uint32_t count) {
+    n.start = begin;
+    n.packs = count;
+    }
+
+  void build(TriangleBvh& bvh, size_t numTris, size_t numThreads) {
+    bvh.nodes.clear();
+    bvh.packs.clear();
+    bvh.numTriangles = numTris;
+    if(numTris==0)
+      return;
+
+    prims.resize(numTris);
+    order.resize(numTris);
+    for(size_t t=0; t<numTris; ++t) {
+      Prim& p = prims[t];
+      for(int i=0; i<3; ++i) {
+        p.bmin[i] =  FLT_MAX;
+        p.bmax[i] = -FLT_MAX;
+        }
+      for(int k=0; k<3; ++k) {
+        const ZMath::float3& v = positions[indices[t*3+k]];
+        for(int i=0; i<3; ++i) {
+          p.bmin[i] = std::min(p.bmin[i],v.v[i]);
+          p.bmax[i] = std::max(p.bmax[i],v.v[i]);
+          }
+        }
+      for(int i=0; i<3; ++i)
+        p.c[i] = (p.bmin[i]+p.bmax[i])*0.5f;
+      order[t] = uint32_t(t);
+      }
+
+    nodes.resize(2*numTris-1);
+    spareThreads = int(numThreads>1 ? numThreads-1 : 0);
+    buildNode(0,0,uint32_t(numTris),0);
+    nodes.resize(nodeCount);
+
+    for(Node& n:nodes) {
+      if(n.packs==0)
+        continue;
+      const uint32_t begin = n.start, count = n.packs;
+      n.start = uint32_t(bvh.packs.size());
+      n.packs = (count+3)/4;
+      for(uint32_t i=0; i<count; i+=4)
+        bvh.packs.push_back(makePack(&order[begin+i],std::min(4u,count-i)));
+      }
+    bvh.nodes = std::move(nodes);
+    }
+
+  TriPack makePack(const uint32_t* tris, uint32_t count) const {
+    TriPack p = {};
+    for(uint32_t j=0; j<4; ++j) {
+      if(j>=count) {
+        p.id[j]       = BvhHit::NO_HIT;
+        p.material[j] = -1;
+        continue;
+        }
+      const uint32_t       t  = tris[j];
+      const ZMath::float3& v0 = positions[indices[t*3+0]];
+      const ZMath::float3& v1 = positions[indices[t*3+1]];
+      const ZMath::float3& v2 = positions[indices[t*3+2]];
+      for(int i=0; i<3; ++i) {
+        p.v0[i][j] = v0.v[i];
+        p.e1[i][j] = v1.v[i]-v0.v[i];
+        p.e2[i][j] = v2.v[i]-v0.v[i];
+        }
+      p.id[j]       = t;
+      p.material[j] = materials!=nullptr ? materials[t] : int16_t(-1);
+      }
+    return p;
+    }
+  };
+}
+
+void TriangleBvh::build(const ZMath::float3* positions, const uint32_t* indices, size_t numTris,
+                        const int16_t* materials, size_t numThreads) {
+  BvhBuilder b;
+  b.positions = positions;
+  b.indices   = indices;
+  b.materials = materials;
+  b.build(*this,numTris,numThreads);
+  }
+
+void TriangleBvh::build(const zCMesh& mesh, size_t numThreads) {
+  // Materials are int16 in the mesh already, but out of range ones get normalized to -1
+  std::vector<int16_t> mat(mesh.getTriangleMaterialIndices());
+  for(auto& m:mat)
+    if(m<0 || size_t(m)>=mesh.getMaterials().size())
+      m = -1;
+  mat.resize(mesh.getIndices().size()/3,-1);
+  build(mesh.getVertices().data(),mesh.getIndices().data(),mesh.getIndices().size()/3,mat.data(),numThreads);
+  }
+
+void TriangleBvh::build(const PackedMesh& mesh, size_t numThreads) {
+  std::vector<ZMath::float3> pos(mesh.vertices.size());
+  for(size_t i=0; i<pos.size(); ++i)
+    pos[i] = mesh.vertices[i].Position;
+
+  std::vector<int16_t> mat(mesh.indices.size()/3,-1);
+  for(size_t s=0; s<mesh.subMeshes.size(); ++s) {
+    auto& sm = mesh.subMeshes[s];
+    for(size_t i=sm.indexOffset/3; i<(sm.indexOffset+sm.indexSize)/3 && i<mat.size(); ++i)
+      mat[i] = int16_t(s);
+    }
+  build(pos.data(),mesh.indices.data(),mesh.indices.size()/3,mat.data(),numThreads);
+  }
+
+void TriangleBvh::getBoundingBox(ZMath::float3& min, ZMath::float3& max) const {
+  if(nodes.empty())
+    return;
+  min = ZMath::float3(nodes[0].bmin[0],nodes[0].bmin[1],nodes[0].bmin[2]);
+  max = ZMath::float3(nodes[0].bmax[0],nodes[0].bmax[1],nodes[0].bmax[2]);
+  }
+
+namespace
+{
+struct RayInfo {
+  float o[3];
+  float d[3];
+  float inv[3];
+  };
+
+RayInfo makeRayInfo(const BvhRay& r) {
+  RayInfo ri;
+  for(int i=0; i<3; ++i) {
+    ri.o[i]   = r.origin.v[i];
+    ri.d[i]   = r.direction.v[i];
+    ri.inv[i] = 1.f/r.direction.v[i];
+    }
+  return ri;
+  }
+}
+
+// Entry distance of the ray into the node box grown by expand, FLT_MAX if it misses before tMax.
+// NaNs from 0*inf (ray in a slab plane) are dropped by the min/max argument order.
+template<class NodeT>
+static float boxEntry(const NodeT& n, const RayInfo& r, float expand, float tMax) {
+  float tmin = 0.f, tmax = tMax;
+  for(int i=0; i<3; ++i) {
+    float t0 = (n.bmin[i]-expand-r.o[i])*r.inv[i];
+    float t1 = (n.bmax[i]+expand-r.o[i])*r.inv[i];
+    if(t0>t1)
+      std::swap(t0,t1);
+    tmin = std::max(tmin,t0);
+    tmax = std::min(tmax,t1);
+    }
+  return tmin<=tmax ? tmin : FLT_MAX;
+  }
+
+// Closest-first traversal. onLeaf(node) tests the leaf and returns true to stop.
+template<class NodeT, class F>
+static void traverse(const std::vector<NodeT>& nodes, const RayInfo& r, float expand, const float& tBest, F onLeaf) {
+  if(nodes.empty() || boxEntry(nodes[0],r,expand,tBest)==FLT_MAX)
+    return;
+
+  // Entry distances are kept alongside, so nodes behind a hit found meanwhile get skipped
+  uint32_t stack[128];
+  float    entry[128];
+  int      sp = 0;
+  stack[sp] = 0;
+  entry[sp] = 0.f;
+  ++sp;
+  while(sp>0) {
+    --sp;
+    if(entry[sp]>=tBest)
+      continue;
+    const NodeT& n = nodes[stack[sp]];
+    if(n.packs>0) {
+      if(onLeaf(n))
+        return;
+      continue;
+      }
+    const float    tl   = boxEntry(nodes[n.start  ],r,expand,tBest);
+    const float    tr   = boxEntry(nodes[n.start+1],r,expand,tBest);
+    const uint32_t near = tl<=tr ? n.start : n.start+1;
+    const float    tn   = std::min(tl,tr), tf = std::max(tl,tr);
+    if(tf!=FLT_MAX) {
+      stack[sp] = near==n.start ? n.start+1 : n.start;
+      entry[sp] = tf;
+      ++sp;
+      }
+    if(tn!=FLT_MAX) {
+      stack[sp] = near;
+      entry[sp] = tn;
+      ++sp;
+      }
+    }
+  }
+
+// Moeller-Trumbore against four triangles. Returns the lane with the closest hit in [0,tBest), or -1.
+template<class Pack>
+static int intersectPack(const Pack& p, const RayInfo& r, float tBest, float& tOut, float& uOut, float& vOut) {
+  float t[4], u[4], v[4];
+  int   mask;
+#if defined(__SSE2__)
+  const __m128 dx = _mm_set1_ps(r.d[0]), dy = _mm_set1_ps(r.d[1]), dz = _mm_set1_ps(r.d[2]);
+  const __m128 e1x = _mm_loadu_ps(p.e1[0]), e1y = _mm_loadu_ps(p.e1[1]), e1z = _mm_loadu_ps(p.e1[2]);
+  const __m128 e2x = _mm_loadu_ps(p.e2[0]), e2y = _mm_loadu_ps(p.e2[1]), e2z = _mm_loadu_ps(p.e2[2]);
+
+  const __m128 px  = _mm_sub_ps(_mm_mul_ps(dy,e2z),_mm_mul_ps(dz,e2y));
+  const __m128 py  = _mm_sub_ps(_mm_mul_ps(dz,e2x),_mm_mul_ps(dx,e2z));
+  const __m128 pz  = _mm_sub_ps(_mm_mul_ps(dx,e2y),_mm_mul_ps(dy,e2x));
+  const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x,px),_mm_mul_ps(e1y,py)),_mm_mul_ps(e1z,pz));
+  const __m128 inv = _mm_div_ps(_mm_set1_ps(1.f),det);
+
+  const __m128 tx = _mm_sub_ps(_mm_set1_ps(r.o[0]),_mm_loadu_ps(p.v0[0]));
+  const __m128 ty = _mm_sub_ps(_mm_set1_ps(r.o[1]),_mm_loadu_ps(p.v0[1]));
+  const __m128 tz = _mm_sub_ps(_mm_set1_ps(r.o[2]),_mm_loadu_ps(p.v0[2]));
+  const __m128 uu = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx,px),_mm_mul_ps(ty,py)),_mm_mul_ps(tz,pz)),inv);
+
+  const __m128 qx = _mm_sub_ps(_mm_mul_ps(ty,e1z),_mm_mul_ps(tz,e1y));
+  const __m128 qy = _mm_sub_ps(_mm_mul_ps(tz,e1x),_mm_mul_ps(tx,e1z));
+  const __m128 qz = _mm_sub_ps(_mm_mul_ps(tx,e1y),_mm_mul_ps(ty,e1x));
+  const __m128 vv = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx,qx),_mm_mul_ps(dy,qy)),_mm_mul_ps(dz,qz)),inv);
+  const __m128 tt = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x,qx),_mm_mul_ps(e2y,qy)),_mm_mul_ps(e2z,qz)),inv);
+
+  const __m128 zero = _mm_setzero_ps();
+  __m128 m = _mm_cmpneq_ps(det,zero);
+  m = _mm_and_ps(m,_mm_cmpge_ps(uu,zero));
+  m = _mm_and_ps(m,_mm_cmpge_ps(vv,zero));
+  m = _mm_and_ps(m,_mm_cmple_ps(_mm_add_ps(uu,vv),_mm_set1_ps(1.f)));
+  m = _mm_and_ps(m,_mm_cmpge_ps(tt,zero));
+  m = _mm_and_ps(m,_mm_cmplt_ps(tt,_mm_set1_ps(tBest)));
+  mask = _mm_movemask_ps(m);
+  if(mask==0)
+    return -1;
+  _mm_storeu_ps(t,tt);
+  _mm_storeu_ps(u,uu);
+  _mm_storeu_ps(v,vv);
+#else
+  mask = 0;
+  for(int j=0; j<4; ++j) {
+    const float px  = r.d[1]*p.e2[2][j] - r.d[2]*p.e2[1][j];
+    const float py  = r.d[2]*p.e2[0][j] - r.d[0]*p.e2[2][j];
+    const float pz  = r.d[0]*p.e2[1][j] - r.d[1]*p.e2[0][j];
+    const float det = p.e1[0][j]*px + p.e1[1][j]*py + p.e1[2][j]*pz;
+    if(det==0.f)
+      continue;
+    const float inv = 1.f/det;
+    const float tx  = r.o[0]-p.v0[0][j], ty = r.o[1]-p.v0[1][j], tz = r.o[2]-p.v0[2][j];
+    u[j] = (tx*px + ty*py + tz*pz)*inv;
+    const float qx  = ty*p.e1[2][j] - tz*p.e1[1][j];
+    const float qy  = tz*p.e1[0][j] - tx*p.e1[2][j];
+    const float qz  = tx*p.e1[1][j] - ty*p.e1[0][j];
+    v[j] = (r.d[0]*qx + r.d[1]*qy + r.d[2]*qz)*inv;
+    t[j] = (p.e2[0][j]*qx + p.e2[1][j]*qy + p.e2[2][j]*qz)*inv;
+    if(u[j]>=0.f && v[j]>=0.f && u[j]+v[j]<=1.f && t[j]>=0.f && t[j]<tBest)
+      mask |= 1<<j;
+    }
+  if(mask==0)
+    return -1;
+#endif
+  int best = -1;
+  for(int j=0; j<4; ++j)
+    if((mask & (1<<j)) && (best<0 || t[j]<t[best]))
+      best = j;
+  tOut = t[best];
+  uOut = u[best];
+  vOut = v[best];
+  return best;
+  }
+
+void TriangleBvh::intersect(const BvhRay* rays, BvhHit* hits, size_t count) const {
+  for(size_t i=0; i<count; ++i) {
+    const RayInfo r    = makeRayInfo(rays[i]);
+    BvhHit&       hit  = hits[i];
+    float         tBest = rays[i].tMax;
+    hit = BvhHit();
+    traverse(nodes,r,0.f,tBest,[&](const Node& n){
+      for(uint32_t k=0; k<n.packs; ++k) {
+        const TriPack& p = packs[n.start+k];
+        float t, u, v;
+        const int lane = intersectPack(p,r,tBest,t,u,v);
+        if(lane<0)
+          continue;
+        tBest        = t;
+        hit.t        = t;
+        hit.u        = u;
+        hit.v        = v;
+        hit.triangle = p.id[lane];
+        hit.material = p.material[lane];
+        }
+      return false;
+      });
+    }
+  }
+
+void TriangleBvh::intersectSegments(const ZMath::float3* from, const ZMath::float3* to, BvhHit* hits, size_t count) const {
+  for(size_t i=0; i<count; ++i) {
+    BvhRay r;
+    r.origin    = from[i];
+    r.direction = ZMath::float3(to[i].x-from[i].x,to[i].y-from[i].y,to[i].z-from[i].z);
+    r.tMax      = 1.f;
+    intersect(&r,&hits[i],1);
+    }
+  }
+
+void TriangleBvh::occluded(const BvhRay* rays, uint8_t* blocked, size_t count) const {
+  for(size_t i=0; i<count; ++i) {
+    const RayInfo r    = makeRayInfo(rays[i]);
+    const float   tMax = rays[i].tMax;
+    bool          any  = false;
+    traverse(nodes,r,0.f,tMax,[&](const Node& n){
+      for(uint32_t k=0; k<n.packs; ++k) {
+        float t, u, v;
+        if(intersectPack(packs[n.start+k],r,tMax,t,u,v)>=0) {
+          any = true;
+          return true;
+          }
+        }
+      return false;
+      });
+    blocked[i] = any ? 1 : 0;
+    }
+  }
+
+static float dot3(const float a[3], const float b[3]) {
+  return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+  }
+
+static void cross3(const float a[3], const float b[3], float out[3]) {
+  out[0] = a[1]*b[2]-a[2]*b[1];
+  out[1] = a[2]*b[0]-a[0]*b[2];
+  out[2] = a[0]*b[1]-a[1]*b[0];
+  }
+
+// First t at which a sphere moving along o+t*d touches a point, FLT_MAX if never
+static float sweepPoint(const float o[3], const float d[3], const float c[3], float r2) {
+  const float m[3] = {o[0]-c[0],o[1]-c[1],o[2]-c[2]};
+  const float cc   = dot3(m,m)-r2;
+  if(cc<=0.f)
+    return 0.f;
+  const float b = dot3(m,d);
+  const float a = dot3(d,d);
+  if(b>=0.f || a==0.f)
+    return FLT_MAX;
+  const float disc = b*b-a*cc;
+  if(disc<0.f)
+    return FLT_MAX;
+  return (-b-std::sqrt(disc))/a;
+  }
+
+// Same for the segment a->b, ignoring its end points (covered by sweepPoint)
+static float sweepEdge(const float o[3], const float d[3], const float a[3], const float b[3], float r2) {
+  const float ab[3] = {b[0]-a[0],b[1]-a[1],b[2]-a[2]};
+  const float ao[3] = {o[0]-a[0],o[1]-a[1],o[2]-a[2]};
+  const float abab  = dot3(ab,ab);
+  if(abab==0.f)
+    return FLT_MAX;
+  const float abao  = dot3(ab,ao);
+  const float abd   = dot3(ab,d);
+  const float A     = abab*dot3(d,d) - abd*abd;
+  const float B     = abab*dot3(ao,d) - abao*abd;
+  const float C     = abab*dot3(ao,ao) - abao*abao - r2*abab;
+  if(C<=0.f) {
+    const float s = abao/abab;
+    return (s>=0.f && s<=1.f) ? 0.f : FLT_MAX;
+    }
+  if(A<=0.f || B>=0.f)
+    return FLT_MAX;
+  const float disc = B*B-A*C;
+  if(disc<0.f)
+    return FLT_MAX;
+  const float t = (-B-std::sqrt(disc))/A;
+  const float s = (abao+t*abd)/abab;
+  return (s>=0.f && s<=1.f) ? t : FLT_MAX;
+  }
+
+static bool insideTriangle(const float p[3], const float v0[3], const float e1[3], const float e2[3]) {
+  const float w[3] = {p[0]-v0[0],p[1]-v0[1],p[2]-v0[2]};
+  const float d00 = dot3(e1,e1), d01 = dot3(e1,e2), d11 = dot3(e2,e2);
+  const float d20 = dot3(w,e1),  d21 = dot3(w,e2);
+  const float den = d00*d11-d01*d01;
+  if(den==0.f)
+    return false;
+  const float v = (d11*d20-d01*d21)/den;
+  const float u = (d00*d21-d01*d20)/den;
+  return v>=0.f && u>=0.f && u+v<=1.f;
+  }
+
+// First t at which the moving sphere touches the triangle, FLT_MAX if never
+static float sweepTriangle(const float o[3], const float d[3], float r, const float v0[3], const float e1[3], const float e2[3]) {
+  const float r2 = r*r;
+  float n[3];
+  cross3(e1,e2,n);
+  const float len = std::sqrt(dot3(n,n));
+  if(len>0.f) {
+    for(int i=0; i<3; ++i)
+      n[i] /= len;
+    const float w[3] = {o[0]-v0[0],o[1]-v0[1],o[2]-v0[2]};
+    const float dist = dot3(w,n);
+    const float dn   = dot3(d,n);
+    if(std::fabs(dist)<=r) {
+      const float p[3] = {o[0]-dist*n[0],o[1]-dist*n[1],o[2]-dist*n[2]};
+      if(insideTriangle(p,v0,e1,e2))
+        return 0.f;
+      }
+    else if(dist*dn<0.f) {
+      const float s = dist>0.f ? r : -r;
+      const float t = (s-dist)/dn;
+      const float p[3] = {o[0]+t*d[0]-s*n[0],o[1]+t*d[1]-s*n[1],o[2]+t*d[2]-s*n[2]};
+      // Touching the face is always the first contact
+      if(insideTriangle(p,v0,e1,e2))
+        return t;
+      }
+    }
+
+  const float v1[3] = {v0[0]+e1[0],v0[1]+e1[1],v0[2]+e1[2]};
+  const float v2[3] = {v0[0]+e2[0],v0[1]+e2[1],v0[2]+e2[2]};
+  float t = std::min(sweepPoint(o,d,v0,r2),std::min(sweepPoint(o,d,v1,r2),sweepPoint(o,d,v2,r2)));
+  t = std::min(t,sweepEdge(o,d,v0,v1,r2));
+  t = std::min(t,sweepEdge(o,d,v1,v2,r2));
+  t = std::min(t,sweepEdge(o,d,v2,v0,r2));
+  return t;
+  }
+
+void TriangleBvh::sweepSphere(const BvhRay* rays, float radius, BvhHit* hits, size_t count) const {
+  for(size_t i=0; i<count; ++i) {
+    const RayInfo r     = makeRayInfo(rays[i]);
+    BvhHit&       hit   = hits[i];
+    float         tBest = rays[i].tMax;
+    hit = BvhHit();
+    traverse(nodes,r,radius,tBest,[&](const Node& n){
+      for(uint32_t k=0; k<n.packs; ++k) {
+        const TriPack& p = packs[n.start+k];
+        for(int j=0; j<4; ++j) {
+          if(p.id[j]==BvhHit::NO_HIT)
+            continue;
+          const float v0[3] = {p.v0[0][j],p.v0[1][j],p.v0[2][j]};
+          const float e1[3] = {p.e1[0][j],p.e1[1][j],p.e1[2][j]};
+          const float e2[3] = {p.e2[0][j],p.e2[1][j],p.e2[2][j]};
+          const float t     = sweepTriangle(r.o,r.d,radius,v0,e1,e2);
+          if(t<tBest) {
+            tBest        = t;
+            hit.t        = t;
+            hit.triangle = p.id[j];
+            hit.material = p.material[j];
+            }
+          }
+        }
+      return false;
+      });
+    }
+  }
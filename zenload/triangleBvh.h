@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+class zCMesh;
+
+/**
+ * @brief Ray for TriangleBvh queries. Hits are reported for origin + t*direction with 0 <= t < tMax,
+ *        so the direction doesn't need to be normalized.
+ */
+struct BvhRay {
+  ZMath::float3 origin;
+  ZMath::float3 direction;
+  float         tMax = 1e30f;
+  };
+
+struct BvhHit {
+  static const uint32_t NO_HIT = uint32_t(-1);
+
+  float    t        = 0.f;
+  uint32_t triangle = NO_HIT;  // Triangle index of the source mesh (index/3)
+  int16_t  material = -1;      // zCMesh material index, or submesh index for PackedMesh
+  float    u = 0.f, v = 0.f;   // Barycentrics of the hit, ray queries only
+
+  bool isHit() const { return triangle!=NO_HIT; }
+  };
+
+/**
+ * @brief Bounding volume hierarchy over static triangles, built with binned SAH.
+ *        Leaves store triangles in packs of four, which are tested against a ray at once
+ *        (SSE where available, plain C++ otherwise). Triangles are double sided.
+ */
+class TriangleBvh {
+  public:
+    /**
+     * @brief Builds from the world mesh. Polygons without a valid material are kept with material -1
+     * @param numThreads Number of threads to build subtrees on, 1 builds on the calling thread
+     */
+    void build(const zCMesh& mesh, size_t numThreads = 1);
+
+    /**
+     * @brief Builds from a packed mesh. The material of a triangle is the index of its submesh
+     */
+    void build(const PackedMesh& mesh, size_t numThreads = 1);
+
+    /**
+     * @brief Builds from an indexed triangle list
+     * @param materials Optional, one entry per triangle
+     */
+    void build(const ZMath::float3* positions, const uint32_t* indices, size_t numTriangles,
+               const int16_t* materials, size_t numThreads = 1);
+
+    /**
+     * @brief Finds the closest hit of each ray
+     */
+    void intersect(const BvhRay* rays, BvhHit* hits, size_t count) const;
+
+    /**
+     * @brief Finds the closest hit along each segment from[i] -> to[i]. BvhHit::t is the fraction of the segment
+     */
+    void intersectSegments(const ZMath::float3* from, const ZMath::float3* to, BvhHit* hits, size_t count) const;
+
+    /**
+     * @brief Any-hit test for line of sight, stops at the first triangle found
+     * @param blocked Receives 1 if the ray hits anything, 0 otherwise
+     */
+    void occluded(const BvhRay* rays, uint8_t* blocked, size_t count) const;
+
+    /**
+     * @brief Moves a sphere along each ray and reports the first contact. BvhHit::t is the sphere center
+     *        parameter at contact, 0 if it already overlaps a triangle at the start
+     */
+    void sweepSphere(const BvhRay* rays, float radius, BvhHit* hits, size_t count) const;
+
+    size_t triangleCount() const { return numTriangles; }
+    size_t nodeCount() const { return nodes.size(); }
+
+    /**
+     * @brief Bounds of all triangles, garbage if empty
+     */
+    void getBoundingBox(ZMath::float3& min, ZMath::float3& max) const;
+
+  private:
+    struct Node {
+      float    bmin[3];
+      uint32_t start;  // First pack for leaves, left child for inner nodes (right child follows)
+      float    bmax[3];
+      uint32_t packs;  // Number of triangle packs, 0 for inner nodes
+      };
+
+    // Four triangles as v0, edge1 = v1-v0, edge2 = v2-v0, component-wise. Unused lanes are degenerate.
+    struct TriPack {
+      float    v0[3][4];
+      float    e1[3][4];
+      float    e2[3][4];
+      uint32_t id[4];
+      int16_t  material[4];
+      };
+
+    std::vector<Node>    nodes;
+    std::vector<TriPack> packs;
+    size_t               numTriangles = 0;
+
+  friend struct BvhBuilder;
+  };
+}  // namespace ZenLoad
@@ -0,0 +1,568 @@
+#include "worldTiles.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include "materialRegistry.h"
+#include "zCMesh.h"
+
+using namespace ZenLoad;
+
+static_assert(sizeof(WorldVertex)==36, "WorldVertex is written to tiles as raw data");
+
+static const uint32_t TILE_INDEX_MAGIC = 0x4954575A;  // "ZWTI"
+static const uint32_t TILE_MAGIC       = 0x4C54575A;  // "ZWTL"
+static const uint32_t TILE_VERSION     = 2;
+
+// Keeps the cell lookup of a grid below 4096*4096 entries, for tiny tile sizes and corrupt indices alike
+static const uint32_t MAX_TILES_PER_AXIS = 4096;
+
+const uint32_t WorldTileGrid::NO_TILE;
+
+namespace
+{
+/**
+ * Triangle source backed by a zCMesh. Vertices are (position, feature) pairs.
+ */
+struct ZCMeshSource {
+  const zCMesh& mesh;
+
+  explicit ZCMeshSource(const zCMesh& mesh):mesh(mesh) {}
+
+  size_t triangleCount() const { return mesh.getIndices().size()/3; }
+
+  const ZMath::float3& position(size_t tri, int k) const {
+    return mesh.getVertices()[mesh.getIndices()[tri*3+k]];
+    }
+
+  uint64_t vertexKey(size_t tri, int k) const {
+    return (uint64_t(mesh.getIndices()[tri*3+k])<<32) | mesh.getFeatureIndices()[tri*3+k];
+    }
+
+  WorldVertex vertex(size_t tri, int k) const {
+    const zTMSH_FeatureChunk& f = mesh.getFeatures()[mesh.getFeatureIndices()[tri*3+k]];
+    WorldVertex v;
+    v.Position = position(tri,k);
+    v.Normal   = f.vertNormal;
+    v.TexCoord = ZMath::float2(f.uv[0],f.uv[1]);
+    v.Color    = f.lightStat;
+    return v;
+    }
+
+  // Material index shifted by one, so that polygons without a material get a group of their own
+  uint32_t group(size_t tri) const {
+    const int16_t m = mesh.getTriangleMaterialIndices()[tri];
+    return (m<0 || size_t(m)>=mesh.getMaterials().size()) ? 0 : uint32_t(m)+1;
+    }
+
+  MaterialId material(uint32_t group) const {
+    return group==0 ? MaterialId(MATERIAL_ID_INVALID) : mesh.getMaterials()[group-1];
+    }
+
+  int16_t lightmap(size_t tri) const {
+    auto& lm = mesh.getTriangleLightmapIndices();
+    return tri<lm.size() ? lm[tri] : int16_t(-1);
+    }
+
+  const WorldTriangle* triangle(size_t) const { return nullptr; }
+  bool isUsingAlphaTest() const { return false; }
+  };
+
+/**
+ * Triangle source backed by a PackedMesh. Groups are the submeshes of the mesh.
+ */
+struct PackedMeshSource {
+  const PackedMesh&     mesh;
+  std::vector<uint32_t> submeshOf;
+  std::vector<uint32_t> localTri;
+
+  explicit PackedMeshSource(const PackedMesh& mesh):mesh(mesh) {
+    submeshOf.assign(mesh.indices.size()/3,0);
+    localTri .assign(mesh.indices.size()/3,0);
+    for(size_t s=0; s<mesh.subMeshes.size(); ++s) {
+      auto& sm = mesh.subMeshes[s];
+      for(size_t i=0; i<sm.indexSize/3; ++i) {
+        submeshOf[sm.indexOffset/3+i] = uint32_t(s);
+        localTri [sm.indexOffset/3+i] = uint32_t(i);
+        }
+      }
+    }
+
+  size_t triangleCount() const { return mesh.indices.size()/3; }
+
+  const ZMath::float3& position(size_t tri, int k) const {
+    return mesh.vertices[mesh.indices[tri*3+k]].Position;
+    }
+
+  uint64_t vertexKey(size_t tri, int k) const { return mesh.indices[tri*3+k]; }
+
+  WorldVertex vertex(size_t tri, int k) const { return mesh.vertices[mesh.indices[tri*3+k]]; }
+
+  uint32_t group(size_t tri) const { return submeshOf[tri]; }
+
+  MaterialId material(uint32_t group) const {
+    return group<mesh.subMeshes.size() ? mesh.subMeshes[group].materialId : MaterialId(MATERIAL_ID_INVALID);
+    }
+
+  int16_t lightmap(size_t tri) const {
+    if(mesh.subMeshes.empty())
+      return -1;
+    auto& lm = mesh.subMeshes[submeshOf[tri]].triangleLightmapIndices;
+    return localTri[tri]<lm.size() ? lm[localTri[tri]] : int16_t(-1);
+    }
+
+  const WorldTriangle* triangle(size_t tri) const {
+    return tri<mesh.triangles.size() ? &mesh.triangles[tri] : nullptr;
+    }
+
+  bool isUsingAlphaTest() const { return mesh.isUsingAlphaTest; }
+  };
+
+class Writer {
+  public:
+    explicit Writer(std::vector<uint8_t>& out):out(out) {}
+
+    template<class T>
+    void pod(const T& v) { raw(&v,sizeof(T)); }
+
+    void raw(const void* data, size_t size) {
+      const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+      out.insert(out.end(),p,p+size);
+      }
+
+    void str(const std::string& s) {
+      pod(uint32_t(s.size()));
+      raw(s.data(),s.size());
+      }
+
+    void box(const ZMath::float3 b[2]) { pod(b[0]); pod(b[1]); }
+
+  private:
+    std::vector<uint8_t>& out;
+  };
+
+class Reader {
+  public:
+    Reader(const uint8_t* data, size_t size):at(data),end(data+size) {}
+
+    template<class T>
+    bool pod(T& v) { return raw(&v,sizeof(T)); }
+
+    bool raw(void* data, size_t size) {
+      if(size_t(end-at)<size)
+        return false;
+      std::memcpy(data,at,size);
+      at+=size;
+      return true;
+      }
+
+    bool str(std::string& s) {
+      uint32_t size=0;
+      if(!pod(size) || size_t(end-at)<size)
+        return false;
+      s.assign(reinterpret_cast<const char*>(at),size);
+      at+=size;
+      return true;
+      }
+
+    bool box(ZMath::float3 b[2]) { return pod(b[0]) && pod(b[1]); }
+
+    // Guards resize() against bogus counts: every element takes at least minSize bytes
+    bool count(uint32_t& n, size_t minSize) {
+      return pod(n) && size_t(end-at)/minSize>=n;
+      }
+
+  private:
+    const uint8_t* at;
+    const uint8_t* end;
+  };
+}
+
+static void resetBox(ZMath::float3 box[2]) {
+  box[0] = ZMath::float3( FLT_MAX, FLT_MAX, FLT_MAX);
+  box[1] = ZMath::float3(-FLT_MAX,-FLT_MAX,-FLT_MAX);
+  }
+
+static void expandBox(ZMath::float3 box[2], const ZMath::float3& p) {
+  for(int i=0; i<3; ++i) {
+    box[0].v[i] = std::min(box[0].v[i],p.v[i]);
+    box[1].v[i] = std::max(box[1].v[i],p.v[i]);
+    }
+  }
+
+// Appends the given triangles to an empty mesh. Triangles are grouped by material, keeping their original order.
+template<class Source>
+static void packTriangles(const Source& src, uint32_t* tris, size_t count,
+                          std::unordered_map<uint64_t,uint32_t>& vertexMap, PackedMesh& mesh) {
+  uint32_t* begin = tris;
+  uint32_t* end   = tris+count;
+  std::stable_sort(begin,end,[&src](uint32_t a, uint32_t b){ return src.group(a)<src.group(b); });
+
+  mesh.isUsingAlphaTest = src.isUsingAlphaTest();
+  mesh.indices.reserve(count*3);
+  resetBox(mesh.bbox);
+
+  vertexMap.clear();
+  for(auto it=begin; it!=end; ++it) {
+    const uint32_t t     = *it;
+    const uint32_t group = src.group(t);
+    if(it==begin || group!=src.group(*(it-1))) {
+      mesh.subMeshes.emplace_back();
+      mesh.subMeshes.back().materialId  = src.material(group);
+      mesh.subMeshes.back().indexOffset = mesh.indices.size();
+      }
+    PackedMesh::SubMesh& sm = mesh.subMeshes.back();
+
+    for(int k=0; k<3; ++k) {
+      auto ins = vertexMap.emplace(src.vertexKey(t,k),uint32_t(mesh.vertices.size()));
+      if(ins.second) {
+        mesh.vertices.push_back(src.vertex(t,k));
+        expandBox(mesh.bbox,mesh.vertices.back().Position);
+        }
+      mesh.indices.push_back(ins.first->second);
+      }
+    sm.indexSize += 3;
+    sm.triangleLightmapIndices.push_back(src.lightmap(t));
+
+    if(const WorldTriangle* tri = src.triangle(t)) {
+      mesh.triangles.push_back(*tri);
+      mesh.triangles.back().submeshIndex = int16_t(mesh.subMeshes.size()-1);
+      }
+    }
+  }
+
+template<class Source>
+static void buildTiles(const Source& src, float tileSize, WorldTileGrid& out) {
+  const size_t numTris = src.triangleCount();
+
+  out.tiles.clear();
+  out.tileSize = tileSize;
+
+  ZMath::float3 bbox[2];
+  resetBox(bbox);
+  for(size_t t=0; t<numTris; ++t)
+    for(int k=0; k<3; ++k)
+      expandBox(bbox,src.position(t,k));
+  if(numTris==0 || !(tileSize>0.f)) {
+    // A single cell, which stays empty without triangles
+    out.origin = numTris==0 ? ZMath::float3(0,0,0) : bbox[0];
+    out.tilesX = 1;
+    out.tilesZ = 1;
+    out.tileSize = numTris==0 ? tileSize : std::max(bbox[1].x-bbox[0].x,bbox[1].z-bbox[0].z);
+    }
+  else {
+    const float extentX = bbox[1].x-bbox[0].x;
+    const float extentZ = bbox[1].z-bbox[0].z;
+    out.tileSize = std::max(tileSize,std::max(extentX,extentZ)/float(MAX_TILES_PER_AXIS));
+    out.origin = bbox[0];
+    out.tilesX = std::min(MAX_TILES_PER_AXIS,std::max(1u,uint32_t(std::ceil(extentX/out.tileSize))));
+    out.tilesZ = std::min(MAX_TILES_PER_AXIS,std::max(1u,uint32_t(std::ceil(extentZ/out.tileSize))));
+    }
+
+  // Bucket triangles by the cell of their centroid
+  const size_t numCells = size_t(out.tilesX)*out.tilesZ;
+  std::vector<uint32_t> cellOf(numTris);
+  std::vector<uint32_t> cellStart(numCells+1,0);
+  for(size_t t=0; t<numTris; ++t) {
+    ZMath::float3 c(0,0,0);
+    for(int k=0; k<3; ++k) {
+      const ZMath::float3& p = src.position(t,k);
+      c.x += p.x;
+      c.z += p.z;
+      }
+    const float    inv = out.tileSize>0.f ? 1.f/(3.f*out.tileSize) : 0.f;
+    const uint32_t x   = uint32_t(std::max(0.f,std::min(float(out.tilesX-1),(c.x-out.origin.x*3.f)*inv)));
+    const uint32_t z   = uint32_t(std::max(0.f,std::min(float(out.tilesZ-1),(c.z-out.origin.z*3.f)*inv)));
+    cellOf[t] = z*out.tilesX+x;
+    cellStart[cellOf[t]+1]++;
+    }
+  for(size_t i=0; i<numCells; ++i)
+    cellStart[i+1] += cellStart[i];
+
+  std::vector<uint32_t> order(numTris);
+  {
+  std::vector<uint32_t> fill(cellStart.begin(),cellStart.end()-1);
+  for(size_t t=0; t<numTris; ++t)
+    order[fill[cellOf[t]]++] = uint32_t(t);
+  }
+
+  std::unordered_map<uint64_t,uint32_t> vertexMap;
+  for(size_t cell=0; cell<numCells; ++cell) {
+    if(cellStart[cell]==cellStart[cell+1])
+      continue;
+    out.tiles.emplace_back();
+    WorldTile& tile = out.tiles.back();
+    tile.x = uint32_t(cell%out.tilesX);
+    tile.z = uint32_t(cell/out.tilesX);
+    packTriangles(src,&order[cellStart[cell]],cellStart[cell+1]-cellStart[cell],vertexMap,tile.mesh);
+    }
+
+  out.updateCells();
+  }
+
+const WorldTile* WorldTileGrid::tileAt(const ZMath::float3& pos) const {
+  if(tilesX==0 || tilesZ==0 || cells.size()!=size_t(tilesX)*tilesZ || !(tileSize>0.f))
+    return nullptr;
+  const float fx = std::floor((pos.x-origin.x)/tileSize);
+  const float fz = std::floor((pos.z-origin.z)/tileSize);
+  if(fx<0.f || fz<0.f || fx>=float(tilesX) || fz>=float(tilesZ))
+    return nullptr;
+  const uint32_t id = cells[size_t(fz)*tilesX+size_t(fx)];
+  return id==NO_TILE ? nullptr : &tiles[id];
+  }
+
+void WorldTileGrid::tilesInRadius(const ZMath::float3& pos, float radius, std::vector<uint32_t>& out) const {
+  const float r2 = radius*radius;
+  for(size_t i=0; i<tiles.size(); ++i) {
+    const ZMath::float3* b = tiles[i].mesh.bbox;
+    const float dx = std::max(0.f,std::max(b[0].x-pos.x,pos.x-b[1].x));
+    const float dz = std::max(0.f,std::max(b[0].z-pos.z,pos.z-b[1].z));
+    if(dx*dx+dz*dz<=r2)
+      out.push_back(uint32_t(i));
+    }
+  }
+
+void WorldTileGrid::updateCells() {
+  cells.assign(size_t(tilesX)*tilesZ,NO_TILE);
+  for(size_t i=0; i<tiles.size(); ++i) {
+    if(tiles[i].x<tilesX && tiles[i].z<tilesZ)
+      cells[size_t(tiles[i].z)*tilesX+tiles[i].x] = uint32_t(i);
+    }
+  }
+
+void ZenLoad::buildWorldTiles(const zCMesh& mesh, float tileSize, WorldTileGrid& out) {
+  buildTiles(ZCMeshSource(mesh),tileSize,out);
+  }
+
+void ZenLoad::buildWorldTiles(const PackedMesh& mesh, float tileSize, WorldTileGrid& out) {
+  buildTiles(PackedMeshSource(mesh),tileSize,out);
+  }
+
+void ZenLoad::packWorldMesh(const zCMesh& mesh, PackedMesh& out) {
+  const ZCMeshSource src(mesh);
+  std::vector<uint32_t> order(src.triangleCount());
+  for(size_t t=0; t<order.size(); ++t)
+    order[t] = uint32_t(t);
+
+  out.triangles .clear();
+  out.vertices  .clear();
+  out.indices   .clear();
+  out.verticesId.clear();
+  out.subMeshes .clear();
+  std::unordered_map<uint64_t,uint32_t> vertexMap;
+  packTriangles(src,order.data(),order.size(),vertexMap,out);
+  if(order.empty())
+    out.bbox[0] = out.bbox[1] = ZMath::float3(0,0,0);
+  }
+
+void ZenLoad::writeWorldTileIndex(const WorldTileGrid& grid, std::vector<uint8_t>& out) {
+  Writer w(out);
+  w.pod(TILE_INDEX_MAGIC);
+  w.pod(TILE_VERSION);
+  w.pod(grid.origin);
+  w.pod(grid.tileSize);
+  w.pod(grid.tilesX);
+  w.pod(grid.tilesZ);
+  w.pod(uint32_t(grid.tiles.size()));
+  for(auto& t:grid.tiles) {
+    w.pod(t.x);
+    w.pod(t.z);
+    w.box(t.mesh.bbox);
+    }
+  }
+
+bool ZenLoad::readWorldTileIndex(const uint8_t* data, size_t size, WorldTileGrid& grid) {
+  Reader   r(data,size);
+  uint32_t magic=0, version=0, numTiles=0;
+  if(!r.pod(magic) || magic!=TILE_INDEX_MAGIC || !r.pod(version) || version!=TILE_VERSION)
+    return false;
+  if(!r.pod(grid.origin) || !r.pod(grid.tileSize) || !r.pod(grid.tilesX) || !r.pod(grid.tilesZ))
+    return false;
+  if(grid.tilesX==0 || grid.tilesZ==0 || grid.tilesX>MAX_TILES_PER_AXIS || grid.tilesZ>MAX_TILES_PER_AXIS)
+    return false;
+  if(!r.count(numTiles,8+sizeof(ZMath::float3)*2))
+    return false;
+
+  grid.tiles.clear();
+  grid.tiles.resize(numTiles);
+  for(auto& t:grid.tiles) {
+    if(!r.pod(t.x) || !r.pod(t.z) || !r.box(t.mesh.bbox))
+      return false;
+    }
+  grid.updateCells();
+  return true;
+  }
+
+static void writeMaterial(Writer& w, const zCMaterialData& m) {
+  w.str(m.matName);
+  w.pod(m.matGroup);
+  w.pod(m.color);
+  w.pod(m.smoothAngle);
+  w.str(m.texture);
+  w.str(m.texScale);
+  w.pod(m.texAniFPS);
+  w.pod(m.texAniMapMode);
+  w.str(m.texAniMapDir);
+  w.pod(uint8_t(m.noCollDet));
+  w.pod(uint8_t(m.noLighmap));
+  w.pod(m.loadDontCollapse);
+  w.str(m.detailObject);
+  w.pod(m.detailTextureScale);
+  w.pod(m.forceOccluder);
+  w.pod(m.environmentMapping);
+  w.pod(m.environmentalMappingStrength);
+  w.pod(m.waveMode);
+  w.pod(m.waveSpeed);
+  w.pod(m.waveMaxAmplitude);
+  w.pod(m.waveGridSize);
+  w.pod(m.ignoreSun);
+  w.pod(m.alphaFunc);
+  w.pod(m.defaultMapping);
+  }
+
+static bool readMaterial(Reader& r, zCMaterialData& m) {
+  uint8_t noCollDet=0, noLighmap=0;
+  bool ok = r.str(m.matName) && r.pod(m.matGroup) && r.pod(m.color) && r.pod(m.smoothAngle) &&
+            r.str(m.texture) && r.str(m.texScale) && r.pod(m.texAniFPS) && r.pod(m.texAniMapMode) &&
+            r.str(m.texAniMapDir) && r.pod(noCollDet) && r.pod(noLighmap) && r.pod(m.loadDontCollapse) &&
+            r.str(m.detailObject) && r.pod(m.detailTextureScale) && r.pod(m.forceOccluder) &&
+            r.pod(m.environmentMapping) && r.pod(m.environmentalMappingStrength) && r.pod(m.waveMode) &&
+            r.pod(m.waveSpeed) && r.pod(m.waveMaxAmplitude) && r.pod(m.waveGridSize) &&
+            r.pod(m.ignoreSun) && r.pod(m.alphaFunc) && r.pod(m.defaultMapping);
+  m.noCollDet = noCollDet!=0;
+  m.noLighmap = noLighmap!=0;
+  return ok;
+  }
+
+// Bitfield layout is up to the compiler, so flags get a fixed encoding
+static uint32_t encodeFlags(const PolyFlags& f) {
+  return uint32_t(f.portalPoly)          | uint32_t(f.occluder)<<2      | uint32_t(f.sectorPoly)<<3 |
+         uint32_t(f.mustRelight)<<4      | uint32_t(f.portalIndoorOutdoor)<<5 |
+         uint32_t(f.ghostOccluder)<<6    | uint32_t(f.noDynLightNear)<<7 |
+         uint32_t(f.lodFlag)<<8          | uint32_t(f.normalMainAxis)<<9 |
+         uint32_t(f.sectorIndex)<<16;
+  }
+
+static PolyFlags decodeFlags(uint32_t v) {
+  PolyFlags f;
+  f.portalPoly          = (v   )&3;
+  f.occluder            = (v>>2)&1;
+  f.sectorPoly          = (v>>3)&1;
+  f.mustRelight         = (v>>4)&1;
+  f.portalIndoorOutdoor = (v>>5)&1;
+  f.ghostOccluder       = (v>>6)&1;
+  f.noDynLightNear      = (v>>7)&1;
+  f.lodFlag             = (v>>8)&1;
+  f.normalMainAxis      = (v>>9)&3;
+  f.sectorIndex         = uint16_t(v>>16);
+  return f;
+  }
+
+void ZenLoad::writeWorldTile(const WorldTile& tile, std::vector<uint8_t>& out) {
+  const PackedMesh& mesh = tile.mesh;
+
+  Writer w(out);
+  w.pod(TILE_MAGIC);
+  w.pod(TILE_VERSION);
+  w.pod(tile.x);
+  w.pod(tile.z);
+  w.box(mesh.bbox);
+  w.pod(uint8_t(mesh.isUsingAlphaTest));
+
+  w.pod(uint32_t(mesh.vertices.size()));
+  w.raw(mesh.vertices.data(),mesh.vertices.size()*sizeof(WorldVertex));
+  w.pod(uint32_t(mesh.indices.size()));
+  w.raw(mesh.indices.data(),mesh.indices.size()*sizeof(uint32_t));
+  w.pod(uint32_t(mesh.verticesId.size()));
+  w.raw(mesh.verticesId.data(),mesh.verticesId.size()*sizeof(uint32_t));
+
+  w.pod(uint32_t(mesh.subMeshes.size()));
+  for(auto& sm:mesh.subMeshes) {
+    // Ids are only valid within the process, so the material itself is stored
+    w.pod(uint8_t(sm.materialId!=MATERIAL_ID_INVALID));
+    if(sm.materialId!=MATERIAL_ID_INVALID)
+      writeMaterial(w,MaterialRegistry::global().get(sm.materialId));
+    w.pod(uint32_t(sm.indexOffset));
+    w.pod(uint32_t(sm.indexSize));
+    w.pod(uint32_t(sm.triangleLightmapIndices.size()));
+    w.raw(sm.triangleLightmapIndices.data(),sm.triangleLightmapIndices.size()*sizeof(int16_t));
+    }
+
+  w.pod(uint32_t(mesh.triangles.size()));
+  for(auto& t:mesh.triangles) {
+    w.pod(encodeFlags(t.flags));
+    w.pod(t.lightmapIndex);
+    w.pod(t.submeshIndex);
+    w.raw(t.vertices,sizeof(t.vertices));
+    }
+  }
+
+bool ZenLoad::readWorldTile(const uint8_t* data, size_t size, WorldTile& tile) {
+  PackedMesh& mesh = tile.mesh;
+  Reader      r(data,size);
+  uint32_t    magic=0, version=0, n=0;
+  uint8_t     alphaTest=0;
+
+  if(!r.pod(magic) || magic!=TILE_MAGIC || !r.pod(version) || version!=TILE_VERSION)
+    return false;
+  if(!r.pod(tile.x) || !r.pod(tile.z) || !r.box(mesh.bbox) || !r.pod(alphaTest))
+    return false;
+  mesh.isUsingAlphaTest = alphaTest!=0;
+
+  if(!r.count(n,sizeof(WorldVertex)))
+    return false;
+  mesh.vertices.resize(n);
+  r.raw(mesh.vertices.data(),n*sizeof(WorldVertex));
+  if(!r.count(n,sizeof(uint32_t)))
+    return false;
+  mesh.indices.resize(n);
+  r.raw(mesh.indices.data(),n*sizeof(uint32_t));
+  if(!r.count(n,sizeof(uint32_t)))
+    return false;
+  mesh.verticesId.resize(n);
+  r.raw(mesh.verticesId.data(),n*sizeof(uint32_t));
+
+  if(!r.count(n,1+3*sizeof(uint32_t)))
+    return false;
+  mesh.subMeshes.clear();
+  mesh.subMeshes.resize(n);
+  for(auto& sm:mesh.subMeshes) {
+    uint32_t offset=0, count=0, numLm=0;
+    uint8_t  hasMaterial=0;
+    if(!r.pod(hasMaterial))
+      return false;
+    if(hasMaterial!=0) {
+      zCMaterialData material;
+      if(!readMaterial(r,material))
+        return false;
+      sm.materialId = MaterialRegistry::global().add(material);
+      }
+    if(!r.pod(offset) || !r.pod(count) || !r.count(numLm,sizeof(int16_t)))
+      return false;
+    sm.indexOffset = offset;
+    sm.indexSize   = count;
+    sm.triangleLightmapIndices.resize(numLm);
+    r.raw(sm.triangleLightmapIndices.data(),numLm*sizeof(int16_t));
+    if(size_t(offset)+count>mesh.indices.size())
+      return false;
+    }
+
+  if(!r.count(n,8+sizeof(WorldTriangle::vertices)))
+    return false;
+  mesh.triangles.resize(n);
+  for(auto& t:mesh.triangles) {
+    uint32_t flags=0;
+    if(!r.pod(flags) || !r.pod(t.lightmapIndex) || !r.pod(t.submeshIndex) || !r.raw(t.vertices,sizeof(t.vertices)))
+      return false;
+    t.flags = decodeFlags(flags);
+    }
+
+  for(uint32_t i:mesh.indices)
+    if(i>=mesh.vertices.size())
+      return false;
+  return true;
+  }
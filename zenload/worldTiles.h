@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "zTypes.h"
+
+namespace ZenLoad
+{
+class zCMesh;
+
+/**
+ * @brief One cell of a WorldTileGrid. The mesh is self-contained: it has its own vertices,
+ *        indices, bbox and per-material submeshes, so tiles can be stored and loaded one by one.
+ */
+struct WorldTile {
+  uint32_t   x = 0;  // Cell along the world x-axis
+  uint32_t   z = 0;  // Cell along the world z-axis
+  PackedMesh mesh;
+  };
+
+/**
+ * @brief Uniform grid over the xz-plane of the world mesh. Every triangle is stored in exactly
+ *        one tile, chosen by its centroid, so tile bboxes may overlap their neighbours slightly.
+ */
+struct WorldTileGrid {
+  ZMath::float3          origin;            // Minimum corner of cell (0,0)
+  float                  tileSize = 0.f;
+  uint32_t               tilesX   = 0;
+  uint32_t               tilesZ   = 0;
+  std::vector<WorldTile> tiles;             // Non-empty tiles only, ordered by z, then x
+  std::vector<uint32_t>  cells;             // tilesX*tilesZ entries, index into tiles or NO_TILE
+
+  static const uint32_t NO_TILE = uint32_t(-1);
+
+  /**
+   * @return Tile of the cell containing the given position, nullptr if the cell is empty
+   */
+  const WorldTile* tileAt(const ZMath::float3& pos) const;
+
+  /**
+   * @brief Collects the indices of all tiles whose bbox is within radius of pos on the xz-plane
+   */
+  void tilesInRadius(const ZMath::float3& pos, float radius, std::vector<uint32_t>& out) const;
+
+  /**
+   * @brief Rebuilds the cell lookup from the tile list
+   */
+  void updateCells();
+  };
+
+/**
+ * @brief Splits the world mesh into tiles of the given size (in world units, along x and z).
+ *        Builds the tile vertices straight from the zCMesh, without a monolithic PackedMesh in between.
+ *        The tile size is raised if needed, so there are at most 4096 tiles along each axis.
+ */
+void buildWorldTiles(const zCMesh& mesh, float tileSize, WorldTileGrid& out);
+
+/**
+ * @brief Splits an already packed mesh into tiles. Triangles are carried over, if present.
+ */
+void buildWorldTiles(const PackedMesh& mesh, float tileSize, WorldTileGrid& out);
+
+/**
+ * @brief Packs the whole mesh like the single tile of buildWorldTiles(mesh,0,grid), but into a mesh
+ *        owned by the caller. The buffers of out are cleared and keep their capacity.
+ */
+void packWorldMesh(const zCMesh& mesh, PackedMesh& out);
+
+/**
+ * @brief Writes the grid layout and the cell and bbox of every tile, but no geometry.
+ *        Enough for deciding which tiles to load.
+ */
+void writeWorldTileIndex(const WorldTileGrid& grid, std::vector<uint8_t>& out);
+
+/**
+ * @brief Reads data written by writeWorldTileIndex. The tile meshes only get their bbox.
+ * @return False if the data is truncated, not a tile index or has more than 4096 tiles along an axis
+ */
+bool readWorldTileIndex(const uint8_t* data, size_t size, WorldTileGrid& grid);
+
+/**
+ * @brief Writes a single tile, including its materials
+ */
+void writeWorldTile(const WorldTile& tile, std::vector<uint8_t>& out);
+
+/**
+ * @brief Reads data written by writeWorldTile
+ * @return False if the data is truncated or not a tile
+ */
+bool readWorldTile(const uint8_t* data, size_t size, WorldTile& tile);
+}  // namespace ZenLoad
@@ -1,5 +1,6 @@
 #include "zCBspTree.h"
 
+#include "materialRegistry.h"
 #include "zCMesh.h"
 
 using namespace ZenLoad;
@@ -65,7 +66,18 @@ zCBspTreeData zCBspTree::readObjectData(ZenLoad::ZenParser& parser, ZenLoad::zCM
           }
           break;
 
-        case CHUNK_BSP_LEAF_LIGHT:
+        case CHUNK_BSP_LEAF_LIGHT: {
+          // One light sampling position per leaf, in the order of leafIndices. There is no count, the
+          // chunk is just the positions.
+          const size_t numLeafs = chunkInfo.length/sizeof(ZMath::float3);
+          info.leafLightPositions.resize(numLeafs);
+          parser.readBinaryRaw(info.leafLightPositions.data(),numLeafs*sizeof(ZMath::float3));
+
+          // The tree comes first, positions without a leaf are of no use. Missing ones fall back to
+          // the leaf center in LeafLightGrid.
+          if(!info.leafIndices.empty() && info.leafLightPositions.size()>info.leafIndices.size())
+            info.leafLightPositions.resize(info.leafIndices.size());
+          }
           break;
 
         case CHUNK_BSP_OUTDOOR_SECTORS: {
@@ -216,7 +228,9 @@ void zCBspTree::loadRec(ZenParser& parser, const BinaryFileInfo& fileInfo, zCBsp
   }
 
 void zCBspTree::connectPortals(zCBspTreeData& info, zCMesh* worldMesh) {
-  for(const zCMaterialData& m : worldMesh->getMaterials()) {
+  auto& materials = worldMesh->getMaterials();
+  for(size_t i=0; i<materials.size(); ++i) {
+    const zCMaterialData& m = MaterialRegistry::global().get(materials[i]);
     if(isMaterialForPortal(m))
       {
       std::string from = extractSourceSectorFromMaterialName(m.matName);
@@ -230,6 +244,7 @@ void zCBspTree::connectPortals(zCBspTreeData& info, zCMesh* worldMesh) {
 
       portal.frontSectorIndex = findSectorIndexByName(info, from);
       portal.backSectorIndex =  findSectorIndexByName(info, to);
+      portal.materialIndex = uint32_t(i);
 
       //LogInfo() << "Portal material: " << m.matName;
       //LogInfo() << " - Source: " << extractSourceSectorFromMaterialName(m.matName);
@@ -248,6 +263,7 @@ void zCBspTree::connectPortals(zCBspTreeData& info, zCMesh* worldMesh) {
 
       portal.frontSectorName = to;
       portal.backSectorName = to;
+      portal.materialIndex = uint32_t(i);
 
       //LogInfo() << "Sector material: " << m.matName;
       //LogInfo() << " - Source: " << extractSourceSectorFromMaterialName(m.matName);
@@ -3,6 +3,8 @@
 #include <map>
 #include <string>
 
+#include "collisionMesh.h"
+#include "materialRegistry.h"
 #include "zCMaterial.h"
 #include "zTypes.h"
 #include "zenParser.h"
@@ -230,8 +232,8 @@ void zCMesh::readObjectData(ZenParser& parser, const std::vector<size_t>& skipPo
                     std::string name = parser.readLine();
                     std::string classname = parser.readLine();
 
-                    // Save into vector
-                    m_Materials.emplace_back(zCMaterial::readObjectData(parser, version));
+                    // Only the id is kept, the material itself is shared through the registry
+                    m_Materials.push_back(MaterialRegistry::global().add(zCMaterial::readObjectData(parser, version)));
                 }
 
                 // Note: There is a bool stored here in the G2-Formats, which says whether to use alphatesting or not
@@ -320,6 +322,7 @@ void zCMesh::readObjectData(ZenParser& parser, const std::vector<size_t>& skipPo
                 // Iterate throuh every poly
                 m_TriangleMaterialIndices.reserve(numPolys);
                 m_TriangleLightmapIndices.reserve(numPolys);
+                m_TriangleFlags.reserve(numPolys);
 
                 m_Indices.reserve(numPolys*3);
                 m_FeatureIndices.reserve(numPolys*3);
@@ -353,6 +356,20 @@ void zCMesh::readObjectData(ZenParser& parser, const std::vector<size_t>& skipPo
                         }
                     }
 
+                    // Keep portals apart, regardless of the skip-list. Their flags aren't reliable in G1, so check the material too.
+                    const bool portalMaterial = p.materialIndex >= 0 && size_t(p.materialIndex) < m_Materials.size() &&
+                                                MaterialRegistry::global().get(m_Materials[p.materialIndex]).matName.compare(0, 2, "P:") == 0;
+                    if (p.flags.portalPoly || p.flags.portalIndoorOutdoor || portalMaterial)
+                    {
+                        m_PortalPolygons.emplace_back();
+                        zCPortalPolygon& portal = m_PortalPolygons.back();
+                        portal.polyIndex = uint32_t(i);
+                        portal.materialIndex = p.materialIndex >= 0 ? uint32_t(p.materialIndex) : uint32_t(-1);
+                        portal.vertices.resize(p.polyNumVertices);
+                        for (int v = 0; v < p.polyNumVertices; v++)
+                            portal.vertices[v] = m_Vertices[p.indices[v].VertexIndex];
+                    }
+
                     if (skipPolys.empty() || (skipPolys[skipListEntry] == i))
                     {
                         // TODO: Store these somewhere else
@@ -365,19 +382,10 @@ void zCMesh::readObjectData(ZenParser& parser, const std::vector<size_t>& skipPo
                                 if (p.polyNumVertices == 3)
                                 {
                                     // Write indices directly to a vector
-                                    WorldVertex vx[3];
                                     for (int v = 0; v < 3; v++)
                                     {
                                         m_Indices.emplace_back(p.indices[v].VertexIndex);
                                         m_FeatureIndices.emplace_back(p.indices[v].FeatIndex);
-
-                                        // Gather vertex information
-                                        vx[v].Position = m_Vertices[p.indices[v].VertexIndex];
-                                        vx[v].Color = m_Features[p.indices[v].FeatIndex].lightStat;
-
-                                        vx[v].TexCoord = ZMath::float2(m_Features[p.indices[v].FeatIndex].uv[0],
-                                                                       m_Features[p.indices[v].FeatIndex].uv[1]);
-                                        vx[v].Normal = m_Features[p.indices[v].FeatIndex].vertNormal;
                                     }
 
                                     // Save material index for the written triangle
@@ -386,12 +394,8 @@ void zCMesh::readObjectData(ZenParser& parser, const std::vector<size_t>& skipPo
                                     // Save lightmap-index
                                     m_TriangleLightmapIndices.push_back(p.lightmapIndex);
 
-                                    WorldTriangle triangle;
-                                    triangle.flags = p.flags;
-                                    memcpy(triangle.vertices, vx, sizeof(vx));
-
-                                    // Save triangle
-                                    // m_Triangles.push_back(triangle);
+                                    // Save flags
+                                    m_TriangleFlags.push_back(p.flags);
                                 }
                                 else
                                 {
@@ -413,23 +417,8 @@ void zCMesh::readObjectData(ZenParser& parser, const std::vector<size_t>& skipPo
                                         // Save lightmap-index
                                         m_TriangleLightmapIndices.push_back(p.lightmapIndex);
 
-                                        WorldTriangle triangle;
-                                        triangle.flags = p.flags;
-                                        uint32_t idx[] = {p.indices[0].VertexIndex, p.indices[i].VertexIndex,
-                                                          p.indices[i + 1].VertexIndex};
-
-                                        // Gather vertex information
-                                        for (int v = 0; v < 3; v++)
-                                        {
-                                            triangle.vertices[v].Position = m_Vertices[idx[v]];
-                                            triangle.vertices[v].Color = m_Features[idx[v]].lightStat;
-                                            triangle.vertices[v].TexCoord = ZMath::float2(m_Features[idx[v]].uv[0],
-                                                                                          m_Features[idx[v]].uv[1]);
-                                            triangle.vertices[v].Normal = m_Features[idx[v]].vertNormal;
-                                        }
-
-                                        // Start filling in the flags
-                                        // m_Triangles.push_back(triangle);
+                                        // Save flags
+                                        m_TriangleFlags.push_back(p.flags);
                                     }
                                 }
                             }
@@ -459,6 +448,22 @@ void zCMesh::readObjectData(ZenParser& parser, const std::vector<size_t>& skipPo
     }
 }
 
+void zCMesh::packCollisionMesh(CollisionMesh& mesh, const CollisionMeshOptions& options) const
+{
+    const size_t numTris = m_Indices.size() / 3;
+    PolyFlags noFlags;
+    memset(&noFlags, 0, sizeof(noFlags));
+
+    std::vector<CollisionMesh::Triangle> triangles(numTris);
+    for (size_t i = 0; i < numTris; i++)
+    {
+        const int16_t material = i < m_TriangleMaterialIndices.size() ? m_TriangleMaterialIndices[i] : -1;
+        triangles[i] = makeCollisionTriangle(i < m_TriangleFlags.size() ? m_TriangleFlags[i] : noFlags, material, m_Materials);
+    }
+
+    buildCollisionMesh(m_Vertices.data(), m_Indices.data(), triangles.data(), numTris, m_Materials, mesh, options);
+}
+
 void zCMesh::skip(ZenParser& parser)
 {
     // Information about a single chunk
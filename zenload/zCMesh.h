@@ -68,9 +68,24 @@ class zCMesh  {
     const std::vector<int16_t>& getTriangleLightmapIndices() const { return m_TriangleLightmapIndices; }
 
     /**
-       * @brief returns the vector of the materials used by this mesh
+      * @brief returns the polygon-flags of every triangle (sector, occluder, ...)
+      */
+    const std::vector<PolyFlags>& getTriangleFlags() const { return m_TriangleFlags; }
+
+    /**
+       * @brief returns the materials used by this mesh, as ids into MaterialRegistry::global()
+       */
+    const std::vector<MaterialId>& getMaterials() const { return m_Materials; }
+
+    /**
+       * @brief Builds a collision-only copy of this mesh: welded positions, indices and per-triangle flags
        */
-    const std::vector<zCMaterialData>& getMaterials() const { return m_Materials; }
+    void packCollisionMesh(CollisionMesh& mesh, const CollisionMeshOptions& options = CollisionMeshOptions()) const;
+
+    /**
+       * @brief returns the portal polygons, which are left out of the triangles
+       */
+    const std::vector<zCPortalPolygon>& getPortalPolygons() const { return m_PortalPolygons; }
 
     /**
        * @brief getter for the boudingboxes
@@ -114,9 +129,19 @@ class zCMesh  {
     std::vector<int16_t> m_TriangleLightmapIndices;
 
     /**
-       * @brief All materials used by this mesh
+       * @brief Flags of the polygon each triangle was created from
+       */
+    std::vector<PolyFlags> m_TriangleFlags;
+
+    /**
+       * @brief All materials used by this mesh, see MaterialRegistry::global()
+       */
+    std::vector<MaterialId> m_Materials;
+
+    /**
+       * @brief Portal polygons, kept apart from the triangles
        */
-    std::vector<zCMaterialData> m_Materials;
+    std::vector<zCPortalPolygon> m_PortalPolygons;
 
     /**
        * @brief Bounding-box of this mesh
@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <cfloat>
 #include <string>
+#include "meshQuantizer.h"
 #include "zCProgMeshProto.h"
 #include "zTypes.h"
 #include "zenParser.h"
@@ -102,8 +103,8 @@ void zCMeshSoftSkin::readObjectData(ZenParser& parser) {
         parser.readBinaryRaw(nodeWedgeNormals.data(), numNodeWedgeNormals * sizeof(zTNodeWedgeNormal));
 
         uint16_t numNodes = parser.readBinaryWord();
-        std::vector<int32_t> nodeList(numNodes);
-        parser.readBinaryRaw(nodeList.data(), numNodes * sizeof(int32_t));
+        m_NodeIndexList.resize(numNodes);
+        parser.readBinaryRaw(m_NodeIndexList.data(), numNodes * sizeof(int32_t));
 
         m_BBoxesByNodes.resize(numNodes);
         for(auto& i:m_BBoxesByNodes)
@@ -205,12 +206,19 @@ void zCMeshSoftSkin::packMesh(PackedSkeletalMesh& mesh) const
       auto& pack = mesh.subMeshes[s];
       pack.indexOffset = iboStart;
       pack.indexSize   = sm.m_TriangleList.size()*3;
-      pack.material    = sm.m_Material;
+      pack.materialId  = sm.m_MaterialId;
       meshVxStart += uint32_t(sm.m_WedgeList.size());
       iboStart    += uint32_t(sm.m_TriangleList.size()*3);
       }
 }
 
+void zCMeshSoftSkin::packMesh(PackedSkeletalMeshCompact& mesh, CompactPositionFormat fmt, MeshQuantizationError* error) const
+{
+    PackedSkeletalMesh full;
+    packMesh(full);
+    quantizeMesh(full, mesh, fmt, error);
+}
+
 void zCMeshSoftSkin::updateBboxTotal()
 {
     m_BBoxTotal[0] = { FLT_MAX,  FLT_MAX,  FLT_MAX};
@@ -24,6 +24,7 @@ namespace ZenLoad
     };
 
     class ZenParser;
+    struct MeshQuantizationError;
     class zCMeshSoftSkin
     {
     public:
@@ -45,6 +46,13 @@ namespace ZenLoad
 		 */
         void packMesh(PackedSkeletalMesh& mesh) const;
 
+        /**
+		 * @brief Creates packed submesh-data with quantized vertices
+		 * @param error Optional output of the largest quantization errors
+		 */
+        void packMesh(PackedSkeletalMeshCompact& mesh, CompactPositionFormat fmt = CompactPositionFormat::Fixed16,
+                      MeshQuantizationError* error = nullptr) const;
+
         /**
 		 * @param min Output of min-part of the AABB surrounding this mesh
 		 * @param max Output of max-part of the AABB surrounding this mesh
@@ -53,6 +61,16 @@ namespace ZenLoad
 
         const uint8_t* getVertexWeightStream() const { return m_VertexWeightStream.data(); }
 
+        /**
+		 * @return Bounding box of every node in getNodeIndexList(), in the space of that node
+		 */
+        const std::vector<oBBox3d>& getNodeBoxes() const { return m_BBoxesByNodes; }
+
+        /**
+		 * @return Model nodes the boxes of getNodeBoxes() belong to
+		 */
+        const std::vector<int32_t>& getNodeIndexList() const { return m_NodeIndexList; }
+
     private:
         void updateBboxTotal();
 
@@ -68,6 +86,7 @@ namespace ZenLoad
 		 */
         std::vector<uint8_t> m_VertexWeightStream;
         std::vector<oBBox3d> m_BBoxesByNodes;
+        std::vector<int32_t> m_NodeIndexList;
         ZMath::float3 m_BBoxTotal[2];
     };
 }  // namespace ZenLoad
@@ -6,9 +6,14 @@
 #include "zTypes.h"
 #include "zenParser.h"
 #include <math.h>
+#include <algorithm>
 #include "utils/logger.h"
 #include "vdfs/fileIndex.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 using namespace ZenLoad;
 
 static const uint16_t MSID_MODELANI = 0xA000;
@@ -69,7 +74,7 @@ void SampleUnpackQuat(const uint16_t* in, ZMath::float4& out)
 /**
 * @brief Loads the animation from the given VDF-Archive
 */
-zCModelAni::zCModelAni(const std::string& fileName, const VDFS::FileIndex& fileIndex, float scale)
+zCModelAni::zCModelAni(const std::string& fileName, const VDFS::FileIndex& fileIndex, float scale, bool keepQuantized)
 {
     m_ModelAniHeader.version = 0;
 
@@ -85,16 +90,7 @@ zCModelAni::zCModelAni(const std::string& fileName, const VDFS::FileIndex& fileI
         // FIXME: There is an internal copy of the data here. Optimize!
         ZenLoad::ZenParser parser(data.data(), data.size());
 
-        readObjectData(parser);
-
-        // Apply scale
-        if (scale != 1.0f)
-        {
-            for (size_t i = 0, end = m_AniSamples.size(); i < end; i++)
-            {
-                m_AniSamples[i].position = m_AniSamples[i].position * scale;
-            }
-        }
+        readObjectData(parser, keepQuantized, scale);
     }
     catch (std::exception& e)
     {
@@ -106,7 +102,7 @@ zCModelAni::zCModelAni(const std::string& fileName, const VDFS::FileIndex& fileI
 /**
 * @brief Reads the mesh-object from the given binary stream
 */
-void zCModelAni::readObjectData(ZenParser& parser)
+void zCModelAni::readObjectData(ZenParser& parser, bool keepQuantized, float scale)
 {
     // Information about the whole file we are reading here
     // BinaryFileInfo fileInfo;
@@ -139,6 +135,8 @@ void zCModelAni::readObjectData(ZenParser& parser)
                 m_ModelAniHeader.fpsRateSource = parser.readBinaryFloat();
                 m_ModelAniHeader.samplePosRangeMin = parser.readBinaryFloat();
                 m_ModelAniHeader.samplePosScaler = parser.readBinaryFloat();
+                m_SamplePosRangeMin = m_ModelAniHeader.samplePosRangeMin;
+                m_SamplePosScaler = m_ModelAniHeader.samplePosScaler;
 
                 parser.readBinaryRaw(m_ModelAniHeader.aniBBox, sizeof(m_ModelAniHeader.aniBBox));
 
@@ -167,14 +165,15 @@ void zCModelAni::readObjectData(ZenParser& parser)
                 parser.readBinaryRaw(m_NodeIndexList.data(), m_NodeIndexList.size() * sizeof(uint32_t));
 
                 uint32_t numSamples = m_ModelAniHeader.numNodes * m_ModelAniHeader.numFrames;
-                m_AniSamples.resize(numSamples);
+                m_PackedSamples.resize(numSamples);
+                parser.readBinaryRaw(m_PackedSamples.data(), numSamples * sizeof(zTMdl_AniSample));
 
-                for (size_t i = 0; i < numSamples; i++)
+                if (!keepQuantized)
                 {
-                    zTMdl_AniSample smp={};
-                    parser.readBinaryRaw(&smp, sizeof(zTMdl_AniSample));
-                    SampleUnpackTrans(smp.position, m_AniSamples[i].position, m_ModelAniHeader.samplePosScaler, m_ModelAniHeader.samplePosRangeMin);
-                    SampleUnpackQuat(smp.rotation, m_AniSamples[i].rotation);
+                    m_AniSamples.resize(numSamples);
+                    unpackSamples(m_PackedSamples.data(), m_AniSamples.data(), numSamples, m_SamplePosScaler, m_SamplePosRangeMin);
+                    m_PackedSamples.clear();
+                    m_PackedSamples.shrink_to_fit();
                 }
             }
             break;
@@ -185,4 +184,101 @@ void zCModelAni::readObjectData(ZenParser& parser)
         if (parser.getSeek() >= parser.getFileSize())
             doneReadingChunks = true;  // No end-tag in here...
     }
+
+    // Apply scale
+    if (scale != 1.0f)
+    {
+        m_SamplePosScaler *= scale;
+        m_SamplePosRangeMin *= scale;
+
+        for (size_t i = 0, end = m_AniSamples.size(); i < end; i++)
+        {
+            m_AniSamples[i].position = m_AniSamples[i].position * scale;
+        }
+    }
+}
+
+void zCModelAni::unpackSample(size_t frame, size_t node, AniSample& out) const
+{
+    const size_t i = frame * m_ModelAniHeader.numNodes + node;
+    if (isQuantized())
+    {
+        SampleUnpackTrans(m_PackedSamples[i].position, out.position, m_SamplePosScaler, m_SamplePosRangeMin);
+        SampleUnpackQuat(m_PackedSamples[i].rotation, out.rotation);
+    }
+    else
+    {
+        out = m_AniSamples[i];
+    }
+}
+
+void zCModelAni::unpackFrame(size_t frame, AniSample* out) const
+{
+    const size_t numNodes = m_ModelAniHeader.numNodes;
+    if (isQuantized())
+        unpackSamples(&m_PackedSamples[frame * numNodes], out, numNodes, m_SamplePosScaler, m_SamplePosRangeMin);
+    else
+        std::copy(&m_AniSamples[frame * numNodes], &m_AniSamples[frame * numNodes] + numNodes, out);
+}
+
+void zCModelAni::unpackSamples(const zTMdl_AniSample* in, AniSample* out, size_t count,
+                               float samplePosScaler, float samplePosRangeMin)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    // Four samples are 24 words: three loads of eight. Rotation and position words alternate every three,
+    // so the per-lane offsets and scales repeat after three float vectors.
+    const __m128i bias[3] = {_mm_setr_epi32(SAMPLE_QUAT_MIDDLE, SAMPLE_QUAT_MIDDLE, SAMPLE_QUAT_MIDDLE, 0),
+                             _mm_setr_epi32(0, 0, SAMPLE_QUAT_MIDDLE, SAMPLE_QUAT_MIDDLE),
+                             _mm_setr_epi32(SAMPLE_QUAT_MIDDLE, 0, 0, 0)};
+    const __m128 scale[3] = {_mm_setr_ps(SAMPLE_QUAT_SCALER, SAMPLE_QUAT_SCALER, SAMPLE_QUAT_SCALER, samplePosScaler),
+                             _mm_setr_ps(samplePosScaler, samplePosScaler, SAMPLE_QUAT_SCALER, SAMPLE_QUAT_SCALER),
+                             _mm_setr_ps(SAMPLE_QUAT_SCALER, samplePosScaler, samplePosScaler, samplePosScaler)};
+    const __m128 offset[3] = {_mm_setr_ps(0, 0, 0, samplePosRangeMin),
+                              _mm_setr_ps(samplePosRangeMin, samplePosRangeMin, 0, 0),
+                              _mm_setr_ps(0, samplePosRangeMin, samplePosRangeMin, samplePosRangeMin)};
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 4 <= count; i += 4)
+    {
+        alignas(16) float v[24];
+        const __m128i* src = reinterpret_cast<const __m128i*>(&in[i]);
+        for (int j = 0; j < 3; j++)
+        {
+            const __m128i words = _mm_loadu_si128(src + j);
+            const int lo = j * 2, hi = j * 2 + 1;
+            const __m128i a = _mm_sub_epi32(_mm_unpacklo_epi16(words, zero), bias[lo % 3]);
+            const __m128i b = _mm_sub_epi32(_mm_unpackhi_epi16(words, zero), bias[hi % 3]);
+            _mm_store_ps(&v[lo * 4], _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(a), scale[lo % 3]), offset[lo % 3]));
+            _mm_store_ps(&v[hi * 4], _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(b), scale[hi % 3]), offset[hi % 3]));
+        }
+
+        // Complete the quaternions of all four samples at once
+        const __m128 x = _mm_setr_ps(v[0], v[6], v[12], v[18]);
+        const __m128 y = _mm_setr_ps(v[1], v[7], v[13], v[19]);
+        const __m128 z = _mm_setr_ps(v[2], v[8], v[14], v[20]);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 len = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        const __m128 over = _mm_cmpgt_ps(len, one);
+        const __m128 norm = _mm_or_ps(_mm_and_ps(over, _mm_div_ps(one, _mm_sqrt_ps(len))), _mm_andnot_ps(over, one));
+        const __m128 w = _mm_andnot_ps(over, _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, len), _mm_setzero_ps())));
+
+        alignas(16) float qx[4], qy[4], qz[4], qw[4];
+        _mm_store_ps(qx, _mm_mul_ps(x, norm));
+        _mm_store_ps(qy, _mm_mul_ps(y, norm));
+        _mm_store_ps(qz, _mm_mul_ps(z, norm));
+        _mm_store_ps(qw, w);
+        for (int j = 0; j < 4; j++)
+        {
+            out[i + j].rotation = ZMath::float4(qx[j], qy[j], qz[j], qw[j]);
+            out[i + j].position = ZMath::float3(v[j * 6 + 3], v[j * 6 + 4], v[j * 6 + 5]);
+        }
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        SampleUnpackTrans(in[i].position, out[i].position, samplePosScaler, samplePosRangeMin);
+        SampleUnpackQuat(in[i].rotation, out[i].rotation);
+    }
 }
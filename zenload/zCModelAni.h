@@ -86,14 +86,16 @@ namespace ZenLoad
 
         /**
         * @brief Loads the mesh from the given VDF-Archive
+        * @param keepQuantized Keep the samples in their 12 byte file format instead of expanding them, see isQuantized()
         */
-        zCModelAni(const std::string& fileName, const VDFS::FileIndex& fileIndex, float scale = 1.0f);
+        zCModelAni(const std::string& fileName, const VDFS::FileIndex& fileIndex, float scale = 1.0f, bool keepQuantized = false);
 
         /**
          * @brief Reads the mesh-object from the given binary stream
          * @param fromZen Whether this mesh is supposed to be read from a zenfile. In this case, information about the binary chunk is also read.
+         * @param scale Scale applied to the sample positions, quantized or not
          */
-        void readObjectData(ZenParser& parser);
+        void readObjectData(ZenParser& parser, bool keepQuantized = false, float scale = 1.0f);
 
         /**
          * @return generic information about this animation
@@ -105,6 +107,58 @@ namespace ZenLoad
          */
         const std::vector<AniSample>& getAniSamples() const { return m_AniSamples; }
 
+        /**
+         * @return Whether the samples were kept quantized. getAniSamples() is empty then, samples are decoded
+         *         on demand through unpackSample() and unpackFrame().
+         */
+        bool isQuantized() const { return !m_PackedSamples.empty(); }
+
+        /**
+         * @return Quantized animation-data, only set if isQuantized(). Access: sampleIdx * numNodes + node
+         */
+        const std::vector<zTMdl_AniSample>& getPackedSamples() const { return m_PackedSamples; }
+
+        /**
+         * @return Number of samples, quantized or not
+         */
+        size_t getNumSamples() const { return isQuantized() ? m_PackedSamples.size() : m_AniSamples.size(); }
+
+        /**
+         * @return Memory used by the samples in bytes
+         */
+        size_t getSampleDataSize() const
+        {
+            return m_PackedSamples.size() * sizeof(zTMdl_AniSample) + m_AniSamples.size() * sizeof(AniSample);
+        }
+
+        /**
+         * @return Position decoding of the quantized samples, with the load-scale applied
+         */
+        float getSamplePosScaler() const { return m_SamplePosScaler; }
+        float getSamplePosRangeMin() const { return m_SamplePosRangeMin; }
+
+        /**
+         * @brief Decodes a single sample. Works on quantized and expanded animations.
+         */
+        void unpackSample(size_t frame, size_t node, AniSample& out) const;
+
+        /**
+         * @brief Decodes the samples of all nodes of one frame
+         * @param out numNodes samples
+         */
+        void unpackFrame(size_t frame, AniSample* out) const;
+
+        /**
+         * @brief Decodes quantized samples
+         */
+        static void unpackSamples(const zTMdl_AniSample* in, AniSample* out, size_t count,
+                                  float samplePosScaler, float samplePosRangeMin);
+
+        /**
+         * @return Events stored with the animation, in file order
+         */
+        const std::vector<zCModelAniEvent>& getAniEvents() const { return m_AniEvents; }
+
         /**
          * @return Indices of the samples to the actual nodes
          */
@@ -128,5 +182,8 @@ namespace ZenLoad
 
         std::vector<uint32_t> m_NodeIndexList;
         std::vector<AniSample> m_AniSamples;
+        std::vector<zTMdl_AniSample> m_PackedSamples;
+        float m_SamplePosScaler = 0;
+        float m_SamplePosRangeMin = 0;
     };
 }  // namespace ZenLoad
@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <cfloat>
 #include <string>
+#include "meshQuantizer.h"
 #include "parserImpl.h"
 #include "zCMeshSoftSkin.h"
 #include "zTypes.h"
@@ -275,6 +276,16 @@ void zCModelMeshLib::packMesh(PackedSkeletalMesh& mesh) const
     mesh.bbox[1].z = std::max(mesh.bbox[1].z, m_BBox[1].z);
 }
 
+/**
+* @brief Creates packed submesh-data with quantized vertices
+*/
+void zCModelMeshLib::packMesh(PackedSkeletalMeshCompact& mesh, CompactPositionFormat fmt, MeshQuantizationError* error) const
+{
+    PackedSkeletalMesh full;
+    packMesh(full);
+    quantizeMesh(full, mesh, fmt, error);
+}
+
 size_t zCModelMeshLib::findNodeIndex(const std::string& nodeName) const
 {
     for (size_t i = 0; i < m_Nodes.size(); i++)
@@ -27,6 +27,7 @@ namespace ZenLoad
     };
 
     class ZenParser;
+    struct MeshQuantizationError;
     class zCModelMeshLib
     {
     public:
@@ -58,6 +59,13 @@ namespace ZenLoad
          */
         void packMesh(PackedSkeletalMesh& mesh) const;
 
+        /**
+         * @brief Creates packed submesh-data with quantized vertices
+         * @param error Optional output of the largest quantization errors
+         */
+        void packMesh(PackedSkeletalMeshCompact& mesh, CompactPositionFormat fmt = CompactPositionFormat::Fixed16,
+                      MeshQuantizationError* error = nullptr) const;
+
         /**
          * @return List of meshes registered in this library
          */
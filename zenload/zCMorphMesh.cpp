@@ -1,4 +1,5 @@
 #include "zCMorphMesh.h"
+#include <algorithm>
 #include <string>
 #include "zCProgMeshProto.h"
 #include "zTypes.h"
@@ -58,9 +59,8 @@ void zCMorphMesh::readObjectData(ZenParser& parser) {
         // Read source-mesh
         m_Mesh.readObjectData(parser);
 
-        // TODO: use these
-        std::vector<ZMath::float3> morphPositions(m_Mesh.getVertices().size());
-        parser.readBinaryRaw(morphPositions.data(), sizeof(ZMath::float3) * morphPositions.size());
+        m_MorphPositions.resize(m_Mesh.getVertices().size());
+        parser.readBinaryRaw(m_MorphPositions.data(), sizeof(ZMath::float3) * m_MorphPositions.size());
         break;
         }
 
@@ -89,6 +89,15 @@ void zCMorphMesh::readObjectData(ZenParser& parser) {
           parser.readBinaryRaw(i.samples.data(),i.numFrames*indexSz*12);
           }
 
+        // Animations are applied to the morph positions by index, drop those pointing past them
+        const size_t numPositions = m_MorphPositions.size();
+        aniList.erase(std::remove_if(aniList.begin(),aniList.end(),[numPositions](const Animation& a) {
+          for(uint32_t v:a.vertexIndex)
+            if(v>=numPositions)
+              return true;
+          return false;
+          }),aniList.end());
+
         parser.setSeek(chunkEnd);
         break;
         }
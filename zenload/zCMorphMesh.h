@@ -46,6 +46,14 @@ class zCMorphMesh {
      */
     const zCProgMeshProto& getMesh() const { return m_Mesh; }
 
+    /**
+     * @return Rest positions the animation samples are added to, one per vertex of getMesh()
+     */
+    const std::vector<ZMath::float3>& getMorphPositions() const { return m_MorphPositions; }
+
+    /**
+     * Animations whose vertexIndex points past getMorphPositions() are dropped while loading
+     */
     std::vector<Animation> aniList;
 
   private:
@@ -53,5 +61,7 @@ class zCMorphMesh {
      * @brief Internal zCProgMeshProto of this soft skin. The soft-skin only displaces the vertices found in the ProgMesh.
      */
     zCProgMeshProto m_Mesh;
+
+    std::vector<ZMath::float3> m_MorphPositions;
   };
 }  // namespace ZenLoad
@@ -1,6 +1,11 @@
 #include "zCProgMeshProto.h"
 #include <algorithm>
+#include <cstring>
 #include <string>
+#include "collisionMesh.h"
+#include "materialRegistry.h"
+#include "meshQuantizer.h"
+#include "progMeshLod.h"
 #include "zCMaterial.h"
 #include "zTypes.h"
 #include "zenParser.h"
@@ -139,8 +144,8 @@ void zCProgMeshProto::readObjectData(ZenParser& parser)
                     std::string name = p2.readLine();
                     std::string classname = p2.readLine();
 
-                    // Save into vector
-                    m_Materials.emplace_back(zCMaterial::readObjectData(p2, version));
+                    // Only the id is kept, the material itself is shared through the registry
+                    m_Materials.push_back(MaterialRegistry::global().add(zCMaterial::readObjectData(p2, version)));
                 }
 
                 parser.setSeek(p2.getSeek() + parser.getSeek());
@@ -177,7 +182,7 @@ void zCProgMeshProto::readObjectData(ZenParser& parser)
                 {
                     auto& d = subMeshOffsets[i];
 
-                    m_SubMeshes[i].m_Material = m_Materials[i];
+                    m_SubMeshes[i].m_MaterialId = m_Materials[i];
                     m_SubMeshes[i].m_TriangleList.resize(d.triangleList.size);
                     m_SubMeshes[i].m_WedgeList.resize(d.wedgeList.size);
                     m_SubMeshes[i].m_ColorList.resize(d.colorList.size);
@@ -303,7 +308,7 @@ void zCProgMeshProto::packMesh(PackedMesh& mesh, bool noVertexId) const {
     const auto& sm   = m_SubMeshes[smI];
     auto&       pack = mesh.subMeshes[smI];
 
-    pack.material = sm.m_Material;
+    pack.materialId = sm.m_MaterialId;
 
     for(size_t i=0; i<sm.m_WedgeList.size(); ++i) {
       const zWedge& wedge = sm.m_WedgeList[i];
@@ -339,3 +344,44 @@ void zCProgMeshProto::packMesh(PackedMesh& mesh, bool noVertexId) const {
     meshVxStart += uint32_t(sm.m_WedgeList.size());
     }
   }
+
+void zCProgMeshProto::packMesh(PackedMeshCompact& mesh, CompactPositionFormat fmt, MeshQuantizationError* error, bool noVertexId) const {
+  PackedMesh full;
+  packMesh(full,noVertexId);
+  quantizeMesh(full,mesh,fmt,error);
+  }
+
+void zCProgMeshProto::packLods(const std::vector<float>& triangleFractions, std::vector<PackedMeshLod>& lods) const {
+  ProgMeshLod lod;
+  lod.build(*this);
+  lod.buildLevels(triangleFractions,lods);
+  }
+
+void zCProgMeshProto::packCollisionMesh(CollisionMesh& mesh, const CollisionMeshOptions& options) const {
+  std::vector<MaterialId> materials(m_SubMeshes.size());
+  size_t numTris = 0;
+  for(size_t i=0; i<m_SubMeshes.size(); ++i) {
+    materials[i] = m_SubMeshes[i].m_MaterialId;
+    numTris += m_SubMeshes[i].m_TriangleList.size();
+    }
+
+  PolyFlags noFlags;
+  std::memset(&noFlags,0,sizeof(noFlags));
+
+  // Index straight into the shared positions, so the wedges of a vertex weld for free
+  std::vector<uint32_t>                indices;
+  std::vector<CollisionMesh::Triangle> triangles;
+  indices  .reserve(numTris*3);
+  triangles.reserve(numTris);
+  for(size_t smI=0; smI<m_SubMeshes.size(); ++smI) {
+    const auto&                   sm = m_SubMeshes[smI];
+    const CollisionMesh::Triangle t  = makeCollisionTriangle(noFlags,int16_t(smI),materials);
+    for(auto& tri:sm.m_TriangleList) {
+      for(int j=0; j<3; ++j)
+        indices.push_back(sm.m_WedgeList[tri.m_Wedges[j]].m_VertexIndex);
+      triangles.push_back(t);
+      }
+    }
+
+  buildCollisionMesh(m_Vertices.data(),indices.data(),triangles.data(),triangles.size(),materials,mesh,options);
+  }
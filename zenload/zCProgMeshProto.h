@@ -11,12 +11,14 @@ namespace VDFS
 namespace ZenLoad
 {
     class ZenParser;
+    struct MeshQuantizationError;
+    struct PackedMeshLod;
     class zCProgMeshProto
     {
     public:
         struct SubMesh
         {
-            zCMaterialData m_Material;
+            MaterialId m_MaterialId = MATERIAL_ID_INVALID;  // See MaterialRegistry::global()
             std::vector<zTriangle> m_TriangleList;
             std::vector<zWedge> m_WedgeList;
             std::vector<float> m_ColorList;
@@ -51,9 +53,9 @@ namespace ZenLoad
         const std::vector<zTMSH_FeatureChunk>& getFeatures() const { return m_Features; }
 
         /**
-		 * @brief returns the vector of the materials used by this mesh
+		 * @brief returns the materials used by this mesh, as ids into MaterialRegistry::global()
 		 */
-        const std::vector<zCMaterialData>& getMaterials() const { return m_Materials; }
+        const std::vector<MaterialId>& getMaterials() const { return m_Materials; }
 
         /**
 		 * @brief getter for the boudingboxes
@@ -80,6 +82,26 @@ namespace ZenLoad
 		*/
         void packMesh(PackedMesh& mesh, bool noVertexId = true) const;
 
+        /**
+		* @brief Creates packed submesh-data with quantized vertices
+		* @param error Optional output of the largest quantization errors
+		*/
+        void packMesh(PackedMeshCompact& mesh, CompactPositionFormat fmt = CompactPositionFormat::Fixed16,
+                      MeshQuantizationError* error = nullptr, bool noVertexId = true) const;
+
+        /**
+		* @brief Creates index buffers for reduced levels of detail from the progressive mesh data,
+		*        one per entry of triangleFractions (1 = full detail). They index the vertices of packMesh.
+		*        Use ProgMeshLod directly to pick levels at runtime.
+		*/
+        void packLods(const std::vector<float>& triangleFractions, std::vector<PackedMeshLod>& lods) const;
+
+        /**
+		* @brief Creates a collision-only copy: welded positions, indices and per-triangle records.
+		*        Materials are the ones of the submeshes.
+		*/
+        void packCollisionMesh(CollisionMesh& mesh, const CollisionMeshOptions& options = CollisionMeshOptions()) const;
+
         /**
 		* @brief Packs vertices only
 		*/
@@ -111,9 +133,9 @@ namespace ZenLoad
         std::vector<SubMesh> m_SubMeshes;
 
         /**
-		* @brief All materials used by this mesh
+		* @brief All materials used by this mesh, see MaterialRegistry::global()
 		*/
-        std::vector<zCMaterialData> m_Materials;
+        std::vector<MaterialId> m_Materials;
 
         /**
 		 * @brief Whether this mesh is using alphatest
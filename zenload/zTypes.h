@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -87,6 +88,9 @@ namespace ZenLoad
     using SectorIndex = uint32_t;
     enum : uint32_t { SECTOR_INDEX_INVALID = uint32_t(-1) };
 
+    using MaterialId = uint32_t;
+    enum : uint32_t { MATERIAL_ID_INVALID = uint32_t(-1) };
+
   /**
 	 * @brief Maximum amount of nodes a skeletal mesh can render
 	 */
@@ -197,7 +201,7 @@ namespace ZenLoad
         float       waveGridSize=0.f;
         uint8_t     ignoreSun=0;
         uint8_t     alphaFunc=0;
-        ZMath::float2 defaultMapping={};
+        ZMath::float2 defaultMapping=ZMath::float2(0,0);
     };
 
     struct zCVisualData : public ParsedZenObject
@@ -540,6 +544,18 @@ namespace ZenLoad
 
       SectorIndex frontSectorIndex=SECTOR_INDEX_INVALID; // Index to zCBspTreeData::sectors. Can be SECTOR_INDEX_INVALID.
       SectorIndex backSectorIndex =SECTOR_INDEX_INVALID;  // Index to zCBspTreeData::sectors. Can be SECTOR_INDEX_INVALID.
+
+      uint32_t materialIndex=uint32_t(-1);  // Material of the worldmesh this portal was created from
+    };
+
+    /**
+     * Portal polygon of the worldmesh. These are not part of the triangles of zCMesh.
+     */
+    struct zCPortalPolygon
+    {
+      uint32_t                   polyIndex=0;      // Index of the polygon inside the worldmesh, as in zCBspTreeData::portalPolyIndices
+      uint32_t                   materialIndex=uint32_t(-1);  // Material of the worldmesh, as in zCPortal::materialIndex
+      std::vector<ZMath::float3> vertices;
     };
 
     /**
@@ -594,6 +610,11 @@ namespace ZenLoad
         std::vector<uint32_t>  treePolyIndices;
         std::vector<uint32_t>  portalPolyIndices;
 
+        /**
+         * Position the static light of every leaf is sampled at, in the order of leafIndices
+         */
+        std::vector<ZMath::float3> leafLightPositions;
+
         std::vector<zCSector>  sectors;
         std::vector<zCPortal>  portals;
     };
@@ -840,17 +861,27 @@ namespace ZenLoad
 
         ZMath::float4 interpolateLighting(const ZMath::float3& position) const
         {
-            /*float u,v,w;
-			ZMath::barycentric(position, vertices[0].Position, vertices[1].Position, vertices[2].Position, u, v, w);
-
-			ZMath::float4 c[3];
-			c[0].fromABGR8(vertices[0].Color);
-			c[1].fromABGR8(vertices[1].Color);
-			c[2].fromABGR8(vertices[2].Color);
-
-			return u * c[0] + v * c[1] + w * c[2];*/
-
-            return ZMath::float4(1, 1, 1, 1);  // TODO: Implementation missing without GLM
+            float u, v, w;
+            ZMath::barycentric(position, vertices[0].Position, vertices[1].Position, vertices[2].Position, u, v, w);
+
+            // Keep positions slightly outside of the triangle from extrapolating the colors
+            u = std::max(0.0f, u);
+            v = std::max(0.0f, v);
+            w = std::max(0.0f, w);
+            const float sum = u + v + w;
+            u /= sum;
+            v /= sum;
+            w /= sum;
+
+            ZMath::float4 c[3];
+            c[0].fromABGR8(vertices[0].Color);
+            c[1].fromABGR8(vertices[1].Color);
+            c[2].fromABGR8(vertices[2].Color);
+
+            return ZMath::float4(u * c[0].x + v * c[1].x + w * c[2].x,
+                                 u * c[0].y + v * c[1].y + w * c[2].y,
+                                 u * c[0].z + v * c[1].z + w * c[2].z,
+                                 u * c[0].w + v * c[1].w + w * c[2].w);
         }
 
         /**
@@ -882,7 +913,7 @@ namespace ZenLoad
     {
         struct SubMesh
         {
-            zCMaterialData        material;
+            MaterialId            materialId  = MATERIAL_ID_INVALID;  // See MaterialRegistry::global()
             size_t                indexOffset = 0;
             size_t                indexSize   = 0;
             std::vector<int16_t>  triangleLightmapIndices;  // Index values to the texture found in zCMesh
@@ -901,7 +932,7 @@ namespace ZenLoad
     {
         struct SubMesh
         {
-            zCMaterialData material;
+            MaterialId     materialId  = MATERIAL_ID_INVALID;  // See MaterialRegistry::global()
             size_t         indexOffset = 0;
             size_t         indexSize   = 0;
         };
@@ -912,6 +943,109 @@ namespace ZenLoad
         std::vector<SubMesh>        subMeshes;
     };
 
+    /**
+     * @brief Storage of positions in the compact packed meshes
+     */
+    enum class CompactPositionFormat : uint8_t
+    {
+        Fixed16,  // 16-bit unorm, relative to the quantization box
+        Half,     // 16-bit float, relative to the center of the quantization box
+    };
+
+    /**
+     * @brief 16 byte version of WorldVertex. See meshQuantizer.h for encoding and decoding.
+     */
+    struct WorldVertexCompact
+    {
+        uint16_t Position[3];  // See CompactPositionFormat
+        int8_t   Normal[2];    // Octahedral encoded, snorm8
+        uint16_t TexCoord[2];  // Half-floats
+        uint32_t Color;
+    };
+
+    /**
+     * @brief 44 byte version of SkeletalVertex. See meshQuantizer.h for encoding and decoding.
+     */
+    struct SkeletalVertexCompact
+    {
+        uint32_t      Color;
+        uint16_t      LocalPositions[4][3];  // See CompactPositionFormat
+        uint16_t      TexCoord[2];           // Half-floats
+        int8_t        Normal[2];             // Octahedral encoded, snorm8
+        unsigned char BoneIndices[4];
+        uint8_t       Weights[4];            // unorm8, normalized to a sum of 255
+    };
+
+    /**
+     * @brief PackedMesh with quantized vertices
+     */
+    struct PackedMeshCompact
+    {
+        using SubMesh = PackedMesh::SubMesh;
+
+        std::vector<WorldVertexCompact> vertices;
+        std::vector<uint32_t>           indices;
+        std::vector<uint32_t>           verticesId;  // only for morph meshes
+        std::vector<SubMesh>            subMeshes;
+        ZMath::float3                   bbox[2];
+        ZMath::float3                   quantBox[2];  // Range the positions are quantized to
+        CompactPositionFormat           positionFormat = CompactPositionFormat::Fixed16;
+        bool                            isUsingAlphaTest = false;
+    };
+
+    /**
+     * @brief PackedSkeletalMesh with quantized vertices
+     */
+    struct PackedSkeletalMeshCompact
+    {
+        using SubMesh = PackedSkeletalMesh::SubMesh;
+
+        ZMath::float3                      bbox[2];
+        ZMath::float3                      quantBox[2];  // Range the node-local positions are quantized to
+        CompactPositionFormat              positionFormat = CompactPositionFormat::Fixed16;
+        std::vector<SkeletalVertexCompact> vertices;
+        std::vector<uint32_t>              indices;
+        std::vector<SubMesh>               subMeshes;
+    };
+
+    /**
+     * @brief Geometry for physics and collision queries only: welded positions, indices and
+     *        a small record per triangle instead of full vertices
+     */
+    struct CollisionMesh
+    {
+        enum TriangleFlag : uint8_t
+        {
+            TF_SECTOR_POLY      = 1 << 0,  // PolyFlags::sectorPoly, inside of a sector (indoors)
+            TF_OCCLUDER         = 1 << 1,  // PolyFlags::occluder
+            TF_NO_DYN_LIGHT     = 1 << 2,  // PolyFlags::noDynLightNear
+            TF_NO_COLLISION     = 1 << 3,  // Material has noCollDet set
+            TF_LOD              = 1 << 4,  // PolyFlags::lodFlag
+        };
+
+        struct Triangle
+        {
+            uint16_t material    = 0;  // Index into materials
+            uint16_t sectorIndex = 0;  // PolyFlags::sectorIndex
+            uint8_t  matGroup    = 0;  // zCMaterialData::matGroup, the surface type
+            uint8_t  flags       = 0;  // TriangleFlag bits
+            uint16_t reserved    = 0;
+        };
+
+        std::vector<ZMath::float3> vertices;
+        std::vector<uint32_t>      indices;
+        std::vector<Triangle>      triangles;  // One per 3 indices
+        std::vector<MaterialId>    materials;  // See MaterialRegistry::global()
+        ZMath::float3              bbox[2];
+    };
+
+    struct CollisionMeshOptions
+    {
+        float weldTolerance      = 0.f;   // Positions closer than this are merged, 0 only merges equal ones
+        bool  skipNoCollision    = true;  // Leave out triangles with noCollDet materials
+        bool  dropDegenerate     = true;  // Leave out triangles which collapsed while welding
+    };
+
 #pragma pack(push, 4)
 
     struct VobObjectInfo
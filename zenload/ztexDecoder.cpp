@@ -0,0 +1,318 @@
+#include "ztexDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace ZenLoad;
+
+// Output pixels are built as little-endian words: red in the lowest byte, alpha in the highest
+static inline uint32_t rgba(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+  return r | (g<<8) | (b<<16) | (a<<24);
+  }
+
+static inline uint32_t load32(const uint8_t* p) {
+  return uint32_t(p[0]) | (uint32_t(p[1])<<8) | (uint32_t(p[2])<<16) | (uint32_t(p[3])<<24);
+  }
+
+static inline void store32(uint8_t* p, uint32_t v) {
+  p[0] = uint8_t(v);
+  p[1] = uint8_t(v>>8);
+  p[2] = uint8_t(v>>16);
+  p[3] = uint8_t(v>>24);
+  }
+
+// Same sizes as the DDS conversion in ztex2dds.cpp
+static size_t mipBytes(uint32_t format, uint32_t width, uint32_t height, uint32_t level) {
+  const size_t x = std::max<uint32_t>(1,std::max<uint32_t>(1,width) >>std::min<uint32_t>(level,31));
+  const size_t y = std::max<uint32_t>(1,std::max<uint32_t>(1,height)>>std::min<uint32_t>(level,31));
+  switch(format) {
+    case ZTEXFMT_B8G8R8A8:
+    case ZTEXFMT_R8G8B8A8:
+    case ZTEXFMT_A8B8G8R8:
+    case ZTEXFMT_A8R8G8B8:
+      return x*y*4;
+    case ZTEXFMT_B8G8R8:
+    case ZTEXFMT_R8G8B8:
+      return x*y*3;
+    case ZTEXFMT_A4R4G4B4:
+    case ZTEXFMT_A1R5G5B5:
+    case ZTEXFMT_R5G6B5:
+      return x*y*2;
+    case ZTEXFMT_P8:
+      return x*y;
+    case ZTEXFMT_DXT1:
+      return std::max<size_t>(1,x/4)*std::max<size_t>(1,y/4)*8;
+    case ZTEXFMT_DXT2:
+    case ZTEXFMT_DXT3:
+    case ZTEXFMT_DXT4:
+    case ZTEXFMT_DXT5:
+      return std::max<size_t>(1,x/4)*std::max<size_t>(1,y/4)*16;
+    default:
+      return 0;
+    }
+  }
+
+bool ZenLoad::parseZTEX(const uint8_t* data, size_t size, ZTexView& view) {
+  ZTEX_FILE_HEADER header;
+  if(size<sizeof(header))
+    return false;
+  std::memcpy(&header,data,sizeof(header));
+  if(header.Signature!=ZTEX_FILE_SIGNATURE || header.Version!=ZTEX_FILE_VERSION_0 ||
+     header.TexInfo.Format>=ZTEXFMT_COUNT)
+    return false;
+
+  view      = ZTexView();
+  view.info = header.TexInfo;
+  size_t at = sizeof(header);
+  if(view.info.Format==ZTEXFMT_P8) {
+    // Stored as four bytes per entry, the way convertZTEX2DDS reads it
+    if(size-at<ZTEX_PAL_ENTRIES*4)
+      return false;
+    view.palette = data+at;
+    at += ZTEX_PAL_ENTRIES*4;
+    }
+
+  for(uint32_t l=0; l<view.mipCount(); ++l)
+    view.pixelSize += mipBytes(view.info.Format,view.info.Width,view.info.Height,l);
+  if(size-at<view.pixelSize)
+    return false;
+  view.pixels = data+at;
+  return true;
+  }
+
+void ZenLoad::getZTEXMipSize(const ZTexView& view, uint32_t mip, uint32_t& width, uint32_t& height) {
+  mip    = std::min<uint32_t>(mip,31);
+  width  = std::max<uint32_t>(1,std::max<uint32_t>(1,view.info.Width) >>mip);
+  height = std::max<uint32_t>(1,std::max<uint32_t>(1,view.info.Height)>>mip);
+  }
+
+void ZenLoad::makeZTEXPalette(const ZTexView& view, uint32_t out[ZTEX_PAL_ENTRIES]) {
+  for(size_t i=0; i<ZTEX_PAL_ENTRIES; ++i) {
+    const uint8_t* e = view.palette!=nullptr ? view.palette+i*4 : nullptr;
+    out[i] = e!=nullptr ? rgba(e[2],e[1],e[0],0xFF) : rgba(0,0,0,0xFF);
+    }
+  }
+
+// 32 bit formats: R,G,B,A give the source byte of each output channel
+template<int R, int G, int B, int A>
+static void swizzle32(const uint8_t* src, size_t count, uint8_t* out) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i mask = _mm_set1_epi32(0xFF);
+  for(; i+4<=count; i+=4) {
+    const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i*4));
+    const __m128i r  = _mm_and_si128(_mm_srli_epi32(px,R*8),mask);
+    const __m128i g  = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(px,G*8),mask),8);
+    const __m128i b  = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(px,B*8),mask),16);
+    const __m128i a  = _mm_slli_epi32(_mm_srli_epi32(px,A*8),24);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i*4),_mm_or_si128(_mm_or_si128(r,g),_mm_or_si128(b,a)));
+    }
+#endif
+  for(; i<count; ++i) {
+    const uint8_t* p = src+i*4;
+    store32(out+i*4,rgba(p[R],p[G],p[B],p[A]));
+    }
+  }
+
+// 24 bit formats: R,G,B give the source byte of each output channel. SSE2 has no byte shuffle to move
+// three byte pixels into lanes, the plain loop is faster than shifting them out of words.
+template<int R, int G, int B>
+static void swizzle24(const uint8_t* src, size_t count, uint8_t* out) {
+  for(size_t i=0; i<count; ++i) {
+    const uint8_t* p = src+i*3;
+    store32(out+i*4,rgba(p[R],p[G],p[B],0xFF));
+    }
+  }
+
+// Bit replication, so the largest value of every width maps to 255
+static inline uint32_t expand4(uint32_t v) { return (v<<4) | v; }
+static inline uint32_t expand5(uint32_t v) { return (v<<3) | (v>>2); }
+static inline uint32_t expand6(uint32_t v) { return (v<<2) | (v>>4); }
+
+#if defined(__SSE2__)
+static inline __m128i field(__m128i x, int shift, int mask) {
+  return _mm_and_si128(_mm_srl_epi32(x,_mm_cvtsi32_si128(shift)),_mm_set1_epi32(mask));
+  }
+
+static inline __m128i expand(__m128i v, int bits) {
+  return _mm_or_si128(_mm_sll_epi32(v,_mm_cvtsi32_si128(8-bits)),_mm_srl_epi32(v,_mm_cvtsi32_si128(2*bits-8)));
+  }
+
+static inline __m128i rgba(__m128i r, __m128i g, __m128i b, __m128i a) {
+  return _mm_or_si128(_mm_or_si128(r,_mm_slli_epi32(g,8)),_mm_or_si128(_mm_slli_epi32(b,16),_mm_slli_epi32(a,24)));
+  }
+#endif
+
+// 16 bit formats, each with a scalar and a four pixel version
+struct A4R4G4B4 {
+  static uint32_t decode(uint32_t x) {
+    return rgba(expand4((x>>8) & 15),expand4((x>>4) & 15),expand4(x & 15),expand4(x>>12));
+    }
+#if defined(__SSE2__)
+  static __m128i decode(__m128i x) {
+    return rgba(expand(field(x,8,15),4),expand(field(x,4,15),4),expand(field(x,0,15),4),expand(field(x,12,15),4));
+    }
+#endif
+  };
+
+struct A1R5G5B5 {
+  static uint32_t decode(uint32_t x) {
+    return rgba(expand5((x>>10) & 31),expand5((x>>5) & 31),expand5(x & 31),(x>>15) ? 0xFF : 0);
+    }
+#if defined(__SSE2__)
+  static __m128i decode(__m128i x) {
+    const __m128i a = _mm_sub_epi32(_mm_setzero_si128(),field(x,15,1));  // 0 or all bits
+    return rgba(expand(field(x,10,31),5),expand(field(x,5,31),5),expand(field(x,0,31),5),
+                _mm_and_si128(a,_mm_set1_epi32(0xFF)));
+    }
+#endif
+  };
+
+struct R5G6B5 {
+  static uint32_t decode(uint32_t x) {
+    return rgba(expand5(x>>11),expand6((x>>5) & 63),expand5(x & 31),0xFF);
+    }
+#if defined(__SSE2__)
+  static __m128i decode(__m128i x) {
+    return rgba(expand(field(x,11,31),5),expand(field(x,5,63),6),expand(field(x,0,31),5),_mm_set1_epi32(0xFF));
+    }
+#endif
+  };
+
+template<class Format>
+static void decode16(const uint8_t* src, size_t count, uint8_t* out) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  // Eight pixels per step, widened to two vectors of 32 bit lanes
+  const __m128i zero = _mm_setzero_si128();
+  for(; i+8<=count; i+=8) {
+    const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i*2));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i*4),   Format::decode(_mm_unpacklo_epi16(px,zero)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i*4+16),Format::decode(_mm_unpackhi_epi16(px,zero)));
+    }
+#endif
+  for(; i<count; ++i)
+    store32(out+i*4,Format::decode(uint32_t(src[i*2]) | (uint32_t(src[i*2+1])<<8)));
+  }
+
+void ZenLoad::decodeZTEXPixels(ZTEX_FORMAT format, const uint8_t* src, size_t count, const uint32_t* palette,
+                               uint8_t* out) {
+  // Byte order of the formats as given by the DDS masks in ztex2dds.cpp
+  switch(format) {
+    case ZTEXFMT_B8G8R8A8: swizzle32<1,2,3,0>(src,count,out); break;  // A R G B
+    case ZTEXFMT_R8G8B8A8: swizzle32<3,2,1,0>(src,count,out); break;  // A B G R
+    case ZTEXFMT_A8B8G8R8: swizzle32<0,1,2,3>(src,count,out); break;  // R G B A
+    case ZTEXFMT_A8R8G8B8: swizzle32<2,1,0,3>(src,count,out); break;  // B G R A
+    case ZTEXFMT_B8G8R8:   swizzle24<0,1,2>  (src,count,out); break;  // R G B
+    case ZTEXFMT_R8G8B8:   swizzle24<2,1,0>  (src,count,out); break;  // B G R
+    case ZTEXFMT_A4R4G4B4: decode16<A4R4G4B4>(src,count,out); break;
+    case ZTEXFMT_A1R5G5B5: decode16<A1R5G5B5>(src,count,out); break;
+    case ZTEXFMT_R5G6B5:   decode16<R5G6B5>  (src,count,out); break;
+    case ZTEXFMT_P8:
+      // No gathers in SSE2, a table of finished pixels is the fastest lookup
+      for(size_t i=0; i<count; ++i)
+        store32(out+i*4,palette[src[i]]);
+      break;
+    default:
+      break;
+    }
+  }
+
+// Colors of a DXT block. Without opaque, the DXT1 rules apply: c0<=c1 selects three colors and transparent black.
+static void dxtColors(const uint8_t* block, bool opaque, uint32_t out[4]) {
+  const uint32_t c0 = uint32_t(block[0]) | (uint32_t(block[1])<<8);
+  const uint32_t c1 = uint32_t(block[2]) | (uint32_t(block[3])<<8);
+  const uint32_t r0 = expand5(c0>>11), g0 = expand6((c0>>5) & 63), b0 = expand5(c0 & 31);
+  const uint32_t r1 = expand5(c1>>11), g1 = expand6((c1>>5) & 63), b1 = expand5(c1 & 31);
+  out[0] = rgba(r0,g0,b0,0xFF);
+  out[1] = rgba(r1,g1,b1,0xFF);
+  if(opaque || c0>c1) {
+    out[2] = rgba((2*r0+r1)/3,(2*g0+g1)/3,(2*b0+b1)/3,0xFF);
+    out[3] = rgba((r0+2*r1)/3,(g0+2*g1)/3,(b0+2*b1)/3,0xFF);
+    } else {
+    out[2] = rgba((r0+r1)/2,(g0+g1)/2,(b0+b1)/2,0xFF);
+    out[3] = 0;
+    }
+  }
+
+// Decodes a 4x4 block into pixels, row by row
+static void decodeDxtBlock(uint32_t format, const uint8_t* block, uint32_t px[16]) {
+  const uint8_t* color = format==ZTEXFMT_DXT1 ? block : block+8;
+  uint32_t c[4];
+  dxtColors(color,format!=ZTEXFMT_DXT1,c);
+  const uint32_t bits = load32(color+4);
+  for(int i=0; i<16; ++i)
+    px[i] = c[(bits>>(i*2)) & 3];
+
+  if(format==ZTEXFMT_DXT2 || format==ZTEXFMT_DXT3) {
+    for(int i=0; i<16; ++i) {
+      const uint32_t a = (block[i/2]>>((i&1)*4)) & 15;
+      px[i] = (px[i] & 0x00FFFFFF) | (expand4(a)<<24);
+      }
+    }
+  else if(format==ZTEXFMT_DXT4 || format==ZTEXFMT_DXT5) {
+    uint32_t a[8];
+    a[0] = block[0];
+    a[1] = block[1];
+    if(a[0]>a[1]) {
+      for(int i=1; i<7; ++i)
+        a[i+1] = ((7-i)*a[0] + i*a[1])/7;
+      } else {
+      for(int i=1; i<5; ++i)
+        a[i+1] = ((5-i)*a[0] + i*a[1])/5;
+      a[6] = 0;
+      a[7] = 255;
+      }
+    uint64_t idx = 0;
+    for(int i=0; i<6; ++i)
+      idx |= uint64_t(block[2+i])<<(8*i);
+    for(int i=0; i<16; ++i)
+      px[i] = (px[i] & 0x00FFFFFF) | (a[(idx>>(i*3)) & 7]<<24);
+    }
+  }
+
+bool ZenLoad::decodeZTEX(const ZTexView& view, uint32_t mip, std::vector<uint8_t>& out) {
+  const uint32_t format = view.info.Format;
+  if(view.pixels==nullptr || format>=ZTEXFMT_COUNT || mip>=view.mipCount())
+    return false;
+
+  // Levels are stored from the smallest one to the largest
+  size_t offset = 0;
+  for(uint32_t l=view.mipCount()-1; l>mip; --l)
+    offset += mipBytes(format,view.info.Width,view.info.Height,l);
+  const size_t size = mipBytes(format,view.info.Width,view.info.Height,mip);
+  if(offset+size>view.pixelSize)
+    return false;
+  const uint8_t* src = view.pixels+offset;
+
+  uint32_t w = 0, h = 0;
+  getZTEXMipSize(view,mip,w,h);
+
+  if(format<=ZTEXFMT_P8) {
+    out.resize(size_t(w)*h*4);
+    uint32_t palette[ZTEX_PAL_ENTRIES];
+    if(format==ZTEXFMT_P8)
+      makeZTEXPalette(view,palette);
+    decodeZTEXPixels(ZTEX_FORMAT(format),src,size_t(w)*h,palette,out.data());
+    return true;
+    }
+
+  // Block counts follow mipBytes: levels below 4 pixels still have one block, pixels past the last whole
+  // block of odd sizes have no data and stay transparent black
+  out.assign(size_t(w)*h*4,0);
+  const uint32_t blockSize = format==ZTEXFMT_DXT1 ? 8 : 16;
+  const uint32_t bw = std::max<uint32_t>(1,w/4), bh = std::max<uint32_t>(1,h/4);
+  uint32_t px[16];
+  for(uint32_t by=0; by<bh; ++by)
+    for(uint32_t bx=0; bx<bw; ++bx) {
+      decodeDxtBlock(format,src+(size_t(by)*bw+bx)*blockSize,px);
+      for(uint32_t y=0; y<4 && by*4+y<h; ++y)
+        for(uint32_t x=0; x<4 && bx*4+x<w; ++x)
+          store32(&out[(size_t(by*4+y)*w + bx*4+x)*4],px[y*4+x]);
+      }
+  return true;
+  }
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ztex.h"
+
+namespace ZenLoad
+{
+/**
+ * @brief A .TEX file in memory, as located by parseZTEX. Points into the file data.
+ */
+struct ZTexView {
+  ZTEX_INFO      info      = {};
+  const uint8_t* palette   = nullptr;  // ZTEXFMT_P8 only: 256 entries of blue, green, red, unused
+  const uint8_t* pixels    = nullptr;  // All mip levels, the smallest one first
+  size_t         pixelSize = 0;
+
+  uint32_t mipCount() const { return info.MipMaps>0 ? info.MipMaps : 1; }
+  };
+
+/**
+ * @brief Checks the header and locates palette and mip levels
+ */
+bool parseZTEX(const uint8_t* data, size_t size, ZTexView& view);
+
+/**
+ * @brief Size of a mip level in pixels
+ */
+void getZTEXMipSize(const ZTexView& view, uint32_t mip, uint32_t& width, uint32_t& height);
+
+/**
+ * @brief Decodes one mip level to RGBA8, four bytes per pixel with red first, rows top to bottom.
+ *        Premultiplied DXT2 and DXT4 are decoded like DXT3 and DXT5, the colors stay premultiplied.
+ * @return False if the format is unknown or the data is too short
+ */
+bool decodeZTEX(const ZTexView& view, uint32_t mip, std::vector<uint8_t>& out);
+
+/**
+ * @brief Converts a run of uncompressed pixels to RGBA8
+ * @param format Any format up to ZTEXFMT_P8
+ * @param palette For ZTEXFMT_P8: 256 RGBA8 colors, see makeZTEXPalette
+ */
+void decodeZTEXPixels(ZTEX_FORMAT format, const uint8_t* src, size_t count, const uint32_t* palette, uint8_t* out);
+
+/**
+ * @brief Converts the palette of a view to RGBA8 colors for decodeZTEXPixels
+ */
+void makeZTEXPalette(const ZTexView& view, uint32_t out[ZTEX_PAL_ENTRIES]);
+}  // namespace ZenLoad